@@ -11,10 +11,15 @@ for i in *.IR ; do
   fi
   echo $i ;
 
-  # Generate the binary
+  # Generate the binary, one that reports its allocation sites for
+  # the profile_* tests
   pushd ./ ;
   cd ../ ;
-  ./IRc tests/${i} ;
+  if [[ $i == profile_* ]] ; then
+    ALLOCATION_PROFILE=1 ./IRc tests/${i} ;
+  else
+    ./IRc tests/${i} ;
+  fi
   ./a.out &> tests/${i}.out.tmp ;
   cmp tests/${i}.out.tmp tests/${i}.out ;
   if ! test $? -eq 0 ; then
@@ -31,7 +31,7 @@ namespace IR {
     bool runtime = false;
   };
 
-  enum type { array, tuple, integer, code };
+  enum type { array, tuple, integer, code, IRvoid };
 
   struct Type { 
     type dec_type;
@@ -4,14 +4,29 @@
 #include <algorithm>
 
 #include "compiler.h"
+#include "emitter.h"
 
 using namespace std;
 
-int encode(int n) {
+vector<string> IR::caller_save_registers = {
+        "r10", "r11", "r8", "r9", "rax", "rcx", "rdi", "rdx", "rsi"
+};
+
+vector<string> IR::arg_registers = {
+        "rdi", "rsi", "rdx", "rcx", "r8", "r9"
+};
+
+vector<string> IR::callee_save_registers = {
+        "r12", "r13", "r14", "r15", "rbp", "rbx"
+};
+
+int64_t allocation_sites = 0;
+
+static int encode(int n) {
   return (n << 1) + 1;
 };
 
-int decode(int n) {
+static int decode(int n) {
   return (n >> 1) - 1;
 };
 
@@ -55,7 +70,126 @@ int64_t get_dimensionality(shared_ptr<IR::Function> f, string variable_name) {
   return iter->second->type.array_dim;
 };
 
-string write_offset(ofstream &output, shared_ptr<IR::Function> f, shared_ptr<IR::Instruction> i) {
+/*
+ * Appends to fn the L3 instructions the L3 parser would have built
+ * from their source.
+ */
+void assign(L3::Function *fn, string lhs, string rhs) {
+  L3::Assignment *assn = new L3::Assignment();
+  assn->lhs.name = lhs;
+  assn->rhs.name = rhs;
+  fn->instructions.push_back(assn);
+};
+
+void operation(L3::Function *fn, string lhs, string op_lhs, IR::Operator op, string op_rhs) {
+  if (op == IR::lt || op == IR::lte || op == IR::eq || op == IR::gte || op == IR::gt) {
+    L3::Comparison *comparison = new L3::Comparison();
+    comparison->lhs.name = lhs;
+    comparison->comp_lhs.name = op_lhs;
+    comparison->comp_rhs.name = op_rhs;
+    switch (op) {
+      case IR::lt:
+        comparison->comp_op = L3::lt;
+        break;
+      case IR::lte:
+        comparison->comp_op = L3::lte;
+        break;
+      case IR::eq:
+        comparison->comp_op = L3::eq;
+        break;
+      case IR::gte:
+        comparison->comp_op = L3::gte;
+        break;
+      default:
+        comparison->comp_op = L3::gt;
+        break;
+    }
+    fn->instructions.push_back(comparison);
+    return;
+  }
+  L3::Arithmetic *arithmetic = new L3::Arithmetic();
+  arithmetic->lhs.name = lhs;
+  arithmetic->arith_lhs.name = op_lhs;
+  arithmetic->arith_rhs.name = op_rhs;
+  switch (op) {
+    case IR::plus:
+      arithmetic->arith_op = L3::plus;
+      break;
+    case IR::minus:
+      arithmetic->arith_op = L3::minus;
+      break;
+    case IR::times:
+      arithmetic->arith_op = L3::times;
+      break;
+    case IR::l3and:
+      arithmetic->arith_op = L3::l3and;
+      break;
+    case IR::lshift:
+      arithmetic->arith_op = L3::lshift;
+      break;
+    default:
+      arithmetic->arith_op = L3::rshift;
+      break;
+  }
+  fn->instructions.push_back(arithmetic);
+};
+
+void load(L3::Function *fn, string lhs, string address) {
+  L3::Load *load = new L3::Load();
+  load->lhs.name = lhs;
+  load->rhs.name = address;
+  fn->instructions.push_back(load);
+};
+
+void store(L3::Function *fn, string address, string rhs) {
+  L3::Store *store = new L3::Store();
+  store->lhs.name = address;
+  store->rhs.name = rhs;
+  fn->instructions.push_back(store);
+};
+
+/*
+ * A call puts its arguments in the argument registers first, and
+ * assigns its result to lhs unless lhs is empty.
+ */
+void call(L3::Function *fn, string lhs, string callee, vector<string> args) {
+  vector<L3::L3_t> l3_args;
+  for (int arg_i = 0; arg_i < args.size(); arg_i++) {
+    assign(fn, IR::arg_registers[arg_i], args[arg_i]);
+    L3::L3_t arg;
+    arg.name = args[arg_i];
+    l3_args.push_back(arg);
+  }
+  if (lhs.empty()) {
+    L3::Call *call = new L3::Call();
+    call->callee.name = callee;
+    call->args = l3_args;
+    fn->instructions.push_back(call);
+  } else {
+    L3::CallAssign *call = new L3::CallAssign();
+    call->lhs.name = lhs;
+    call->callee.name = callee;
+    call->args = l3_args;
+    fn->instructions.push_back(call);
+  }
+};
+
+void call(L3::Function *fn, string lhs, IR::IR_callee callee, vector<IR::IR_t> args) {
+  if (callee.name[0] == '%')
+    callee.name.erase(0,1);
+  vector<string> arg_names;
+  for (auto arg : args)
+    arg_names.push_back(arg.name);
+  call(fn, lhs, callee.name, arg_names);
+};
+
+void label(L3::Function *fn, string name) {
+  L3::Label *label = new L3::Label();
+  label->label.name = name.substr(1);
+  fn->instructions.push_back(label);
+};
+
+string write_offset(L3::Function *fn, shared_ptr<IR::Function> f, shared_ptr<IR::Instruction> i) {
   int64_t dimensions;
   string arr;
   vector<IR::IR_t> indices;
@@ -86,94 +220,79 @@ string write_offset(ofstream &output, shared_ptr<IR::Function> f, shared_ptr<IR:
   vector<string> dim_vars = get_free_vars("dim", dimensions, f);
 
   for (int i = 1; i < indices.size(); i++) {
-    output << dim_addr << " <- " << arr << " + " << (16 + 8 * i) << endl;
-    output << dim_vars.at(i) << " <- load " << dim_addr << endl;
-    output << dim_vars.at(i) << " <- " << dim_vars.at(i) << " >> 1\n";
+    operation(fn, dim_addr, arr, IR::plus, to_string(16 + 8 * i));
+    load(fn, dim_vars.at(i), dim_addr);
+    operation(fn, dim_vars.at(i), dim_vars.at(i), IR::rshift, "1");
   }
 
-  output << sum << " <- 0\n";
-  output << mult << " <- 1\n";
+  assign(fn, sum, "0");
+  assign(fn, mult, "1");
   reverse(indices.begin(), indices.end());
   for (int i = 0; i < indices.size(); i++) {
     if (i > 0)
-      output << mult << " <- " << mult << " * " << dim_vars.at(i) << endl;
-    output << mix_sum << " <- " << mult << " * " << indices.at(i).name << endl;
-    output << sum << " <- " << sum << " + " << mix_sum << endl;
+      operation(fn, mult, mult, IR::times, dim_vars.at(i));
+    operation(fn, mix_sum, mult, IR::times, indices.at(i).name);
+    operation(fn, sum, sum, IR::plus, mix_sum);
   }
 
-  output << offset << " <- " << sum << " * 8\n";
-  output << offset << " <- " << offset << " + " << (16 + indices.size()*8) << endl;
-  output << addr << " <- " << arr << " + " << offset << endl;
+  operation(fn, offset, sum, IR::times, "8");
+  operation(fn, offset, offset, IR::plus, to_string(16 + indices.size()*8));
+  operation(fn, addr, arr, IR::plus, offset);
   return addr;
 };
 
-void Compiler::Compile(IR::Program p) {
-  ofstream output;
-  output.open("prog.L3");
+/*
+ * When profiling allocations, every new Array/new Tuple passes a
+ * site number of its own to allocate() as a third argument, and
+ * gets a line in prog.sites saying which one it is. Returns
+ * allocate()'s arguments.
+ */
+vector<string> allocate_arguments(Emitter &sites, shared_ptr<IR::Function> f, string size, string description) {
+  if (!sites.is_open()) {
+    return {size, "1"};
+  }
+  allocation_sites++;
+  sites << allocation_sites << " " << f->name << " " << description << "\n";
+  return {size, "1", to_string(allocation_sites)};
+};
 
+L3::Program Compiler::Compile(IR::Program p, bool profile_allocations) {
+  Emitter sites;
+  if (profile_allocations) {
+    sites.open("prog.sites");
+  } else {
+    remove("prog.sites");
+  }
+
+  L3::Program l3;
   for (auto f : p.functions) {
-    // write the function name and its args
-    output << "define " << f->name << "(";
+    // the function name and its args, which it starts by taking out
+    // of the argument registers
+    L3::Function *fn = new L3::Function();
+    fn->name = f->name;
+    l3.functions.push_back(fn);
     for (int var_i = 0; var_i < f->vars.size(); var_i++) {
       add_declaration(f, f->vars[var_i]);
-      output << f->vars[var_i]->var.name;
-      if (var_i < f->vars.size() - 1)
-        output << ", ";
+      L3::L3_t arg;
+      arg.name = f->vars[var_i]->var.name;
+      fn->args.push_back(arg);
+      assign(fn, arg.name, IR::arg_registers[var_i]);
     }
-    output << "){\n";
     for (auto bb : f->blocks) {
-      output << bb->entry_point.name << endl;
+      label(fn, bb->entry_point.name);
       for (auto i : bb->instructions) {
-        // write the instructions one by one!
+        // translate the instructions one by one!
         if (shared_ptr<IR::Assignment> assn = dynamic_pointer_cast<IR::Assignment>(i)) 
         {
-          output << assn->lhs.name << " <- " << assn->rhs.name << endl;
+          assign(fn, assn->lhs.name, assn->rhs.name);
         }
         else if (shared_ptr<IR::Operation> op = dynamic_pointer_cast<IR::Operation>(i))
         {
-          string op_string;
-          switch(op->op) {
-            case IR::plus:
-              op_string = "+";
-              break;
-            case IR::minus:
-              op_string = "-";
-              break;
-            case IR::times:
-              op_string = "*";
-              break;
-            case IR::l3and:
-              op_string = "&";
-              break;
-            case IR::lshift:
-              op_string = "<<";
-              break;
-            case IR::rshift:
-              op_string = ">>";
-              break;
-            case IR::lt:
-              op_string = "<";
-              break;
-            case IR::lte:
-              op_string = "<=";
-              break;
-            case IR::eq:
-              op_string = "=";
-              break;
-            case IR::gt:
-              op_string = ">";
-              break;
-            case IR::gte:
-              op_string = ">=";
-              break;
-            default:
-              break;
-          }
-          output << op->lhs.name << " <- " << op->op_lhs.name << " " << op_string << " " << op->op_rhs.name << endl;
+          operation(fn, op->lhs.name, op->op_lhs.name, op->op, op->op_rhs.name);
         }
         else if (shared_ptr<IR::Return> ret = dynamic_pointer_cast<IR::Return>(i))
         {
-          output << "return" << endl;
+          fn->instructions.push_back(new L3::Return());
         }
         else if (shared_ptr<IR::Declaration> dec = dynamic_pointer_cast<IR::Declaration>(i))
         {
@@ -182,48 +301,40 @@ void Compiler::Compile(IR::Program p) {
         }
         else if (shared_ptr<IR::ReturnValue> retv = dynamic_pointer_cast<IR::ReturnValue>(i))
         {
-          output << "return " << retv->value.name << endl;
+          L3::ReturnValue *ret = new L3::ReturnValue();
+          ret->value.name = retv->value.name;
+          fn->instructions.push_back(ret);
         }
         else if (shared_ptr<IR::Label> label = dynamic_pointer_cast<IR::Label>(i))
         {
-          output << label->label.name << endl;
+          ::label(fn, label->label.name);
         }
         else if (shared_ptr<IR::Branch> branch = dynamic_pointer_cast<IR::Branch>(i))
         {
-          output << "br " << branch->dest.name << endl;
+          L3::Branch *br = new L3::Branch();
+          br->dest.name = branch->dest.name;
+          fn->instructions.push_back(br);
         }
         else if (shared_ptr<IR::CBranch> cbranch = dynamic_pointer_cast<IR::CBranch>(i))
         {
-          output << "br " << cbranch->condition.name << " " << cbranch->then_dest.name << " " << cbranch->else_dest.name << endl;
+          L3::CBranch *br = new L3::CBranch();
+          br->condition.name = cbranch->condition.name;
+          br->then_dest.name = cbranch->then_dest.name;
+          br->else_dest.name = cbranch->else_dest.name;
+          fn->instructions.push_back(br);
         }
         else if (shared_ptr<IR::Call> call = dynamic_pointer_cast<IR::Call>(i))
         {
-          if (call->callee.name[0] == '%')
-            call->callee.name.erase(0,1);
-          output << "call " << call->callee.name << "(";
-          for (int arg_i = 0; arg_i < call->args.size(); arg_i++) {
-            output << call->args[arg_i].name;
-            if (arg_i < call->args.size() - 1)
-              output << ", ";
-          }
-          output << ")\n";
+          ::call(fn, "", call->callee, call->args);
         }
         else if (shared_ptr<IR::CallAssign> call = dynamic_pointer_cast<IR::CallAssign>(i))
         {
-          output << call->lhs.name << " <- ";
-          if (call->callee.name[0] == '%')
-            call->callee.name.erase(0,1);
-          output << "call " << call->callee.name << "(";
-          for (int arg_i = 0; arg_i < call->args.size(); arg_i++) {
-            output << call->args[arg_i].name;
-            if (arg_i < call->args.size() - 1)
-              output << ", ";
-          }
-          output << ")\n";
+          ::call(fn, call->lhs.name, call->callee, call->args);
         }
         else if (shared_ptr<IR::TupleAllocate> alloc = dynamic_pointer_cast<IR::TupleAllocate>(i))
         {
-          output << alloc->lhs.name << " <- call allocate(" << alloc->dimension.name << ", 1)\n";
+          string description = alloc->lhs.name + " <- new Tuple(" + alloc->dimension.name + ")";
+          ::call(fn, alloc->lhs.name, "allocate", allocate_arguments(sites, f, alloc->dimension.name, description));
         }
         else if (shared_ptr<IR::ArrayAllocate> alloc = dynamic_pointer_cast<IR::ArrayAllocate>(i))
         {
@@ -233,35 +344,39 @@ void Compiler::Compile(IR::Program p) {
           // freevar <- dim >> 1
           int dim = 0;
           for (auto dim_var : dim_vars) {
-            output << dim_var << " <- " << alloc->dimensions.at(dim).name << " >> 1\n";
+            operation(fn, dim_var, alloc->dimensions.at(dim).name, IR::rshift, "1");
             dim++;
           }
           // then, v0 <- freevar1 * freevar2
           if (alloc->dimensions.size() == 1)
-            output << v0 << " <- " << dim_vars.at(0) << endl;
+            assign(fn, v0, dim_vars.at(0));
           else {
-            output << v0 << " <- " << dim_vars.at(0) << endl;
+            assign(fn, v0, dim_vars.at(0));
             for (int i = 1; i < dim_vars.size(); i++)
-              output << v0 << " <- " << v0 << " * " << dim_vars[i] << endl;
+              operation(fn, v0, v0, IR::times, dim_vars[i]);
           }
           // v0 <- v0 << 1
-          output << v0 << " <- " << v0 << " << 1\n";
+          operation(fn, v0, v0, IR::lshift, "1");
           // v0 <- v0 +1
-          output << v0 << " <- " << v0 << " + 1\n";
+          operation(fn, v0, v0, IR::plus, "1");
           // v0 <- v0 + \encode(dim.size() + 1)
-          output << v0 << " <- " << v0 << " + " << 1 + encode(alloc->dimensions.size()) << endl;
+          operation(fn, v0, v0, IR::plus, to_string(1 + encode(alloc->dimensions.size())));
           // v0 <- call allocate(v0, 1)
-          output << alloc->lhs.name << " <- call allocate(" << v0 << ", 1)\n";
+          string description = alloc->lhs.name + " <- new Array(";
+          for (int i = 0; i < alloc->dimensions.size(); i++) {
+            description += (i > 0 ? ", " : "") + alloc->dimensions[i].name;
+          }
+          ::call(fn, alloc->lhs.name, "allocate", allocate_arguments(sites, f, v0, description + ")"));
           // vo <- v0 + 8
-          output << v0 << " <- " << alloc->lhs.name << " + 8\n";
+          operation(fn, v0, alloc->lhs.name, IR::plus, "8");
           // store v0 <- \encode(dim.size())
-          output << "store " << v0 << " <- " << encode(alloc->dimensions.size()) << endl;
+          store(fn, v0, to_string(encode(alloc->dimensions.size())));
           // for each dim:
           // v0 <- v0 + 8
           // store v0 <- dim
           for (int i = 0; i < alloc->dimensions.size(); i++) {
-            output << v0 << " <- " << alloc->lhs.name << " + " << ((i + 2) * 8) << endl;
-            output << "store " << v0 << " <- " << alloc->dimensions[i].name << endl;
+            operation(fn, v0, alloc->lhs.name, IR::plus, to_string((i + 2) * 8));
+            store(fn, v0, alloc->dimensions[i].name);
           }
         }
         else if (shared_ptr<IR::IndexWrite> write = dynamic_pointer_cast<IR::IndexWrite>(i))
@@ -270,17 +385,17 @@ void Compiler::Compile(IR::Program p) {
           auto data_struct_iter = f->data_structs.find(write->lhs.name);
           data_type = data_struct_iter->second->type;
           if (data_type.dec_type == IR::array) {
-            string addr = write_offset(output, f, write);
-            output << "store " << addr << " <- " << write->rhs.name << endl;
+            string addr = write_offset(fn, f, write);
+            store(fn, addr, write->rhs.name);
           } else {
             string newVar = get_free_var("newVar", f);
             string index = get_free_var("tupleIndex", f);
-            output << index << " <- " << write->indices.at(0).name << endl;
-            output << index << " <- " << index << " + 1\n";
-            output << index << " <- " << index << " * 8\n";
-            output << newVar << " <- " << index << endl;
-            output << newVar << " <- " << write->lhs.name << " + " << index << endl;
-            output << "store " << newVar << " <- " << write->rhs.name << endl;
+            assign(fn, index, write->indices.at(0).name);
+            operation(fn, index, index, IR::plus, "1");
+            operation(fn, index, index, IR::times, "8");
+            assign(fn, newVar, index);
+            operation(fn, newVar, write->lhs.name, IR::plus, index);
+            store(fn, newVar, write->rhs.name);
           }
         }
         else if (shared_ptr<IR::IndexRead> read = dynamic_pointer_cast<IR::IndexRead>(i))
@@ -289,17 +404,17 @@ void Compiler::Compile(IR::Program p) {
           auto data_struct_iter = f->data_structs.find(read->rhs.name);
           data_type = data_struct_iter->second->type;
           if (data_type.dec_type == IR::array) {
-            string addr = write_offset(output, f, read);
-            output << read->lhs.name << " <- load " << addr << endl;
+            string addr = write_offset(fn, f, read);
+            load(fn, read->lhs.name, addr);
           } else {
             string newVar = get_free_var("newVar", f);
             string index = get_free_var("tupleIndex", f);
-            output << index << " <- " << read->indices.at(0).name << endl;
-            output << index << " <- " << index << " + 1\n";
-            output << index << " <- " << index << " * 8\n";
-            output << newVar << " <- " << index << endl;
-            output << newVar << " <- " << read->rhs.name << " + " << index << endl;
-            output << read->lhs.name << " <- load " << newVar << endl;
+            assign(fn, index, read->indices.at(0).name);
+            operation(fn, index, index, IR::plus, "1");
+            operation(fn, index, index, IR::times, "8");
+            assign(fn, newVar, index);
+            operation(fn, newVar, read->rhs.name, IR::plus, index);
+            load(fn, read->lhs.name, newVar);
           }
         }
         else if (shared_ptr<IR::LengthRead> lr = dynamic_pointer_cast<IR::LengthRead>(i))
@@ -307,14 +422,108 @@ void Compiler::Compile(IR::Program p) {
           string v0 = get_free_var("v0", f);
           string v1 = get_free_var("v1", f);
           string v2 = get_free_var("v2", f);
-          output << v0 << " <- " << lr->index.name << " * 8\n";
-          output << v1 << " <- " << v0 << " + 16\n";
-          output << v2 << " <- " << lr->rhs.name << " + " << v1 << endl;
-          output << lr->lhs.name << " <- load " << v2 << endl;
+          operation(fn, v0, lr->index.name, IR::times, "8");
+          operation(fn, v1, v0, IR::plus, "16");
+          operation(fn, v2, lr->rhs.name, IR::plus, v1);
+          load(fn, lr->lhs.name, v2);
         }
       }
     }
+  }
+  return l3;
+};
+
+string L3_source(L3::Operation op) {
+  switch (op) {
+    case L3::plus:
+      return "+";
+    case L3::minus:
+      return "-";
+    case L3::times:
+      return "*";
+    case L3::l3and:
+      return "&";
+    case L3::lshift:
+      return "<<";
+    case L3::rshift:
+      return ">>";
+  }
+  return "";
+};
+
+string L3_source(L3::Comparator op) {
+  switch (op) {
+    case L3::lt:
+      return "<";
+    case L3::lte:
+      return "<=";
+    case L3::eq:
+      return "=";
+    case L3::gte:
+      return ">=";
+    case L3::gt:
+      return ">";
+  }
+  return "";
+};
+
+string L3_source(string callee, const vector<L3::L3_t> &args) {
+  string source = "call " + callee + "(";
+  for (int arg_i = 0; arg_i < args.size(); arg_i++) {
+    source += args[arg_i].name;
+    if (arg_i < args.size() - 1)
+      source += ", ";
+  }
+  return source + ")";
+};
+
+/*
+ * Writes p out as L3 source. The L3 parser puts the args of
+ * functions and calls in and out of the argument registers itself,
+ * so those assignments are left out.
+ */
+void dump_program(const L3::Program &p, ostream &output) {
+  for (auto fn : p.functions) {
+    output << "define " << fn->name << "(";
+    for (int arg_i = 0; arg_i < fn->args.size(); arg_i++) {
+      output << fn->args[arg_i].name;
+      if (arg_i < fn->args.size() - 1)
+        output << ", ";
+    }
+    output << "){\n";
+    vector<string> lines;
+    for (int i_i = fn->args.size(); i_i < fn->instructions.size(); i_i++) {
+      L3::Instruction *i = fn->instructions[i_i];
+      if (L3::CallAssign *call = dynamic_cast<L3::CallAssign *>(i)) {
+        lines.resize(lines.size() - call->args.size());
+        lines.push_back(call->lhs.name + " <- " + L3_source(call->callee.name, call->args));
+      } else if (L3::Call *call = dynamic_cast<L3::Call *>(i)) {
+        lines.resize(lines.size() - call->args.size());
+        lines.push_back(L3_source(call->callee.name, call->args));
+      } else if (L3::Assignment *assn = dynamic_cast<L3::Assignment *>(i)) {
+        lines.push_back(assn->lhs.name + " <- " + assn->rhs.name);
+      } else if (L3::Arithmetic *arith = dynamic_cast<L3::Arithmetic *>(i)) {
+        lines.push_back(arith->lhs.name + " <- " + arith->arith_lhs.name + " " + L3_source(arith->arith_op) + " " + arith->arith_rhs.name);
+      } else if (L3::Comparison *comp = dynamic_cast<L3::Comparison *>(i)) {
+        lines.push_back(comp->lhs.name + " <- " + comp->comp_lhs.name + " " + L3_source(comp->comp_op) + " " + comp->comp_rhs.name);
+      } else if (L3::Load *load = dynamic_cast<L3::Load *>(i)) {
+        lines.push_back(load->lhs.name + " <- load " + load->rhs.name);
+      } else if (L3::Store *store = dynamic_cast<L3::Store *>(i)) {
+        lines.push_back("store " + store->lhs.name + " <- " + store->rhs.name);
+      } else if (L3::Branch *br = dynamic_cast<L3::Branch *>(i)) {
+        lines.push_back("br " + br->dest.name);
+      } else if (L3::CBranch *br = dynamic_cast<L3::CBranch *>(i)) {
+        lines.push_back("br " + br->condition.name + " " + br->then_dest.name + " " + br->else_dest.name);
+      } else if (L3::Label *label = dynamic_cast<L3::Label *>(i)) {
+        lines.push_back(":" + label->label.name);
+      } else if (L3::ReturnValue *ret = dynamic_cast<L3::ReturnValue *>(i)) {
+        lines.push_back("return " + ret->value.name);
+      } else if (dynamic_cast<L3::Return *>(i)) {
+        lines.push_back("return");
+      }
+    }
+    for (auto line : lines)
+      output << line << "\n";
     output << "}\n";
   }
-  return;
 };
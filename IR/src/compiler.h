@@ -1,5 +1,10 @@
+#include <ostream>
+
 #include "IR.h"
+#include "../../L3/src/L3.h"
 
 namespace Compiler {
-  void Compile(IR::Program p);
+  L3::Program Compile(IR::Program p, bool profile_allocations);
 };
+
+void dump_program(const L3::Program &p, std::ostream &output);
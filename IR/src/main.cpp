@@ -17,22 +17,11 @@
 // my stuff
 #include "parser.h"
 #include "compiler.h"
+#include "emitter.h"
 #include "../../L3/src/L3.h"
 
 using namespace std;
 
-vector<string> IR::caller_save_registers = {
-        "r10", "r11", "r8", "r9", "rax", "rcx", "rdi", "rdx", "rsi"
-};
-
-vector<string> IR::arg_registers = {
-        "rdi", "rsi", "rdx", "rcx", "r8", "r9"
-};
-
-vector<string> IR::callee_save_registers = {
-        "r12", "r13", "r14", "r15", "rbp", "rbx"
-};
-
 int main( int argc, char **argv ){
   bool verbose;
 
@@ -57,8 +46,15 @@ int main( int argc, char **argv ){
 
   // parse program
   IR::Program p = IR::IR_parse_file(argv[optind]);
+  // setting $ALLOCATION_PROFILE (to anything but 0) builds the
+  // program to report what every allocation site allocates
+  char *profile = getenv("ALLOCATION_PROFILE");
+  bool profile_allocations = (profile != NULL && strcmp(profile, "0") != 0);
+
   // compile and dump it to the outfile
-  Compiler::Compile(p);
+  L3::Program compiled = Compiler::Compile(p, profile_allocations);
+  Emitter output("prog.L3");
+  dump_program(compiled, output);
 
   return 0;
 }
@@ -508,86 +508,89 @@ namespace IR {
       entry_point_rule
     > {};
 
-  /////////////
-  //   DATA  //
-  /////////////
-  
-  vector<IR::Function *> parsed_functions;
-  vector<shared_ptr<IR::Variable>> parsed_variables;
-  vector<IR::IR_s> parsed_s_vals;
-  vector<IR::IR_t> parsed_t_vals;
-  vector<IR::IR_t> parsed_indices;
-  vector<IR::IR_u> parsed_u_vals;
-  vector<IR::IR_t> parsed_args;
-  vector<IR::Variable> parsed_vars;
-  vector<shared_ptr<IR::Declaration>> parsed_declarations;
-  IR_callee parsed_callee;
-  vector<std::string> parsed_strings;
-  vector<std::string> parsed_labels;
-  vector<std::string> parsed_char_seqs;
-  int64_t parsed_array_declaration_dimension = -1;
-  Operator parsed_op;
-  Type parsed_type;
-  IR_item parsed_T;
-  IR_t parsed_length_index;
-  IR::Variable parsed_length_rhs;
-  shared_ptr<BasicBlock> parsed_basic_block;
+  /*
+   * What a parse has read but not yet put into the program. Every
+   * parse gets its own, passed to the actions, so several parses
+   * can run at once.
+   */
+  struct ParseState {
+    vector<IR::Function *> parsed_functions;
+    vector<shared_ptr<IR::Variable>> parsed_variables;
+    vector<IR::IR_s> parsed_s_vals;
+    vector<IR::IR_t> parsed_t_vals;
+    vector<IR::IR_t> parsed_indices;
+    vector<IR::IR_u> parsed_u_vals;
+    vector<IR::IR_t> parsed_args;
+    vector<IR::Variable> parsed_vars;
+    vector<shared_ptr<IR::Declaration>> parsed_declarations;
+    IR_callee parsed_callee;
+    vector<std::string> parsed_strings;
+    vector<std::string> parsed_labels;
+    vector<std::string> parsed_char_seqs;
+    int64_t parsed_array_declaration_dimension = -1;
+    Operator parsed_op;
+    Type parsed_type;
+    IR_item parsed_T;
+    IR_t parsed_length_index;
+    IR::Variable parsed_length_rhs;
+    shared_ptr<BasicBlock> parsed_basic_block;
+
+    void add_instruction(IR::Program &p, shared_ptr<IR::Instruction> i) {
+      parsed_basic_block->instructions.push_back(i);
+    };
+
+    void end_block(IR::Program &p) {
+      p.functions.back()->blocks.push_back(parsed_basic_block);
+    };
+
+    void clear_memory() {
+      parsed_variables.clear();
+      parsed_s_vals.clear();
+      parsed_t_vals.clear();
+      parsed_u_vals.clear();
+      parsed_strings.clear();
+      parsed_args.clear();
+      parsed_indices.clear();
+      parsed_array_declaration_dimension = -1;
+      parsed_declarations.clear();
+      parsed_labels.clear();
+    }
+  };
 
   /////////////
   // ACTIONS //
   /////////////
   
-  void add_instruction(IR::Program &p, shared_ptr<IR::Instruction> i) {
-    parsed_basic_block->instructions.push_back(i);
-  };
-
-  void end_block(IR::Program &p) {
-    p.functions.back()->blocks.push_back(parsed_basic_block);
-  };
-  
-  void clear_memory() {
-    parsed_variables.clear();
-    parsed_s_vals.clear();
-    parsed_t_vals.clear();
-    parsed_u_vals.clear();
-    parsed_strings.clear();
-    parsed_args.clear();
-    parsed_indices.clear();
-    parsed_array_declaration_dimension = -1;
-    parsed_declarations.clear();
-    parsed_labels.clear();
-  }
-  
   template< typename Rule >
     struct action : pegtl::nothing< Rule > {};
 
   template<> struct action < IR_instruction_rule >{
-    static void apply( const pegtl::input &in, IR::Program &p){
+    static void apply( const pegtl::input &in, IR::Program &p, ParseState &state){
     }
   };
 
   template<> struct action < IR_char_sequence_rule >{
-    static void apply( const pegtl::input &in, IR::Program &p){
-      parsed_char_seqs.push_back(in.string()); 
+    static void apply( const pegtl::input &in, IR::Program &p, ParseState &state){
+      state.parsed_char_seqs.push_back(in.string()); 
     }
   };
 
   template<> struct action < IR_label_rule >{
-    static void apply( const pegtl::input &in, IR::Program &p){
-      parsed_labels.push_back(in.string()); 
+    static void apply( const pegtl::input &in, IR::Program &p, ParseState &state){
+      state.parsed_labels.push_back(in.string()); 
     }
   };
 
   template<> struct action < IR_var_rule >{
-    static void apply( const pegtl::input &in, IR::Program &p){
+    static void apply( const pegtl::input &in, IR::Program &p, ParseState &state){
       shared_ptr<IR::Variable> var = make_shared<IR::Variable>();
-      var->name = parsed_char_seqs.back();
-      parsed_variables.push_back(var);
+      var->name = state.parsed_char_seqs.back();
+      state.parsed_variables.push_back(var);
     }
   };
 
   template<> struct action < IR_op_rule >{
-    static void apply( const pegtl::input &in, IR::Program &p){
+    static void apply( const pegtl::input &in, IR::Program &p, ParseState &state){
       std::string op = in.string();
       std::string plus ("+");
       std::string minus ("-");
@@ -601,387 +604,406 @@ namespace IR {
       std::string gte (">=");
       std::string gt (">");
       if (op.compare(plus) == 0)
-        parsed_op = IR::plus;
+        state.parsed_op = IR::plus;
       else if (op.compare(minus) == 0)
-        parsed_op = IR::minus;
+        state.parsed_op = IR::minus;
       else if (op.compare(times) == 0)
-        parsed_op = IR::times;
+        state.parsed_op = IR::times;
       else if (op.compare(l3and) == 0)
-        parsed_op = IR::l3and;
+        state.parsed_op = IR::l3and;
       else if (op.compare(lshift) == 0)
-        parsed_op = IR::lshift;
+        state.parsed_op = IR::lshift;
       else if (op.compare(rshift) == 0)
-        parsed_op = IR::rshift;
+        state.parsed_op = IR::rshift;
       else if (op.compare(lt) == 0)
-        parsed_op = IR::lt;
+        state.parsed_op = IR::lt;
       else if (op.compare(lte) == 0)
-        parsed_op = IR::lte;
+        state.parsed_op = IR::lte;
       else if (op.compare(eq) == 0)
-        parsed_op = IR::eq;
+        state.parsed_op = IR::eq;
       else if (op.compare(gte) == 0)
-        parsed_op = IR::gte;
+        state.parsed_op = IR::gte;
       else if (op.compare(gt) == 0)
-        parsed_op = IR::gt;
+        state.parsed_op = IR::gt;
     }
   };
 
   template<> struct action < IR_u_rule >{
-    static void apply( const pegtl::input &in, IR::Program &p){
+    static void apply( const pegtl::input &in, IR::Program &p, ParseState &state){
       IR::IR_u u;
       u.name = in.string();
       if (u.name[0] == '%')
         u.name.erase(0,1);
-      parsed_u_vals.push_back(u);
+      state.parsed_u_vals.push_back(u);
     }
   };
 
   template<> struct action < IR_t_rule >{
-    static void apply( const pegtl::input &in, IR::Program &p){
+    static void apply( const pegtl::input &in, IR::Program &p, ParseState &state){
       IR::IR_t t;
       t.name = in.string();
       if (t.name.at(0) == '%')
         t.name.erase(0,1);
-      parsed_t_vals.push_back(t);
+      state.parsed_t_vals.push_back(t);
     }
   };
 
   template<> struct action < IR_s_rule >{
-    static void apply( const pegtl::input &in, IR::Program &p){
+    static void apply( const pegtl::input &in, IR::Program &p, ParseState &state){
       IR::IR_s s;
       s.name = in.string();
       if (s.name[0] == '%')
         s.name.erase(0,1);
-      parsed_s_vals.push_back(s);
+      state.parsed_s_vals.push_back(s);
     }
   };
 
   template<> struct action < IR_args_rule >{
-    static void apply( const pegtl::input &in, IR::Program &p){
+    static void apply( const pegtl::input &in, IR::Program &p, ParseState &state){
       // args are a property of a function call.
-      parsed_args.insert(
-          parsed_args.end(),
-          parsed_t_vals.begin(),
-          parsed_t_vals.end()
+      state.parsed_args.insert(
+          state.parsed_args.end(),
+          state.parsed_t_vals.begin(),
+          state.parsed_t_vals.end()
       );
     }
   };
 
   template<> struct action < IR_vars_rule >{
-    static void apply( const pegtl::input &in, IR::Program &p){
+    static void apply( const pegtl::input &in, IR::Program &p, ParseState &state){
       // vars are a property of a function itself.
       // TODO
 
-      //clear_memory();
+      //state.clear_memory();
     }
   };
 
   template<> struct action < IR_callee_rule >{
-    static void apply( const pegtl::input &in, IR::Program &p){
+    static void apply( const pegtl::input &in, IR::Program &p, ParseState &state){
       IR::IR_callee callee;
       callee.name = in.string();
-      parsed_callee = callee;
+      state.parsed_callee = callee;
     }
   };
 
   template<> struct action < IR_T_rule >{
-    static void apply( const pegtl::input &in, IR::Program &p){
-      parsed_T.name = in.string();
+    static void apply( const pegtl::input &in, IR::Program &p, ParseState &state){
+      state.parsed_T.name = in.string();
     }
   };
 
   template<> struct action < IR_brackets_rule >{
-    static void apply( const pegtl::input &in, IR::Program &p){
-      parsed_array_declaration_dimension = in.string().size() / 2;
+    static void apply( const pegtl::input &in, IR::Program &p, ParseState &state){
+      state.parsed_array_declaration_dimension = in.string().size() / 2;
     }
   };
 
   template<> struct action < IR_type_rule >{
-    static void apply( const pegtl::input &in, IR::Program &p){
+    static void apply( const pegtl::input &in, IR::Program &p, ParseState &state){
       std::string type = in.string();
       std::string int_type = "int64";
       std::string tuple_type = "tuple";
       std::string code_type = "code";
       if (int_type.compare(type.substr(0, 5)) == 0) {
-        if (parsed_array_declaration_dimension > 0) {
-          parsed_type.dec_type = IR::array;
-          parsed_type.array_dim = parsed_array_declaration_dimension;
+        if (state.parsed_array_declaration_dimension > 0) {
+          state.parsed_type.dec_type = IR::array;
+          state.parsed_type.array_dim = state.parsed_array_declaration_dimension;
         } else {
-          parsed_type.dec_type = IR::integer;
+          state.parsed_type.dec_type = IR::integer;
         }
       } else if (tuple_type.compare(type) == 0) {
-        parsed_type.dec_type = IR::tuple;
+        state.parsed_type.dec_type = IR::tuple;
       } else if (code_type.compare(type) == 0) {
-        parsed_type.dec_type = IR::code;
+        state.parsed_type.dec_type = IR::code;
       }
     }
   };
 
   template<> struct action < IR_declaration_rule >{
-    static void apply( const pegtl::input &in, IR::Program &p){
+    static void apply( const pegtl::input &in, IR::Program &p, ParseState &state){
       shared_ptr<IR::Declaration> dec = make_shared<IR::Declaration>();
-      dec->type = parsed_type;
-      dec->var = *parsed_variables.back();
-      parsed_declarations.push_back(dec);
+      dec->type = state.parsed_type;
+      dec->var = *state.parsed_variables.back();
+      state.parsed_declarations.push_back(dec);
     }
   };
 
   template<> struct action < IR_declarations_rule >{
-    static void apply( const pegtl::input &in, IR::Program &p){
+    static void apply( const pegtl::input &in, IR::Program &p, ParseState &state){
       p.functions.back()->vars.insert(
         p.functions.back()->vars.end(),
-        parsed_declarations.begin(),
-        parsed_declarations.end()
+        state.parsed_declarations.begin(),
+        state.parsed_declarations.end()
       );
-      clear_memory();
+      state.clear_memory();
     }
   };
   
   template<> struct action < IR_declaration_instruction_rule >{
-    static void apply( const pegtl::input &in, IR::Program &p){
+    static void apply( const pegtl::input &in, IR::Program &p, ParseState &state){
       shared_ptr<IR::Declaration> dec = make_shared<IR::Declaration>();
-      dec->type = parsed_type;
-      dec->var = *parsed_variables.at(0);
-      add_instruction(p, dec);
-      clear_memory();
+      dec->type = state.parsed_type;
+      dec->var = *state.parsed_variables.at(0);
+      state.add_instruction(p, dec);
+      state.clear_memory();
     }
   };
 
   template<> struct action < IR_assignment_rule >{
-    static void apply( const pegtl::input &in, IR::Program &p){
-      IR::Variable lhs = *parsed_variables.at(0);
-      IR::IR_s rhs = parsed_s_vals.back();
+    static void apply( const pegtl::input &in, IR::Program &p, ParseState &state){
+      IR::Variable lhs = *state.parsed_variables.at(0);
+      IR::IR_s rhs = state.parsed_s_vals.back();
       shared_ptr<IR::Assignment> assignment = make_shared<IR::Assignment>();
       assignment->lhs = lhs;
       assignment->rhs = rhs;
-      add_instruction(p, assignment);
-      clear_memory();
+      state.add_instruction(p, assignment);
+      state.clear_memory();
     }
   };
 
   template<> struct action < IR_operation_rule >{
-    static void apply( const pegtl::input &in, IR::Program &p){
-      IR::Variable lhs = *parsed_variables.at(0);
+    static void apply( const pegtl::input &in, IR::Program &p, ParseState &state){
+      IR::Variable lhs = *state.parsed_variables.at(0);
       shared_ptr<IR::Operation> operation = make_shared<IR::Operation>();
       operation->lhs = lhs;
-      operation->op_lhs = parsed_t_vals.end()[-2];
-      operation->op_rhs = parsed_t_vals.end()[-1];
-      operation->op = parsed_op;
-      add_instruction(p, operation);
-      clear_memory();
+      operation->op_lhs = state.parsed_t_vals.end()[-2];
+      operation->op_rhs = state.parsed_t_vals.end()[-1];
+      operation->op = state.parsed_op;
+      state.add_instruction(p, operation);
+      state.clear_memory();
     }
   };
 
   template<> struct action < IR_branch_rule >{
-    static void apply( const pegtl::input &in, IR::Program &p){
+    static void apply( const pegtl::input &in, IR::Program &p, ParseState &state){
       shared_ptr<IR::Branch> branch = make_shared<IR::Branch>();
       IR::IR_item dest;
-      dest.name = parsed_labels.back();
+      dest.name = state.parsed_labels.back();
       branch->dest = dest;
-      add_instruction(p, branch);
-      clear_memory();
+      state.add_instruction(p, branch);
+      state.clear_memory();
     }
   };
 
   template<> struct action < IR_conditional_branch_rule >{
-    static void apply( const pegtl::input &in, IR::Program &p){
+    static void apply( const pegtl::input &in, IR::Program &p, ParseState &state){
       shared_ptr<IR::CBranch> cbranch = make_shared<IR::CBranch>();
       IR::IR_item then_dest;
-      then_dest.name = parsed_labels.end()[-2];
+      then_dest.name = state.parsed_labels.end()[-2];
       IR::IR_item else_dest;
-      else_dest.name = parsed_labels.end()[-1];
-      IR::IR_t condition = parsed_t_vals.at(0);
+      else_dest.name = state.parsed_labels.end()[-1];
+      IR::IR_t condition = state.parsed_t_vals.at(0);
       cbranch->condition = condition;
       cbranch->then_dest = then_dest;
       cbranch->else_dest = else_dest;
-      add_instruction(p, cbranch);
-      clear_memory();
+      state.add_instruction(p, cbranch);
+      state.clear_memory();
     }
   };
 
   template<> struct action < IR_i_label_rule >{
-      static void apply( const pegtl::input &in, IR::Program &p){
+      static void apply( const pegtl::input &in, IR::Program &p, ParseState &state){
         shared_ptr<IR::Label> label = make_shared<IR::Label>();
         IR::IR_item lbl;
-        lbl.name = parsed_labels.back();
+        lbl.name = state.parsed_labels.back();
         label->label = lbl;
-        add_instruction(p, label);
-        clear_memory();
+        state.add_instruction(p, label);
+        state.clear_memory();
       }
   };
 
   template<> struct action < IR_e_rule >{
-      static void apply( const pegtl::input &in, IR::Program &p){
-        parsed_basic_block = make_shared<IR::BasicBlock>();
+      static void apply( const pegtl::input &in, IR::Program &p, ParseState &state){
+        state.parsed_basic_block = make_shared<IR::BasicBlock>();
         IR::IR_item entry;
-        entry.name = in.string();
-        parsed_basic_block->entry_point = entry;
-        clear_memory();
+        // the rule's input includes the separators around the label
+        entry.name = state.parsed_labels.back();
+        state.parsed_basic_block->entry_point = entry;
+        state.clear_memory();
       }
   };
 
   template<> struct action < IR_te_rule >{
-    static void apply( const pegtl::input &in, IR::Program &p){
-      end_block(p);
-      clear_memory();
+    static void apply( const pegtl::input &in, IR::Program &p, ParseState &state){
+      state.end_block(p);
+      state.clear_memory();
     }
   };
 
   template<> struct action < IR_call_rule >{
-    static void apply( const pegtl::input &in, IR::Program &p){
+    static void apply( const pegtl::input &in, IR::Program &p, ParseState &state){
       shared_ptr<IR::Call> call = make_shared<IR::Call>();
-      call->callee = parsed_callee;
+      call->callee = state.parsed_callee;
       call->args.insert(
           call->args.end(),
-          parsed_args.begin(),
-          parsed_args.end()
+          state.parsed_args.begin(),
+          state.parsed_args.end()
       );
-      add_instruction(p, call);
-      clear_memory();
+      state.add_instruction(p, call);
+      state.clear_memory();
     }
   };
 
   template<> struct action < IR_call_assign_rule >{
-    static void apply( const pegtl::input &in, IR::Program &p){
+    static void apply( const pegtl::input &in, IR::Program &p, ParseState &state){
       shared_ptr<IR::CallAssign> calla = make_shared<IR::CallAssign>();
-      calla->callee = parsed_callee;
+      calla->callee = state.parsed_callee;
       calla->args.insert(
           calla->args.end(),
-          parsed_args.begin(),
-          parsed_args.end()
+          state.parsed_args.begin(),
+          state.parsed_args.end()
       );
-      calla->lhs = *parsed_variables.at(0);
-      add_instruction(p, calla);
-      clear_memory();
+      calla->lhs = *state.parsed_variables.at(0);
+      state.add_instruction(p, calla);
+      state.clear_memory();
     }
   };
 
   template<> struct action < IR_array_allocate_rule >{
-    static void apply( const pegtl::input &in, IR::Program &p){
+    static void apply( const pegtl::input &in, IR::Program &p, ParseState &state){
       shared_ptr<IR::ArrayAllocate> alloc = make_shared<IR::ArrayAllocate>();
-      alloc->lhs = *parsed_variables.at(0);
+      alloc->lhs = *state.parsed_variables.at(0);
       alloc->dimensions.insert(
           alloc->dimensions.end(),
-          parsed_args.begin(),
-          parsed_args.end()
+          state.parsed_args.begin(),
+          state.parsed_args.end()
       );
-      add_instruction(p, alloc);
-      clear_memory();
+      state.add_instruction(p, alloc);
+      state.clear_memory();
     }
   };
 
   template<> struct action < IR_tuple_allocate_rule >{
-    static void apply( const pegtl::input &in, IR::Program &p){
+    static void apply( const pegtl::input &in, IR::Program &p, ParseState &state){
       shared_ptr<IR::TupleAllocate> alloc = make_shared<IR::TupleAllocate>();
-      alloc->lhs = *parsed_variables.at(0);
-      alloc->dimension = parsed_t_vals.back();
-      add_instruction(p, alloc);
-      clear_memory();
+      alloc->lhs = *state.parsed_variables.at(0);
+      alloc->dimension = state.parsed_t_vals.back();
+      state.add_instruction(p, alloc);
+      state.clear_memory();
     }
   };
 
   template<> struct action < length_rhs_rule >{
-    static void apply( const pegtl::input &in, IR::Program &p){
-      parsed_length_rhs = *parsed_variables.back();
+    static void apply( const pegtl::input &in, IR::Program &p, ParseState &state){
+      state.parsed_length_rhs = *state.parsed_variables.back();
     }
   };
 
   template<> struct action < length_index_rule >{
-    static void apply( const pegtl::input &in, IR::Program &p){
-      parsed_length_index = parsed_t_vals.back();
+    static void apply( const pegtl::input &in, IR::Program &p, ParseState &state){
+      state.parsed_length_index = state.parsed_t_vals.back();
     }
   };
 
   template<> struct action < IR_length_read_rule >{
-    static void apply( const pegtl::input &in, IR::Program &p){
+    static void apply( const pegtl::input &in, IR::Program &p, ParseState &state){
       shared_ptr<IR::LengthRead> lr = make_shared<IR::LengthRead>();
-      lr->lhs = *parsed_variables.at(0);
-      lr->rhs = parsed_length_rhs;
-      lr->index = parsed_length_index;
-      add_instruction(p, lr);
-      clear_memory();
+      lr->lhs = *state.parsed_variables.at(0);
+      lr->rhs = state.parsed_length_rhs;
+      lr->index = state.parsed_length_index;
+      state.add_instruction(p, lr);
+      state.clear_memory();
     }
   };
 
   template<> struct action < IR_indices_rule >{
-    static void apply( const pegtl::input &in, IR::Program &p){
-      parsed_indices.insert(
-        parsed_indices.end(),
-        parsed_t_vals.begin(),
-        parsed_t_vals.end()
+    static void apply( const pegtl::input &in, IR::Program &p, ParseState &state){
+      state.parsed_indices.insert(
+        state.parsed_indices.end(),
+        state.parsed_t_vals.begin(),
+        state.parsed_t_vals.end()
       );
     }
   };
 
   template<> struct action < IR_array_read_rule >{
-    static void apply( const pegtl::input &in, IR::Program &p){
+    static void apply( const pegtl::input &in, IR::Program &p, ParseState &state){
       shared_ptr<IR::IndexRead> read = make_shared<IR::IndexRead>();
-      read->lhs = *parsed_variables.at(0);
-      read->rhs = *parsed_variables.at(1);
+      read->lhs = *state.parsed_variables.at(0);
+      read->rhs = *state.parsed_variables.at(1);
       read->indices.insert(
         read->indices.end(),
-        parsed_indices.begin(),
-        parsed_indices.end()
+        state.parsed_indices.begin(),
+        state.parsed_indices.end()
       );
-      add_instruction(p, read);
-      clear_memory();
+      state.add_instruction(p, read);
+      state.clear_memory();
     }
   };
 
   template<> struct action < IR_array_write_rule >{
-    static void apply( const pegtl::input &in, IR::Program &p){
+    static void apply( const pegtl::input &in, IR::Program &p, ParseState &state){
       shared_ptr<IR::IndexWrite> write = make_shared<IR::IndexWrite>();
-      write->lhs = *parsed_variables.at(0);
-      write->rhs = parsed_s_vals.back();
+      write->lhs = *state.parsed_variables.at(0);
+      write->rhs = state.parsed_s_vals.back();
       write->indices.insert(
         write->indices.end(),
-        parsed_indices.begin(),
-        parsed_indices.end()
+        state.parsed_indices.begin(),
+        state.parsed_indices.end()
       );
-      add_instruction(p, write);
-      clear_memory();
+      state.add_instruction(p, write);
+      state.clear_memory();
     }
   };
 
   template<> struct action < IR_return_rule >{
-    static void apply( const pegtl::input &in, IR::Program &p){
+    static void apply( const pegtl::input &in, IR::Program &p, ParseState &state){
       shared_ptr<IR::Return> ret = make_shared<IR::Return>();
-      add_instruction(p, ret);
-      clear_memory();
+      state.add_instruction(p, ret);
+      state.clear_memory();
     }
   };
 
   template<> struct action < IR_returnvalue_rule >{
-    static void apply( const pegtl::input &in, IR::Program &p){
+    static void apply( const pegtl::input &in, IR::Program &p, ParseState &state){
       shared_ptr<IR::ReturnValue> ret = make_shared<IR::ReturnValue>();
-      IR::IR_t retvar = parsed_t_vals.back();
+      IR::IR_t retvar = state.parsed_t_vals.back();
       ret->value = retvar;
-      add_instruction(p, ret);
-      clear_memory();
+      state.add_instruction(p, ret);
+      state.clear_memory();
     }
   };
 
   template<> struct action < IR_function_name_rule >{
-      static void apply( const pegtl::input &in, IR::Program &p){
+      static void apply( const pegtl::input &in, IR::Program &p, ParseState &state){
         shared_ptr<IR::Function> fn = make_shared<IR::Function>();
-        fn->name = parsed_labels.back();
+        fn->name = state.parsed_labels.back();
+        if (state.parsed_T.name == "void") {
+          fn->return_type.dec_type = IR::IRvoid;
+        } else {
+          fn->return_type = state.parsed_type;
+        }
         p.functions.push_back(fn);
-        clear_memory();
+        state.clear_memory();
       }
   };
 
 
+  /*
+   * Walks the grammar for rules that could loop without consuming
+   * input, which costs more than parsing a small program. Only
+   * builds made with CHECK_GRAMMAR=1 do it, once per process.
+   */
+  void check_grammar() {
+#ifdef CHECK_GRAMMAR
+    static size_t issues = pegtl::analyze< IR::grammar >();
+    (void)issues;
+#endif
+  }
+
   IR::Program IR_parse_file (char *fileName){
 
     /*
      * Check the grammar for some possible issues.
      */
-    pegtl::analyze< IR::grammar >();
+    check_grammar();
 
     /*
      * Parse.
      */
     IR::Program p;
-    pegtl::file_parser(fileName).parse< IR::grammar, IR::action >(p);
+    ParseState state;
+    pegtl::file_parser(fileName).parse< IR::grammar, IR::action >(p, state);
 
     return p;
   }
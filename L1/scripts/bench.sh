@@ -0,0 +1,19 @@
+#!/bin/bash
+
+# Builds every program in bench/ and reports its run time and
+# the runtime's GC statistics ($GC_STATS).
+
+cd bench ;
+for i in *.L1 ; do
+  echo $i ;
+
+  pushd ./ > /dev/null ;
+  cd ../ ;
+  ./L1c bench/${i} ;
+  start=`date +%s%N` ;
+  ./a.out > /dev/null ;
+  end=`date +%s%N` ;
+  echo "  run time: $(( (end - start) / 1000000 )) ms" ;
+  GC_STATS=1 ./a.out 2>&1 > /dev/null | sed "s/^/  /" ;
+  popd > /dev/null ;
+done
@@ -0,0 +1,12 @@
+#!/bin/bash
+
+# Times the L1 compiler, phase by phase, on one synthetic function
+# of $1 (100000 by default) instructions.
+
+n=${1:-100000} ;
+../scripts/synthetic_function.sh $n > tests/synthetic.tmp ;
+echo "synthetic function, $n instructions" ;
+start=`date +%s%N` ;
+./bin/L1 -v tests/synthetic.tmp 2>&1 | sed "s/^/  /" ;
+end=`date +%s%N` ;
+echo "  total: $(( (end - start) / 1000000 )) ms" ;
@@ -0,0 +1,17 @@
+#!/bin/bash
+
+# Builds the gc_* programs in bench/ and reports the GC pauses of
+# each with 1 to 16 collector threads ($GC_THREADS).
+
+cd bench ;
+for i in gc_*.L1 ; do
+  echo $i ;
+
+  pushd ./ > /dev/null ;
+  cd ../ ;
+  ./L1c bench/${i} ;
+  for threads in 1 2 4 8 16 ; do
+    echo "  $threads threads: `GC_STATS=1 GC_THREADS=$threads ./a.out 2>&1 > /dev/null | head -n 1`" ;
+  done
+  popd > /dev/null ;
+done
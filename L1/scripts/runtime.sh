@@ -0,0 +1,17 @@
+#!/bin/bash
+
+# Compiles ../lib/runtime.c to obj/runtime.o, unless obj/runtime.o
+# was already compiled from the same runtime.c. The SHA-1 of the
+# source it was compiled from is kept in obj/runtime.sha1.
+
+cd `dirname $0`/.. ;
+mkdir -p obj ;
+
+hash=`sha1sum ../lib/runtime.c | cut -d " " -f 1` ;
+if test -f obj/runtime.o -a "`cat obj/runtime.sha1 2> /dev/null`" = "$hash" ; then
+  exit 0 ;
+fi
+
+rm -f obj/runtime.sha1 ;
+gcc -O2 -c -g -pthread -o obj/runtime.o ../lib/runtime.c || exit 1 ;
+echo $hash > obj/runtime.sha1 ;
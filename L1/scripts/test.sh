@@ -1,30 +1,48 @@
 #!/bin/bash
 
+# The gc_* tests run once more in each of these, with heaps small
+# enough to collect many times over: growing from 64 words, held at
+# $HEAP_MAX_SIZE, and collected by four threads
+gc_environments=("HEAP_SIZE=64" "HEAP_SIZE=64 HEAP_MAX_SIZE=8192" "GC_THREADS=4 HEAP_SIZE=64") ;
+
 passed=0 ;
 failed=0 ;
-cd tests ; 
+cd tests ;
 for i in *.L1 ; do
 
   # If the output already exists, skip the current test
   if ! test -f ${i}.out ; then
     continue ;
   fi
-  echo $i ;
 
-  # Generate the binary
+  environments=("") ;
+  if [[ $i == gc_* ]] ; then
+    environments+=("${gc_environments[@]}") ;
+  fi
+
+  # Generate the binary and run it, or with -r have bin/L1 run it
   pushd ./ ;
   cd ../ ;
-  ./L1c tests/${i} ;
-  ./a.out &> tests/${i}.out.tmp ;
-  cmp tests/${i}.out.tmp tests/${i}.out ;
-  if ! test $? -eq 0 ; then
-    echo "  Failed" ;
-    let failed=$failed+1 ;
-  else
-    echo "  Passed" ;
-    let passed=$passed+1 ;
+  if test "$1" != "-r" ; then
+    ./L1c $@ tests/${i} ;
   fi
-  popd ; 
+  for environment in "${environments[@]}" ; do
+    echo $i $environment ;
+    if test "$1" = "-r" ; then
+      env $environment ./bin/L1 -r tests/${i} &> tests/${i}.out.tmp ;
+    else
+      env $environment ./a.out &> tests/${i}.out.tmp ;
+    fi
+    cmp tests/${i}.out.tmp tests/${i}.out ;
+    if ! test $? -eq 0 ; then
+      echo "  Failed" ;
+      let failed=$failed+1 ;
+    else
+      echo "  Passed" ;
+      let passed=$passed+1 ;
+    fi
+  done
+  popd ;
 done
 let total=$passed+$failed ;
 
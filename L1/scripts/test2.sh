@@ -11,13 +11,20 @@ for i in *.L1 ; do
   fi
   echo $i ;
 
-  # Generate the binary
+  # Generate the binary and run it, or with -r compile it with bin/L2
+  # and have bin/L1 run what that makes
   pushd ./ ;
   cd ../ ;
-  cd ../L2
-  ./L2c ../L1/tests/${i} ;
-  cd ../L1
-  ../L2/a.out &> tests/${i}.out.tmp ;
+  if test "$1" = "-r" ; then
+    rm -f ../L2/prog.L1 ;
+    (cd ../L2 && ./bin/L2 ../L1/tests/${i}) ;
+    ./bin/L1 -r ../L2/prog.L1 &> tests/${i}.out.tmp ;
+  else
+    cd ../L2
+    ./L2c ../L1/tests/${i} ;
+    cd ../L1
+    ../L2/a.out &> tests/${i}.out.tmp ;
+  fi
   cmp tests/${i}.out.tmp tests/${i}.out ;
   if ! test $? -eq 0 ; then
     echo "  Failed" ;
@@ -6,7 +6,7 @@ namespace L1 {
 
   struct L1_item {
     std::string name;
-    bool r;
+    bool r = false;
   };
 
   struct L1_w : L1_item {};
@@ -26,22 +26,37 @@ namespace L1 {
   struct MemoryReference{
     L1::L1_x value;
     L1::L1_m offset;
-    int64_t offset_int;
+    int64_t offset_int = 0;
+  };
+
+  /*
+   * Which kind of instruction an Instruction is, so passes can
+   * switch on it instead of trying one dynamic_cast after another.
+   * L2 instructions come in the same kinds and share the tags.
+   */
+  enum Opcode {
+    goto_op, wawwe_op, comparison_op, cjump_op, memory_arithmetic_op,
+    memory_arithmetic2_op, arithmetic_op, label_op, function_call_op,
+    runtime_call_op, return_op, assignment_op, load_op, store_op, shift_op
   };
 
   struct Instruction {
+    Instruction(Opcode opcode) : opcode(opcode) {};
     virtual ~Instruction() {};
+    const Opcode opcode;
   };
 
   struct GotoOperation : public Instruction{
+    GotoOperation() : Instruction(goto_op) {};
     L1::L1_item lbl;
   };
 
   struct WawweOperation : public Instruction{
+    WawweOperation() : Instruction(wawwe_op) {};
     L1::L1_w lhs;
     L1::L1_w start;
     L1::L1_w mult;
-    int64_t e;
+    int64_t e = 0;
   };
 
   enum ComparisonOperator { lessthan, lessthanorequal, equal };
@@ -53,11 +68,13 @@ namespace L1 {
   };
 
   struct ComparisonOperation : public Instruction{
+    ComparisonOperation() : Instruction(comparison_op) {};
     L1::L1_w lhs;
     ComparisonExpression cexp;
   };
 
   struct CjumpOperation : public Instruction{
+    CjumpOperation() : Instruction(cjump_op) {};
     ComparisonExpression cexp;
     std::string then_label;
     std::string else_label;
@@ -66,50 +83,61 @@ namespace L1 {
   enum ArithmeticOperator { plusequal, minusequal, timesequal, andequal };
 
   struct MemoryArithmeticOperation : public Instruction{
+    MemoryArithmeticOperation() : Instruction(memory_arithmetic_op) {};
     L1::MemoryReference lhs;
     ArithmeticOperator op;
     L1::L1_t rhs;
   };
 
   struct MemoryArithmeticOperation2 : public Instruction{
+    MemoryArithmeticOperation2() : Instruction(memory_arithmetic2_op) {};
     L1::L1_w lhs;
     ArithmeticOperator op;
     L1::MemoryReference rhs;
   };
 
   struct ArithmeticOperation : public Instruction{
+    ArithmeticOperation() : Instruction(arithmetic_op) {};
     L1::L1_w lhs;
     ArithmeticOperator op;
     L1::L1_t rhs;
   };
 
   struct Label : public Instruction{
+    Label() : Instruction(label_op) {};
     std::string name;
   };
 
   struct FunctionCall : public Instruction{
+    FunctionCall() : Instruction(function_call_op) {};
     L1_item function_name;
-    int64_t n_args;
+    int64_t n_args = 0;
   };
 
   struct RuntimeCall : public Instruction{
+    RuntimeCall() : Instruction(runtime_call_op) {};
     L1_item function_name;
-    int64_t n_args;
+    int64_t n_args = 0;
   };
 
-  struct ReturnCall : public Instruction{};
+  struct ReturnCall : public Instruction{
+    ReturnCall() : Instruction(return_op) {};
+  };
 
   struct Assignment : public Instruction{
+    Assignment() : Instruction(assignment_op) {};
     L1::L1_w lhs;
     L1::L1_s rhs;
   };
 
   struct Load : public Instruction{
+    Load() : Instruction(load_op) {};
     L1::L1_w lhs;
     L1::MemoryReference rhs;
   };
 
   struct Store : public Instruction{
+    Store() : Instruction(store_op) {};
     L1::MemoryReference lhs;
     L1::L1_s rhs;
   };
@@ -117,6 +145,7 @@ namespace L1 {
   enum ShiftOperator { lshift, rshift };
 
   struct ShiftOperation : public Instruction{
+    ShiftOperation() : Instruction(shift_op) {};
     L1::L1_w lhs;
     L1::ShiftOperator op;
     L1::L1_item rhs;
@@ -0,0 +1,780 @@
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <stdint.h>
+
+#include "assembler.h"
+
+using namespace std;
+
+namespace L1 {
+
+  struct Register {
+    int number;
+    int size;
+  };
+
+  const map<string, Register> registers = {
+    {"rax", {0, 64}}, {"rcx", {1, 64}}, {"rdx", {2, 64}}, {"rbx", {3, 64}},
+    {"rsp", {4, 64}}, {"rbp", {5, 64}}, {"rsi", {6, 64}}, {"rdi", {7, 64}},
+    {"r8", {8, 64}}, {"r9", {9, 64}}, {"r10", {10, 64}}, {"r11", {11, 64}},
+    {"r12", {12, 64}}, {"r13", {13, 64}}, {"r14", {14, 64}}, {"r15", {15, 64}},
+    {"eax", {0, 32}}, {"ecx", {1, 32}}, {"edx", {2, 32}}, {"ebx", {3, 32}},
+    {"esp", {4, 32}}, {"ebp", {5, 32}}, {"esi", {6, 32}}, {"edi", {7, 32}},
+    {"r8d", {8, 32}}, {"r9d", {9, 32}}, {"r10d", {10, 32}}, {"r11d", {11, 32}},
+    {"r12d", {12, 32}}, {"r13d", {13, 32}}, {"r14d", {14, 32}}, {"r15d", {15, 32}},
+    {"al", {0, 8}}, {"cl", {1, 8}}, {"dl", {2, 8}}, {"bl", {3, 8}},
+    {"spl", {4, 8}}, {"bpl", {5, 8}}, {"sil", {6, 8}}, {"dil", {7, 8}},
+    {"r8b", {8, 8}}, {"r9b", {9, 8}}, {"r10b", {10, 8}}, {"r11b", {11, 8}},
+    {"r12b", {12, 8}}, {"r13b", {13, 8}}, {"r14b", {14, 8}}, {"r15b", {15, 8}}
+  };
+
+  const map<string, int> condition_codes = {
+    {"o", 0}, {"no", 1}, {"b", 2}, {"ae", 3}, {"e", 4}, {"z", 4}, {"ne", 5}, {"nz", 5},
+    {"be", 6}, {"a", 7}, {"s", 8}, {"ns", 9}, {"l", 12}, {"ge", 13}, {"le", 14}, {"g", 15}
+  };
+
+  // the ModRM opcode extension of each two-operand arithmetic instruction
+  const map<string, int> arithmetic_operations = {
+    {"addq", 0}, {"orq", 1}, {"andq", 4}, {"subq", 5}, {"xorq", 6}, {"cmpq", 7}, {"xorl", 6}
+  };
+
+  const map<string, int> shift_operations = {
+    {"salq", 4}, {"shlq", 4}, {"shrq", 5}, {"sarq", 7}
+  };
+
+  struct Operand {
+    enum Kind { register_operand, immediate, symbol_immediate, memory, label, indirect };
+    Kind kind;
+    Register reg = {0, 0};
+    int64_t value = 0;
+    string symbol;
+    int base = -1;
+    int index = -1;
+    int scale = 1;
+    bool rip = false;
+  };
+
+  /*
+   * A reference to a symbol from the instruction being assembled.
+   * pc_relative ones are relative to the end of the instruction,
+   * and jumps may go through the PLT.
+   */
+  struct Fixup {
+    Section section;
+    int64_t offset;
+    RelocationType type;
+    string symbol;
+    int64_t addend;
+    bool jump;
+  };
+
+  bool fits_int8(int64_t n) {
+    return n >= -128 && n <= 127;
+  }
+
+  bool fits_int32(int64_t n) {
+    return n >= INT32_MIN && n <= INT32_MAX;
+  }
+
+  string trim(const string &s) {
+    size_t first = s.find_first_not_of(" \t");
+    if (first == string::npos) {
+      return "";
+    }
+    size_t last = s.find_last_not_of(" \t");
+    return s.substr(first, last - first + 1);
+  }
+
+  // splits s at the commas that aren't in parentheses
+  vector<string> split_operands(const string &s) {
+    vector<string> operands;
+    string current;
+    int depth = 0;
+    for (char c : s) {
+      if (c == '(') {
+        depth++;
+      } else if (c == ')') {
+        depth--;
+      }
+      if (c == ',' && depth == 0) {
+        operands.push_back(trim(current));
+        current.clear();
+      } else {
+        current += c;
+      }
+    }
+    if (!trim(current).empty()) {
+      operands.push_back(trim(current));
+    }
+    return operands;
+  }
+
+  bool is_number(const string &s) {
+    if (s.empty()) {
+      return false;
+    }
+    size_t k = (s[0] == '-' || s[0] == '+') ? 1 : 0;
+    if (k == s.size()) {
+      return false;
+    }
+    for (; k < s.size(); k++) {
+      if (!isdigit(s[k])) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  class Assembler {
+    public:
+      void line(const string &text, int64_t line_number);
+      ObjectCode finish();
+
+    private:
+      void directive(const string &name, const vector<string> &operands);
+      void instruction(const string &mnemonic, const vector<Operand> &operands);
+      Operand operand(const string &text);
+      Register register_named(const string &name);
+
+      vector<uint8_t> &bytes();
+      void emit(uint8_t byte);
+      void emit32(int64_t n);
+      void emit64(int64_t n);
+      void fixup(RelocationType type, const string &symbol, bool jump);
+      void encode(bool wide, const vector<uint8_t> &opcode, int reg, const Operand &rm);
+      void arithmetic(int extension, bool wide, const Operand &src, const Operand &dst);
+      void mov(const Operand &src, const Operand &dst);
+      void branch(const vector<uint8_t> &opcode, const Operand &target);
+      void error(const string &message);
+
+      ObjectCode object;
+      Section section = text_section;
+      vector<Fixup> fixups;
+      size_t instruction_fixups = 0;
+      int64_t line_number = 0;
+  };
+
+  void Assembler::error(const string &message) {
+    throw runtime_error("prog.S:" + to_string(line_number) + ": " + message);
+  }
+
+  vector<uint8_t> &Assembler::bytes() {
+    return section == text_section ? object.text : object.data;
+  }
+
+  void Assembler::emit(uint8_t byte) {
+    bytes().push_back(byte);
+  }
+
+  void Assembler::emit32(int64_t n) {
+    for (int k = 0; k < 4; k++) {
+      emit((n >> (8 * k)) & 0xff);
+    }
+  }
+
+  void Assembler::emit64(int64_t n) {
+    for (int k = 0; k < 8; k++) {
+      emit((n >> (8 * k)) & 0xff);
+    }
+  }
+
+  // a reference to symbol from the next 4 (or 8, for R_X86_64_64) bytes
+  void Assembler::fixup(RelocationType type, const string &symbol, bool jump) {
+    fixups.push_back({section, (int64_t)bytes().size(), type, symbol, 0, jump});
+  }
+
+  Register Assembler::register_named(const string &name) {
+    auto r = registers.find(name);
+    if (r == registers.end()) {
+      error("unknown register %" + name);
+    }
+    return r->second;
+  }
+
+  Operand Assembler::operand(const string &text) {
+    Operand op;
+    if (text[0] == '%') {
+      op.kind = Operand::register_operand;
+      op.reg = register_named(text.substr(1));
+    } else if (text.compare(0, 2, "*%") == 0) {
+      op.kind = Operand::indirect;
+      op.reg = register_named(text.substr(2));
+    } else if (text[0] == '$') {
+      string value = text.substr(1);
+      if (is_number(value)) {
+        op.kind = Operand::immediate;
+        op.value = stoll(value);
+      } else {
+        op.kind = Operand::symbol_immediate;
+        op.symbol = value;
+      }
+    } else if (text.find('(') != string::npos) {
+      op.kind = Operand::memory;
+      size_t open = text.find('(');
+      size_t close = text.find(')', open);
+      if (close == string::npos) {
+        error("bad memory operand " + text);
+      }
+      string displacement = trim(text.substr(0, open));
+      vector<string> parts = split_operands(text.substr(open + 1, close - open - 1));
+      if (parts.empty() || parts.size() > 3) {
+        error("bad memory operand " + text);
+      }
+      if (parts[0] == "%rip") {
+        op.rip = true;
+        op.symbol = displacement;
+      } else {
+        if (is_number(displacement)) {
+          op.value = stoll(displacement);
+        } else if (!displacement.empty()) {
+          error("bad displacement " + displacement);
+        }
+        if (!parts[0].empty()) {
+          op.base = register_named(parts[0].substr(1)).number;
+        }
+        if (parts.size() > 1) {
+          op.index = register_named(parts[1].substr(1)).number;
+        }
+        if (parts.size() > 2) {
+          op.scale = stoll(parts[2]);
+        }
+      }
+    } else {
+      op.kind = Operand::label;
+      op.symbol = text;
+    }
+    return op;
+  }
+
+  /*
+   * Emits an optional REX prefix, opcode, and the ModRM byte with reg
+   * (a register or an opcode extension) in its reg field and rm as
+   * its r/m operand, followed by any SIB byte and displacement.
+   */
+  void Assembler::encode(bool wide, const vector<uint8_t> &opcode, int reg, const Operand &rm) {
+    int rm_number = 0;
+    int index = 0;
+    bool byte_register = false;
+    if (rm.kind == Operand::register_operand || rm.kind == Operand::indirect) {
+      rm_number = rm.reg.number;
+      byte_register = rm.reg.size == 8 && rm.reg.number >= 4;
+    } else if (rm.kind == Operand::memory) {
+      rm_number = rm.base < 0 ? 0 : rm.base;
+      index = rm.index < 0 ? 0 : rm.index;
+    } else {
+      error("bad operand");
+    }
+
+    uint8_t rex = 0x40 | (wide ? 8 : 0) | (reg >= 8 ? 4 : 0) | (index >= 8 ? 2 : 0) | (rm_number >= 8 ? 1 : 0);
+    if (rex != 0x40 || byte_register) {
+      emit(rex);
+    }
+    for (auto byte : opcode) {
+      emit(byte);
+    }
+
+    if (rm.kind != Operand::memory) {
+      emit(0xc0 | ((reg & 7) << 3) | (rm_number & 7));
+      return;
+    }
+    if (rm.rip) {
+      emit(0x05 | ((reg & 7) << 3));
+      fixup(R_X86_64_PC32, rm.symbol, false);
+      emit32(0);
+      return;
+    }
+    if (rm.base < 0) {
+      error("memory operand without a base register");
+    }
+
+    int mod;
+    if (rm.value == 0 && (rm.base & 7) != 5) {
+      mod = 0;
+    } else if (fits_int8(rm.value)) {
+      mod = 1;
+    } else if (fits_int32(rm.value)) {
+      mod = 2;
+    } else {
+      error("displacement out of range");
+    }
+
+    if (rm.index >= 0 || (rm.base & 7) == 4) {
+      int scale_bits = rm.scale == 1 ? 0 : rm.scale == 2 ? 1 : rm.scale == 4 ? 2 : rm.scale == 8 ? 3 : -1;
+      if (scale_bits < 0 || rm.index == 4) {
+        error("bad index or scale");
+      }
+      emit((mod << 6) | ((reg & 7) << 3) | 4);
+      emit((scale_bits << 6) | ((rm.index < 0 ? 4 : rm.index & 7) << 3) | (rm.base & 7));
+    } else {
+      emit((mod << 6) | ((reg & 7) << 3) | (rm.base & 7));
+    }
+    if (mod == 1) {
+      emit(rm.value & 0xff);
+    } else if (mod == 2) {
+      emit32(rm.value);
+    }
+  }
+
+  void Assembler::arithmetic(int extension, bool wide, const Operand &src, const Operand &dst) {
+    if (src.kind == Operand::immediate) {
+      if (!fits_int32(src.value)) {
+        error("immediate out of range");
+      }
+      bool short_form = fits_int8(src.value);
+      if (!short_form && dst.kind == Operand::register_operand && dst.reg.number == 0) {
+        // the accumulator has a form without a ModRM byte
+        if (wide) {
+          emit(0x48);
+        }
+        emit(extension * 8 + 5);
+      } else {
+        encode(wide, {(uint8_t)(short_form ? 0x83 : 0x81)}, extension, dst);
+      }
+      if (short_form) {
+        emit(src.value & 0xff);
+      } else {
+        emit32(src.value);
+      }
+    } else if (src.kind == Operand::register_operand) {
+      encode(wide, {(uint8_t)(extension * 8 + 1)}, src.reg.number, dst);
+    } else if (src.kind == Operand::memory && dst.kind == Operand::register_operand) {
+      encode(wide, {(uint8_t)(extension * 8 + 3)}, dst.reg.number, src);
+    } else {
+      error("bad operands");
+    }
+  }
+
+  void Assembler::mov(const Operand &src, const Operand &dst) {
+    if (src.kind == Operand::register_operand) {
+      encode(true, {0x89}, src.reg.number, dst);
+    } else if (src.kind == Operand::memory && dst.kind == Operand::register_operand) {
+      encode(true, {0x8b}, dst.reg.number, src);
+    } else if (src.kind == Operand::immediate && fits_int32(src.value)) {
+      encode(true, {0xc7}, 0, dst);
+      emit32(src.value);
+    } else if (src.kind == Operand::immediate && dst.kind == Operand::register_operand) {
+      emit(0x48 | (dst.reg.number >= 8 ? 1 : 0));
+      emit(0xb8 + (dst.reg.number & 7));
+      emit64(src.value);
+    } else if (src.kind == Operand::symbol_immediate) {
+      encode(true, {0xc7}, 0, dst);
+      fixup(R_X86_64_32S, src.symbol, false);
+      emit32(0);
+    } else {
+      error("bad operands");
+    }
+  }
+
+  void Assembler::branch(const vector<uint8_t> &opcode, const Operand &target) {
+    if (target.kind != Operand::label) {
+      error("bad branch target");
+    }
+    for (auto byte : opcode) {
+      emit(byte);
+    }
+    fixup(R_X86_64_PC32, target.symbol, true);
+    emit32(0);
+  }
+
+  void Assembler::instruction(const string &mnemonic, const vector<Operand> &ops) {
+    auto operands = [&](size_t n) {
+      if (ops.size() != n) {
+        error(mnemonic + " takes " + to_string(n) + " operands");
+      }
+    };
+
+    auto arithmetic_op = arithmetic_operations.find(mnemonic);
+    auto shift_op = shift_operations.find(mnemonic);
+    if (arithmetic_op != arithmetic_operations.end()) {
+      operands(2);
+      arithmetic(arithmetic_op->second, mnemonic.back() == 'q', ops[0], ops[1]);
+    } else if (shift_op != shift_operations.end()) {
+      operands(2);
+      if (ops[0].kind == Operand::register_operand && ops[0].reg.number == 1 && ops[0].reg.size == 8) {
+        encode(true, {0xd3}, shift_op->second, ops[1]);
+      } else if (ops[0].kind == Operand::immediate && ops[0].value == 1) {
+        encode(true, {0xd1}, shift_op->second, ops[1]);
+      } else if (ops[0].kind == Operand::immediate) {
+        encode(true, {0xc1}, shift_op->second, ops[1]);
+        emit(ops[0].value & 0xff);
+      } else {
+        error("bad shift amount");
+      }
+    } else if (mnemonic == "movq") {
+      operands(2);
+      mov(ops[0], ops[1]);
+    } else if (mnemonic == "movl") {
+      operands(2);
+      if (ops[0].kind != Operand::immediate || ops[1].kind != Operand::register_operand) {
+        error("bad operands");
+      }
+      if (ops[1].reg.number >= 8) {
+        emit(0x41);
+      }
+      emit(0xb8 + (ops[1].reg.number & 7));
+      emit32(ops[0].value);
+    } else if (mnemonic == "movb") {
+      operands(2);
+      if (ops[0].kind != Operand::immediate) {
+        error("bad operands");
+      }
+      encode(false, {0xc6}, 0, ops[1]);
+      emit(ops[0].value & 0xff);
+    } else if (mnemonic == "movzbq") {
+      operands(2);
+      encode(true, {0x0f, 0xb6}, ops[1].reg.number, ops[0]);
+    } else if (mnemonic == "lea" || mnemonic == "leaq") {
+      operands(2);
+      if (ops[0].kind != Operand::memory) {
+        error("bad operands");
+      }
+      encode(true, {0x8d}, ops[1].reg.number, ops[0]);
+    } else if (mnemonic == "imulq") {
+      operands(2);
+      if (ops[0].kind == Operand::immediate) {
+        bool short_form = fits_int8(ops[0].value);
+        encode(true, {(uint8_t)(short_form ? 0x6b : 0x69)}, ops[1].reg.number, ops[1]);
+        if (short_form) {
+          emit(ops[0].value & 0xff);
+        } else {
+          emit32(ops[0].value);
+        }
+      } else {
+        encode(true, {0x0f, 0xaf}, ops[1].reg.number, ops[0]);
+      }
+    } else if (mnemonic == "testq") {
+      operands(2);
+      if (ops[0].kind == Operand::immediate && ops[1].kind == Operand::register_operand && ops[1].reg.number == 0) {
+        emit(0x48);
+        emit(0xa9);
+        emit32(ops[0].value);
+      } else if (ops[0].kind == Operand::immediate) {
+        encode(true, {0xf7}, 0, ops[1]);
+        emit32(ops[0].value);
+      } else {
+        encode(true, {0x85}, ops[0].reg.number, ops[1]);
+      }
+    } else if (mnemonic == "btsq") {
+      operands(2);
+      encode(true, {0x0f, 0xab}, ops[0].reg.number, ops[1]);
+    } else if (mnemonic == "incq" || mnemonic == "decq") {
+      operands(1);
+      encode(true, {0xff}, mnemonic == "incq" ? 0 : 1, ops[0]);
+    } else if (mnemonic == "pushq" || mnemonic == "popq") {
+      operands(1);
+      if (ops[0].kind != Operand::register_operand) {
+        error("bad operands");
+      }
+      if (ops[0].reg.number >= 8) {
+        emit(0x41);
+      }
+      emit((mnemonic == "pushq" ? 0x50 : 0x58) + (ops[0].reg.number & 7));
+    } else if (mnemonic == "retq" || mnemonic == "ret") {
+      operands(0);
+      emit(0xc3);
+    } else if (mnemonic == "call" || mnemonic == "jmp") {
+      operands(1);
+      if (ops[0].kind == Operand::indirect) {
+        encode(false, {0xff}, mnemonic == "call" ? 2 : 4, ops[0]);
+      } else {
+        branch({(uint8_t)(mnemonic == "call" ? 0xe8 : 0xe9)}, ops[0]);
+      }
+    } else if (mnemonic[0] == 'j' && condition_codes.count(mnemonic.substr(1))) {
+      operands(1);
+      branch({0x0f, (uint8_t)(0x80 + condition_codes.at(mnemonic.substr(1)))}, ops[0]);
+    } else if (mnemonic.compare(0, 3, "set") == 0 && condition_codes.count(mnemonic.substr(3))) {
+      operands(1);
+      encode(false, {0x0f, (uint8_t)(0x90 + condition_codes.at(mnemonic.substr(3)))}, 0, ops[0]);
+    } else {
+      error("unknown instruction " + mnemonic);
+    }
+  }
+
+  void Assembler::directive(const string &name, const vector<string> &operands) {
+    if (name == ".text") {
+      section = text_section;
+    } else if (name == ".data") {
+      section = data_section;
+    } else if (name == ".globl") {
+      for (auto symbol : operands) {
+        object.globals.insert(symbol);
+      }
+    } else if (name == ".p2align") {
+      int64_t alignment = (int64_t)1 << stoll(operands.at(0));
+      while (bytes().size() % alignment) {
+        emit(section == text_section ? 0x90 : 0);
+      }
+    } else if (name == ".quad") {
+      for (auto value : operands) {
+        if (is_number(value)) {
+          emit64(stoll(value));
+        } else {
+          fixup(R_X86_64_64, value, false);
+          emit64(0);
+        }
+      }
+    } else {
+      error("unknown directive " + name);
+    }
+  }
+
+  void Assembler::line(const string &text, int64_t number) {
+    line_number = number;
+    string s = trim(text);
+    if (s.empty()) {
+      return;
+    }
+    if (s.back() == ':') {
+      string name = s.substr(0, s.size() - 1);
+      if (object.labels.count(name)) {
+        error("label " + name + " defined twice");
+      }
+      object.labels[name] = make_pair(section, (int64_t)bytes().size());
+      return;
+    }
+
+    size_t space = s.find_first_of(" \t");
+    string mnemonic = s.substr(0, space);
+    vector<string> operands;
+    if (space != string::npos) {
+      operands = split_operands(s.substr(space + 1));
+    }
+    if (mnemonic[0] == '.') {
+      directive(mnemonic, operands);
+      return;
+    }
+
+    vector<Operand> ops;
+    for (auto op : operands) {
+      ops.push_back(operand(op));
+    }
+    instruction_fixups = fixups.size();
+    instruction(mnemonic, ops);
+
+    // make the pc-relative fixups relative to the end of the instruction
+    int64_t end = bytes().size();
+    for (size_t k = instruction_fixups; k < fixups.size(); k++) {
+      if (fixups[k].type == R_X86_64_PC32) {
+        fixups[k].addend -= end - fixups[k].offset;
+      }
+    }
+  }
+
+  /*
+   * Patches the jumps and calls to labels in their own section, and
+   * turns every other fixup into a relocation.
+   */
+  ObjectCode Assembler::finish() {
+    for (auto f : fixups) {
+      auto target = object.labels.find(f.symbol);
+      bool defined = target != object.labels.end();
+      if (f.type == R_X86_64_PC32 && defined && target->second.first == f.section) {
+        vector<uint8_t> &section_bytes = f.section == text_section ? object.text : object.data;
+        int64_t displacement = target->second.second + f.addend - f.offset;
+        for (int k = 0; k < 4; k++) {
+          section_bytes[f.offset + k] = (displacement >> (8 * k)) & 0xff;
+        }
+        continue;
+      }
+      RelocationType type = (f.jump && !defined) ? R_X86_64_PLT32 : f.type;
+      object.relocations.push_back({f.section, f.offset, type, f.symbol, f.addend});
+    }
+    return object;
+  }
+
+  ObjectCode assemble(const string &assembly) {
+    Assembler assembler;
+    istringstream input(assembly);
+    string text;
+    int64_t number = 0;
+    while (getline(input, text)) {
+      assembler.line(text, ++number);
+    }
+    return assembler.finish();
+  }
+
+  /*
+   * Little-endian writes into the image of the object file.
+   */
+  struct Image {
+    vector<uint8_t> bytes;
+
+    void put(uint64_t n, int size) {
+      for (int k = 0; k < size; k++) {
+        bytes.push_back((n >> (8 * k)) & 0xff);
+      }
+    }
+
+    void put(const vector<uint8_t> &b) {
+      bytes.insert(bytes.end(), b.begin(), b.end());
+    }
+
+    void align(size_t alignment) {
+      while (bytes.size() % alignment) {
+        bytes.push_back(0);
+      }
+    }
+  };
+
+  // adds s to a string table, returning its offset
+  uint32_t add_string(vector<uint8_t> &table, const string &s) {
+    uint32_t offset = table.size();
+    table.insert(table.end(), s.begin(), s.end());
+    table.push_back(0);
+    return offset;
+  }
+
+  void write_elf(const ObjectCode &object, ostream &output) {
+    enum { null_index, text_index, data_index, note_index, symtab_index, strtab_index,
+           rela_text_index, rela_data_index, shstrtab_index, n_sections };
+
+    /* Symbols: the two sections, the labels that aren't assembler
+     * locals (.L), then the globals, defined or not.
+     */
+    vector<uint8_t> strtab(1, 0);
+    Image symtab;
+    map<string, uint64_t> symbol_index;
+    uint64_t n_symbols = 0;
+    auto add_symbol = [&](uint32_t name, uint8_t info, uint16_t section, uint64_t value) {
+      symtab.put(name, 4);
+      symtab.put(info, 1);
+      symtab.put(0, 1);
+      symtab.put(section, 2);
+      symtab.put(value, 8);
+      symtab.put(0, 8);
+      return n_symbols++;
+    };
+    const uint8_t local = 0, global = 1, notype = 0, section_type = 3;
+    add_symbol(0, 0, 0, 0);
+    add_symbol(0, (local << 4) | section_type, text_index, 0);
+    add_symbol(0, (local << 4) | section_type, data_index, 0);
+    for (auto l : object.labels) {
+      if (object.globals.count(l.first) || l.first.compare(0, 2, ".L") == 0) {
+        continue;
+      }
+      uint16_t section = l.second.first == text_section ? text_index : data_index;
+      symbol_index[l.first] = add_symbol(add_string(strtab, l.first), (local << 4) | notype, section, l.second.second);
+    }
+    uint64_t first_global = n_symbols;
+    set<string> undefined;
+    for (auto r : object.relocations) {
+      if (!object.labels.count(r.symbol)) {
+        undefined.insert(r.symbol);
+      }
+    }
+    for (auto g : object.globals) {
+      auto l = object.labels.find(g);
+      if (l == object.labels.end()) {
+        undefined.insert(g);
+        continue;
+      }
+      uint16_t section = l->second.first == text_section ? text_index : data_index;
+      symbol_index[g] = add_symbol(add_string(strtab, g), (global << 4) | notype, section, l->second.second);
+    }
+    for (auto u : undefined) {
+      symbol_index[u] = add_symbol(add_string(strtab, u), (global << 4) | notype, 0, 0);
+    }
+
+    /* Relocations against a local label go through its section's
+     * symbol, the way `as` does it.
+     */
+    Image rela[2];
+    for (auto r : object.relocations) {
+      uint64_t symbol;
+      int64_t addend = r.addend;
+      auto l = object.labels.find(r.symbol);
+      if (symbol_index.count(r.symbol) && (l == object.labels.end() || object.globals.count(r.symbol))) {
+        symbol = symbol_index[r.symbol];
+      } else {
+        symbol = l->second.first == text_section ? text_index : data_index;
+        addend += l->second.second;
+      }
+      Image &table = rela[r.section];
+      table.put(r.offset, 8);
+      table.put((symbol << 32) | r.type, 8);
+      table.put(addend, 8);
+    }
+
+    vector<uint8_t> shstrtab(1, 0);
+    uint32_t names[n_sections] = {0};
+    names[text_index] = add_string(shstrtab, ".text");
+    names[data_index] = add_string(shstrtab, ".data");
+    names[note_index] = add_string(shstrtab, ".note.GNU-stack");
+    names[symtab_index] = add_string(shstrtab, ".symtab");
+    names[strtab_index] = add_string(shstrtab, ".strtab");
+    names[rela_text_index] = add_string(shstrtab, ".rela.text");
+    names[rela_data_index] = add_string(shstrtab, ".rela.data");
+    names[shstrtab_index] = add_string(shstrtab, ".shstrtab");
+
+    /* The file: header, section contents, then the section headers.
+     */
+    Image file;
+    file.bytes.resize(64);
+    uint64_t offsets[n_sections] = {0};
+    uint64_t sizes[n_sections] = {0};
+    auto place = [&](int index, const vector<uint8_t> &contents, size_t alignment) {
+      file.align(alignment);
+      offsets[index] = file.bytes.size();
+      sizes[index] = contents.size();
+      file.put(contents);
+    };
+    place(text_index, object.text, 16);
+    place(data_index, object.data, 8);
+    place(note_index, {}, 1);
+    place(symtab_index, symtab.bytes, 8);
+    place(strtab_index, strtab, 1);
+    place(rela_text_index, rela[text_section].bytes, 8);
+    place(rela_data_index, rela[data_section].bytes, 8);
+    place(shstrtab_index, shstrtab, 1);
+    file.align(8);
+    uint64_t section_headers = file.bytes.size();
+
+    const uint32_t progbits = 1, symtab_type = 2, strtab_type = 3, rela_type = 4;
+    const uint64_t write = 1, alloc = 2, execinstr = 4, info_link = 0x40;
+    auto section_header = [&](int index, uint32_t type, uint64_t flags, uint32_t link, uint32_t info, uint64_t alignment, uint64_t entry_size) {
+      file.put(names[index], 4);
+      file.put(type, 4);
+      file.put(flags, 8);
+      file.put(0, 8);
+      file.put(offsets[index], 8);
+      file.put(sizes[index], 8);
+      file.put(link, 4);
+      file.put(info, 4);
+      file.put(alignment, 8);
+      file.put(entry_size, 8);
+    };
+    file.bytes.resize(file.bytes.size() + 64);
+    section_header(text_index, progbits, alloc | execinstr, 0, 0, 16, 0);
+    section_header(data_index, progbits, alloc | write, 0, 0, 8, 0);
+    section_header(note_index, progbits, 0, 0, 0, 1, 0);
+    section_header(symtab_index, symtab_type, 0, strtab_index, first_global, 8, 24);
+    section_header(strtab_index, strtab_type, 0, 0, 0, 1, 0);
+    section_header(rela_text_index, rela_type, info_link, symtab_index, text_index, 8, 24);
+    section_header(rela_data_index, rela_type, info_link, symtab_index, data_index, 8, 24);
+    section_header(shstrtab_index, strtab_type, 0, 0, 0, 1, 0);
+
+    Image header;
+    header.put({0x7f, 'E', 'L', 'F', 2, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0});
+    header.put(1, 2);                    // relocatable
+    header.put(62, 2);                   // x86-64
+    header.put(1, 4);
+    header.put(0, 8);
+    header.put(0, 8);
+    header.put(section_headers, 8);
+    header.put(0, 4);
+    header.put(64, 2);
+    header.put(0, 2);
+    header.put(0, 2);
+    header.put(64, 2);
+    header.put(n_sections, 2);
+    header.put(shstrtab_index, 2);
+    copy(header.bytes.begin(), header.bytes.end(), file.bytes.begin());
+
+    output.write((const char *)file.bytes.data(), file.bytes.size());
+  }
+
+} // L1
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include <ostream>
+#include <stdint.h>
+
+namespace L1 {
+
+  enum Section { text_section, data_section };
+
+  // the x86-64 ELF relocation types the assembler produces
+  enum RelocationType {
+    R_X86_64_64 = 1,
+    R_X86_64_PC32 = 2,
+    R_X86_64_PLT32 = 4,
+    R_X86_64_32S = 11
+  };
+
+  /*
+   * A word at offset in section that refers to symbol, to be
+   * patched as type says once the symbol's address is known.
+   */
+  struct Relocation {
+    Section section;
+    int64_t offset;
+    RelocationType type;
+    std::string symbol;
+    int64_t addend;
+  };
+
+  /*
+   * What assemble() makes of compile_L1's output: the bytes of
+   * .text and .data, where each label is, and the relocations for
+   * everything that isn't a jump within its own section.
+   */
+  struct ObjectCode {
+    std::vector<uint8_t> text;
+    std::vector<uint8_t> data;
+    std::map<std::string, std::pair<Section, int64_t>> labels;
+    std::set<std::string> globals;
+    std::vector<Relocation> relocations;
+  };
+
+  /*
+   * Encodes the AT&T assembly compile_L1 writes: its directives and
+   * the instructions it selects, with every jump taking a 32 bit
+   * displacement. Throws std::runtime_error on anything else.
+   */
+  ObjectCode assemble(const std::string &assembly);
+
+  /*
+   * Writes object as an ELF64 relocatable object, the same as `as`
+   * makes from the assembly.
+   */
+  void write_elf(const ObjectCode &object, std::ostream &output);
+
+} // L1
@@ -14,11 +14,21 @@
 #include <fstream>
 #include <map>
 
-#include "parser.h"
+#include "compiler.h"
+#include "stack_maps.h"
+#include "peephole.h"
+#include "layout.h"
 
 using namespace std;
 
 map<string, string> register_map;
+int64_t allocate_sites = 0;
+int64_t barrier_sites = 0;
+vector<pair<string, L1::StackMap>> stack_map_entries;
+int64_t emitted_branches = 0;
+
+// arrays bigger than this are left to the runtime's vectorized fill
+const int64_t inline_allocate_max_words = 512;
 
 string wrap_arg(L1::L1_item arg) {
   if (!arg.r) {
@@ -28,7 +38,234 @@ string wrap_arg(L1::L1_item arg) {
   }
 };
 
-void compile_L1(L1::Program p) {
+/*
+ * Inline fast path for (call allocate 2): bumps alloc_ptr from the
+ * runtime and fills the new array in place, and only calls into the
+ * runtime when the heap is full, the array is big, or the size
+ * needs checking (not encoded, zero or negative). Uses only
+ * caller-save registers, which the call would clobber anyway, and
+ * leaves rdi/rsi untouched for the slow path. Returns the label the
+ * slow path's call returns to.
+ */
+string emit_inline_allocate(ostream &outputFile) {
+  string id = to_string(allocate_sites++);
+  string slow = ".Lalloc_slow_" + id;
+  string fill = ".Lalloc_fill_" + id;
+  string done = ".Lalloc_done_" + id;
+
+  outputFile << "\tmovq %rdi, %rcx\n\tsarq $1, %rcx\n";
+  outputFile << "\ttestq $1, %rdi\n\tjz " << slow << "\n";
+  outputFile << "\ttestq %rcx, %rcx\n\tjle " << slow << "\n";
+  outputFile << "\tcmpq $" << inline_allocate_max_words << ", %rcx\n\tjg " << slow << "\n";
+  // words left in the heap, minus one for the size word
+  outputFile << "\tmovq alloc_ptr(%rip), %rax\n\tmovq alloc_limit(%rip), %rdx\n";
+  outputFile << "\tsubq %rax, %rdx\n\tsarq $3, %rdx\n\tdecq %rdx\n";
+  outputFile << "\tcmpq %rdx, %rcx\n\tjge " << slow << "\n";
+  outputFile << "\tleaq 8(%rax,%rcx,8), %rdx\n\tmovq %rdx, alloc_ptr(%rip)\n";
+  outputFile << "\tmovq %rcx, (%rax)\n";
+  // set the object's bit in the collector's start bitmap
+  outputFile << "\tmovq %rax, %rdx\n\tshrq $3, %rdx\n\tmovq %rdx, %r8\n\tshrq $6, %r8\n";
+  outputFile << "\txorl %r9d, %r9d\n\tbtsq %rdx, %r9\n";
+  outputFile << "\tmovq alloc_starts_base(%rip), %r10\n\torq %r9, (%r10,%r8,8)\n";
+  outputFile << "\tleaq 8(%rax), %rdx\n";
+  outputFile << fill << ":\n\tmovq %rsi, (%rdx)\n\taddq $8, %rdx\n\tdecq %rcx\n\tjnz " << fill << "\n";
+  outputFile << "\tjmp " << done << "\n";
+  outputFile << slow << ":\n\tcall allocate\n";
+  outputFile << done << ":\n";
+  return done;
+}
+
+/*
+ * Card-marking write barrier for the runtime's generational
+ * collector, emitted after a store that isn't to the stack: sets the
+ * card (512 bytes, CARD_SHIFT in the runtime) of the word stored to,
+ * so the next minor gc looks there for pointers into the nursery.
+ * Numbers and labels can't be such pointers, so registers holding
+ * an encoded number skip it, and constants don't get one at all.
+ * Every register may be live here, so rax is kept in memory while
+ * the barrier uses it; nothing is live in the flags between
+ * instructions.
+ */
+void emit_write_barrier(ostream &outputFile, L1::Store *store) {
+  if (!store->rhs.r || store->lhs.value.name == "rsp") {
+    return;
+  }
+  string id = to_string(barrier_sites++);
+  string restore = ".Lbarrier_restore_" + id;
+  string done = ".Lbarrier_done_" + id;
+
+  outputFile << "\ttestq $1, %" << store->rhs.name << "\n\tjnz " << done << "\n";
+  outputFile << "\tmovq %rax, gc_barrier_scratch(%rip)\n";
+  outputFile << "\tleaq " << store->lhs.offset_int << "(%" << store->lhs.value.name << "), %rax\n";
+  outputFile << "\tsubq gc_cards_low(%rip), %rax\n\tcmpq gc_cards_span(%rip), %rax\n";
+  outputFile << "\tjae " << restore << "\n";
+  outputFile << "\tshrq $9, %rax\n\taddq gc_cards(%rip), %rax\n\tmovb $1, (%rax)\n";
+  outputFile << restore << ":\n\tmovq gc_barrier_scratch(%rip), %rax\n";
+  outputFile << done << ":\n";
+}
+
+// the jcc taken exactly when the given one isn't
+const map<string, string> inverse_jumps = {
+  {"jl ", "jge "}, {"jge ", "jl "}, {"jle ", "jg "}, {"jg ", "jle "}, {"je ", "jne "}
+};
+
+/*
+ * Jumps to label, unless it is the label control falls through to.
+ */
+void emit_jump(ostream &outputFile, const string &label, const string &next_label) {
+  if (label == next_label) {
+    return;
+  }
+  outputFile << "\tjmp " << label << "\n";
+  emitted_branches++;
+}
+
+/*
+ * Moves rsp by bytes, unless there is nothing to move it by.
+ */
+void emit_stack_adjustment(ostream &outputFile, string op, int64_t bytes) {
+  if (bytes == 0) {
+    L1::peephole_hits["zero stack adjustment"]++;
+    return;
+  }
+  outputFile << "\t" << op << " $" << bytes << ", %rsp\n";
+}
+
+/*
+ * Immediate-aware instruction selection: the cheaper encodings for
+ * moves, arithmetic and comparisons with a constant operand. Each
+ * one counts in selection_hits when it fires. All of them may set
+ * the flags differently, which is fine as nothing is live in the
+ * flags between L1 instructions.
+ */
+map<string, int64_t> selection_hits;
+
+const map<string, string> registers_32 = {
+  {"rax", "eax"}, {"rbx", "ebx"}, {"rcx", "ecx"}, {"rdx", "edx"},
+  {"rsi", "esi"}, {"rdi", "edi"}, {"rbp", "ebp"}, {"r8", "r8d"},
+  {"r9", "r9d"}, {"r10", "r10d"}, {"r11", "r11d"}, {"r12", "r12d"},
+  {"r13", "r13d"}, {"r14", "r14d"}, {"r15", "r15d"}
+};
+
+// whether item is a number, which goes in value
+bool immediate(const L1::L1_item &item, int64_t &value) {
+  if (item.r || item.name.empty() || item.name[0] == '_') {
+    return false;
+  }
+  value = strtoll(item.name.c_str(), NULL, 10);
+  return true;
+}
+
+void emit_assignment(ostream &outputFile, L1::Assignment *assn) {
+  int64_t value;
+  if (immediate(assn->rhs, value) && registers_32.count(assn->lhs.name)) {
+    string lhs_32 = registers_32.at(assn->lhs.name);
+    if (value == 0) {
+      selection_hits["zero with xorl"]++;
+      outputFile << "\txorl %" << lhs_32 << ", %" << lhs_32 << "\n";
+      return;
+    }
+    if (value > 0 && value <= UINT32_MAX) {
+      // writing the low half zeroes the rest
+      selection_hits["movl for 32 bit constant"]++;
+      outputFile << "\tmovl $" << value << ", %" << lhs_32 << "\n";
+      return;
+    }
+  }
+  outputFile << "\tmovq " << wrap_arg(assn->rhs) << ", " << wrap_arg(assn->lhs) << "\n";
+}
+
+/*
+ * Returns false if aop has no cheaper form than the plain one.
+ */
+bool emit_arithmetic_immediate(ostream &outputFile, L1::ArithmeticOperation *aop) {
+  int64_t value;
+  if (!immediate(aop->rhs, value)) {
+    return false;
+  }
+  string lhs = wrap_arg(aop->lhs);
+  switch (aop->op) {
+    case L1::plusequal:
+    case L1::minusequal: {
+      int64_t delta = aop->op == L1::plusequal ? value : -value;
+      if (delta == 1 || delta == -1) {
+        selection_hits["incq/decq"]++;
+        outputFile << "\t" << (delta == 1 ? "incq " : "decq ") << lhs << "\n";
+        return true;
+      }
+      return false;
+    }
+    case L1::timesequal: {
+      if (value == 1) {
+        selection_hits["multiply by 1"]++;
+        return true;
+      }
+      if (value == 0 && registers_32.count(aop->lhs.name)) {
+        string lhs_32 = registers_32.at(aop->lhs.name);
+        selection_hits["multiply by 0"]++;
+        outputFile << "\txorl %" << lhs_32 << ", %" << lhs_32 << "\n";
+        return true;
+      }
+      if (value > 1 && (value & (value - 1)) == 0) {
+        int64_t shift = 0;
+        while (((int64_t)1 << shift) != value) {
+          shift++;
+        }
+        selection_hits["salq for power of 2"]++;
+        outputFile << "\tsalq $" << shift << ", " << lhs << "\n";
+        return true;
+      }
+      if (value == 3 || value == 5 || value == 9) {
+        selection_hits["leaq for 3, 5, 9"]++;
+        outputFile << "\tleaq (" << lhs << "," << lhs << "," << value - 1 << "), " << lhs << "\n";
+        return true;
+      }
+      return false;
+    }
+    default:
+      return false;
+  }
+}
+
+/*
+ * Sets the flags for comparing rhs against lhs, as cmpq lhs, rhs
+ * would.
+ */
+void emit_compare(ostream &outputFile, const L1::L1_item &lhs, const L1::L1_item &rhs) {
+  int64_t value;
+  if (immediate(lhs, value) && value == 0 && rhs.r) {
+    selection_hits["testq for compare with 0"]++;
+    outputFile << "\ttestq " << wrap_arg(rhs) << ", " << wrap_arg(rhs) << "\n";
+    return;
+  }
+  outputFile << "\tcmpq " << wrap_arg(lhs) << ", " << wrap_arg(rhs) << "\n";
+}
+
+/*
+ * The table the collector walks the stack with: one entry per
+ * return address, in address order, each pointing at the list of
+ * frame words live there. An entry with a live count of -1 covers
+ * the whole frame.
+ */
+void emit_stack_maps(ostream &outputFile) {
+  outputFile << "\n\t.data\n\t.p2align 3\n\t.globl stack_map_count\nstack_map_count:\n";
+  outputFile << "\t.quad " << stack_map_entries.size() << "\n";
+  outputFile << "\t.globl stack_maps\nstack_maps:\n";
+  for (int64_t k = 0; k < (int64_t)stack_map_entries.size(); k++) {
+    L1::StackMap &map = stack_map_entries[k].second;
+    int64_t live_count = map.conservative ? -1 : map.live_slots.size();
+    outputFile << "\t.quad " << stack_map_entries[k].first << ", " << map.frame_words << ", "
+               << map.live_registers << ", " << live_count << ", .Lstack_map_slots_" << k << "\n";
+  }
+  for (int64_t k = 0; k < (int64_t)stack_map_entries.size(); k++) {
+    outputFile << ".Lstack_map_slots_" << k << ":\n";
+    for (auto slot : stack_map_entries[k].second.live_slots) {
+      outputFile << "\t.quad " << slot << "\n";
+    }
+  }
+}
+
+void compile_L1(L1::Program p, ostream &outputFile) {
   register_map.insert(pair<string, string>("r10", "r10b"));
   register_map.insert(pair<string, string>("r11", "r11b"));
   register_map.insert(pair<string, string>("r12", "r12b"));
@@ -45,304 +282,333 @@ void compile_L1(L1::Program p) {
   register_map.insert(pair<string, string>("rdx", "dl"));
   register_map.insert(pair<string, string>("rsi", "sil"));
 
-  ofstream outputFile;
-  outputFile.open("prog.S");
   outputFile << "\t.text\n\t.globl go\ngo:\n\tpushq %rbx\n\tpushq %rbp\n\tpushq %r12\n\tpushq %r13\n\tpushq %r14\n\tpushq %r15\n\n\tcall ";
-  outputFile << p.entryPointLabel.replace(0,1,"_") << "\n" << endl;
+  outputFile << p.entryPointLabel.replace(0,1,"_") << "\n\n";
   outputFile << "\n\tpopq %r15\n\tpopq %r14\n\tpopq %r13\n\tpopq %r12\n\tpopq %rbp\n\tpopq %rbx\n\n\tretq\n";
 
+  set<string> return_labels = L1::stored_labels(p);
+
   /* Generate x86_64 code
    */
   for (auto f : p.functions){
+    L1::layout_blocks(f);
+    L1::peephole(f);
+    map<L1::Instruction *, L1::StackMap> stack_maps = L1::compute_stack_maps(f, return_labels);
     outputFile << f->name.replace(0,1,"_") << ":\n";
-    outputFile << "\tsubq $" << f->locals * 8 << ", %rsp\n";
-    for (L1::Instruction* i : f->instructions){
-      if (L1::Load *load = dynamic_cast<L1::Load *>(i)) {
-        outputFile << "\tmovq " << load->rhs.offset_int << "(" << wrap_arg(load->rhs.value) << "), " << wrap_arg(load->lhs) << endl;
+    emit_stack_adjustment(outputFile, "subq", f->locals * 8);
+    for (int64_t k = 0; k < (int64_t)f->instructions.size(); k++){
+      L1::Instruction *i = f->instructions[k];
+
+      // the label control falls through to, if i jumps nowhere
+      string next_label;
+      if (k + 1 < (int64_t)f->instructions.size() && f->instructions[k + 1]->opcode == L1::label_op) {
+        next_label = static_cast<L1::Label *>(f->instructions[k + 1])->name;
       }
-      else if (L1::Store *store = dynamic_cast<L1::Store *>(i)) {
-        outputFile << "\tmovq " << wrap_arg(store->rhs) << ", " << store->lhs.offset_int << "(" << wrap_arg(store->lhs.value) << ")\n";
-      } 
-      else if (L1::Assignment *assn = dynamic_cast<L1::Assignment *>(i)) {
-        outputFile << "\tmovq " << wrap_arg(assn->rhs) << ", " << wrap_arg(assn->lhs) << "\n";
-      } 
-      else if (L1::ReturnCall *ret = dynamic_cast<L1::ReturnCall *>(i)) {
-        int n_stack_args = 0;
-        if (f->arguments > 6) {
-          n_stack_args = f->arguments - 6;
+
+      switch (i->opcode) {
+        case L1::load_op: {
+          L1::Load *load = static_cast<L1::Load *>(i);
+          outputFile << "\tmovq " << load->rhs.offset_int << "(" << wrap_arg(load->rhs.value) << "), " << wrap_arg(load->lhs) << "\n";
+          break;
         }
-        outputFile << "\taddq $" << f->locals * 8 + n_stack_args * 8 << ", %rsp\n";
-        outputFile << "\tretq\n";
-      }
-      else if (L1::ArithmeticOperation *aop = dynamic_cast<L1::ArithmeticOperation *>(i)) {
-        std::string aop_string;
-        switch(aop->op) {
-          case L1::plusequal:
-            aop_string = "addq ";
-            break;
-          case L1::minusequal:
-            aop_string = "subq ";
-            break;
-          case L1::timesequal:
-            aop_string = "imulq ";
-            break;
-          case L1::andequal:
-            aop_string = "andq ";
-            break;
-          default:
-            break;
+        case L1::store_op: {
+          L1::Store *store = static_cast<L1::Store *>(i);
+          outputFile << "\tmovq " << wrap_arg(store->rhs) << ", " << store->lhs.offset_int << "(" << wrap_arg(store->lhs.value) << ")\n";
+          emit_write_barrier(outputFile, store);
+          break;
         }
-        outputFile << "\t" << aop_string << wrap_arg(aop->rhs) << ", " << wrap_arg(aop->lhs) << endl;
-      } 
-      else if (L1::MemoryArithmeticOperation *maop = dynamic_cast<L1::MemoryArithmeticOperation *>(i)) {
-        std::string maop_string;
-        switch(maop->op) {
-          case L1::plusequal:
-            maop_string = "addq ";
-            break;
-          case L1::minusequal:
-            maop_string = "subq ";
-            break;
-          default:
-            break;
+        case L1::assignment_op: {
+          emit_assignment(outputFile, static_cast<L1::Assignment *>(i));
+          break;
         }
-        outputFile << "\t" << maop_string <<  wrap_arg(maop->rhs) << ", " << maop->lhs.offset_int << "(%" << maop->lhs.value.name << ")\n";
-      }
-      else if (L1::MemoryArithmeticOperation2 *maop = dynamic_cast<L1::MemoryArithmeticOperation2 *>(i)) {
-        std::string maop_string;
-        switch(maop->op) {
-          case L1::plusequal:
-            maop_string = "addq ";
-            break;
-          case L1::minusequal:
-            maop_string = "subq ";
-            break;
-          default:
-            break;
+        case L1::return_op: {
+          int n_stack_args = 0;
+          if (f->arguments > 6) {
+            n_stack_args = f->arguments - 6;
+          }
+          emit_stack_adjustment(outputFile, "addq", f->locals * 8 + n_stack_args * 8);
+          outputFile << "\tretq\n";
+          break;
         }
-        outputFile << "\t" << maop_string << maop->rhs.offset_int << "(%" << maop->rhs.value.name << "), " << wrap_arg(maop->lhs) << endl;
-      }
-      else if (L1::ShiftOperation *sop = dynamic_cast<L1::ShiftOperation *>(i)) {
-        std::string sop_string;
-        switch(sop->op) {
-          case L1::lshift:
-            sop_string = "salq ";
-            break;
-          case L1::rshift:
-            sop_string = "sarq ";
-            break;
-          default:
+        case L1::arithmetic_op: {
+          L1::ArithmeticOperation *aop = static_cast<L1::ArithmeticOperation *>(i);
+          if (emit_arithmetic_immediate(outputFile, aop)) {
             break;
+          }
+          std::string aop_string;
+          switch(aop->op) {
+            case L1::plusequal:
+              aop_string = "addq ";
+              break;
+            case L1::minusequal:
+              aop_string = "subq ";
+              break;
+            case L1::timesequal:
+              aop_string = "imulq ";
+              break;
+            case L1::andequal:
+              aop_string = "andq ";
+              break;
+            default:
+              break;
+          }
+          outputFile << "\t" << aop_string << wrap_arg(aop->rhs) << ", " << wrap_arg(aop->lhs) << "\n";
+          break;
         }
-        outputFile << "\t" << sop_string << sop->rhs.name << ", " << wrap_arg(sop->lhs) << endl;
-      } 
-      else if (L1::ComparisonOperation *comp = dynamic_cast<L1::ComparisonOperation *>(i)) {
-        std::string lhs;
-        std::string c_lhs;
-        std::string c_rhs;
-        std::string cop;
-        std::string eightbitreg;
-        bool reverse = false;
-
-        if (!comp->cexp.lhs.r && !comp->cexp.rhs.r) {
-          // both are numbers. evaluate at compile time.
-          int lhs_int = std::stoi(comp->cexp.lhs.name);
-          int rhs_int = std::stoi(comp->cexp.rhs.name);
-          bool result;
-          switch(comp->cexp.op) {
-            case L1::lessthan:
-              result = lhs_int < rhs_int;
+        case L1::memory_arithmetic_op: {
+          L1::MemoryArithmeticOperation *maop = static_cast<L1::MemoryArithmeticOperation *>(i);
+          std::string maop_string;
+          switch(maop->op) {
+            case L1::plusequal:
+              maop_string = "addq ";
               break;
-            case L1::lessthanorequal:
-              result = lhs_int <= rhs_int;
+            case L1::minusequal:
+              maop_string = "subq ";
               break;
-            case L1::equal:
-              result = lhs_int == rhs_int;
+            default:
               break;
-            default: break;
           }
-          outputFile << "\tmovq $" << result << ", " << wrap_arg(comp->lhs) << endl;
-        } else {
-
-          if (!comp->cexp.lhs.r) {
-            // comparison with a constant
-            reverse = true;
+          outputFile << "\t" << maop_string <<  wrap_arg(maop->rhs) << ", " << maop->lhs.offset_int << "(%" << maop->lhs.value.name << ")\n";
+          break;
+        }
+        case L1::memory_arithmetic2_op: {
+          L1::MemoryArithmeticOperation2 *maop = static_cast<L1::MemoryArithmeticOperation2 *>(i);
+          std::string maop_string;
+          switch(maop->op) {
+            case L1::plusequal:
+              maop_string = "addq ";
+              break;
+            case L1::minusequal:
+              maop_string = "subq ";
+              break;
+            default:
+              break;
           }
-          if (reverse) {
-            c_lhs = wrap_arg(comp->cexp.lhs);
-            c_rhs = wrap_arg(comp->cexp.rhs);
-          } else {
-            c_lhs = wrap_arg(comp->cexp.rhs);
-            c_rhs = wrap_arg(comp->cexp.lhs);
+          outputFile << "\t" << maop_string << maop->rhs.offset_int << "(%" << maop->rhs.value.name << "), " << wrap_arg(maop->lhs) << "\n";
+          break;
+        }
+        case L1::shift_op: {
+          L1::ShiftOperation *sop = static_cast<L1::ShiftOperation *>(i);
+          std::string sop_string;
+          switch(sop->op) {
+            case L1::lshift:
+              sop_string = "salq ";
+              break;
+            case L1::rshift:
+              sop_string = "sarq ";
+              break;
+            default:
+              break;
           }
+          outputFile << "\t" << sop_string << sop->rhs.name << ", " << wrap_arg(sop->lhs) << "\n";
+          break;
+        }
+        case L1::comparison_op: {
+          L1::ComparisonOperation *comp = static_cast<L1::ComparisonOperation *>(i);
+          std::string lhs;
+          L1::L1_item c_lhs;
+          L1::L1_item c_rhs;
+          std::string cop;
+          std::string eightbitreg;
+          bool reverse = false;
 
-          if (reverse) {
+          if (!comp->cexp.lhs.r && !comp->cexp.rhs.r) {
+            // both are numbers. evaluate at compile time.
+            int lhs_int = std::stoi(comp->cexp.lhs.name);
+            int rhs_int = std::stoi(comp->cexp.rhs.name);
+            bool result;
             switch(comp->cexp.op) {
               case L1::lessthan:
-                cop = "setg ";
+                result = lhs_int < rhs_int;
                 break;
               case L1::lessthanorequal:
-                cop = "setge ";
+                result = lhs_int <= rhs_int;
                 break;
               case L1::equal:
-                cop = "sete ";
-                break;
-              default:
+                result = lhs_int == rhs_int;
                 break;
+              default: break;
             }
+            outputFile << "\tmovq $" << result << ", " << wrap_arg(comp->lhs) << "\n";
           } else {
-            switch(comp->cexp.op) {
-              case L1::lessthan:
-                cop = "setl ";
-                break;
-              case L1::lessthanorequal:
-                cop = "setle ";
-                break;
-              case L1::equal:
-                cop = "sete ";
-                break;
-              default: break;
+
+            if (!comp->cexp.lhs.r) {
+              // comparison with a constant
+              reverse = true;
+            }
+            if (reverse) {
+              c_lhs = comp->cexp.lhs;
+              c_rhs = comp->cexp.rhs;
+            } else {
+              c_lhs = comp->cexp.rhs;
+              c_rhs = comp->cexp.lhs;
             }
-          }
 
-          eightbitreg = register_map.find(comp->lhs.name)->second;
+            if (reverse) {
+              switch(comp->cexp.op) {
+                case L1::lessthan:
+                  cop = "setg ";
+                  break;
+                case L1::lessthanorequal:
+                  cop = "setge ";
+                  break;
+                case L1::equal:
+                  cop = "sete ";
+                  break;
+                default:
+                  break;
+              }
+            } else {
+              switch(comp->cexp.op) {
+                case L1::lessthan:
+                  cop = "setl ";
+                  break;
+                case L1::lessthanorequal:
+                  cop = "setle ";
+                  break;
+                case L1::equal:
+                  cop = "sete ";
+                  break;
+                default: break;
+              }
+            }
 
-          outputFile << "\tcmpq " << c_lhs << ", " << c_rhs << "\n\t" << cop << "%" << eightbitreg << "\n\tmovzbq %" << eightbitreg << ", %" << comp->lhs.name << endl;
-        }
-      }
-      else if (L1::FunctionCall *fCall = dynamic_cast<L1::FunctionCall *>(i)) {
-        std::string f_name = fCall->function_name.name;
-        for(std::map<std::string,std::string>::iterator iter = register_map.begin(); iter != register_map.end(); ++iter)
-        {
-          std::string k = iter->first;
-          if (k == f_name) {
-            f_name = "*%" + f_name;
-            break;
+            eightbitreg = register_map.find(comp->lhs.name)->second;
+
+            emit_compare(outputFile, c_lhs, c_rhs);
+            outputFile << "\t" << cop << "%" << eightbitreg << "\n\tmovzbq %" << eightbitreg << ", %" << comp->lhs.name << "\n";
           }
+          break;
         }
-        int n_stack_args = 0;
-        if (fCall->n_args > 6) {
-          n_stack_args = fCall->n_args - 6;
-        }
-        outputFile << "\tsubq $" << n_stack_args * 8 + 8 << ", %rsp\n\tjmp " << f_name << endl;
-      }
-      else if (L1::RuntimeCall *rCall = dynamic_cast<L1::RuntimeCall *>(i)) {
-        outputFile << "\tcall " << rCall->function_name.name << endl;
-      }
-      else if (L1::Label *lbl = dynamic_cast<L1::Label *>(i)) {
-        outputFile << lbl->name << ":\n";
-      }
-      else if (L1::WawweOperation *wawwe = dynamic_cast<L1::WawweOperation *>(i)) {
-        outputFile << "\tlea (%" << wawwe->start.name << ", %" << wawwe->mult.name << ", " << wawwe->e << "), %" << wawwe->lhs.name << endl;
-      }
-      else if (L1::CjumpOperation *cj = dynamic_cast<L1::CjumpOperation *>(i)) {
-        bool reverse = !cj->cexp.lhs.r;
-        std::string jmp_string;
-        std::string cmp_lhs;
-        std::string cmp_rhs;
-
-        if (!cj->cexp.lhs.r && !cj->cexp.rhs.r) {
-          // number to number comparison
-          int lhs_int = std::stoi(cj->cexp.lhs.name);
-          int rhs_int = std::stoi(cj->cexp.lhs.name);
-          bool correct = false;
-          switch(cj->cexp.op) {
-            case L1::lessthan:
-              correct = lhs_int < rhs_int;
-              break;
-            case L1::lessthanorequal:
-              correct = lhs_int <= rhs_int;
-              break;
-            case L1::equal:
-              correct = lhs_int == rhs_int;
+        case L1::function_call_op: {
+          L1::FunctionCall *fCall = static_cast<L1::FunctionCall *>(i);
+          std::string f_name = fCall->function_name.name;
+          for(std::map<std::string,std::string>::iterator iter = register_map.begin(); iter != register_map.end(); ++iter)
+          {
+            std::string k = iter->first;
+            if (k == f_name) {
+              f_name = "*%" + f_name;
               break;
-            default: break;
+            }
           }
-          if (correct) {
-            outputFile << "\tjmp " << cj->then_label << endl;
-          } else {
-            outputFile << "\tjmp " << cj->else_label << endl;
+          int n_stack_args = 0;
+          if (fCall->n_args > 6) {
+            n_stack_args = fCall->n_args - 6;
           }
-        } else {
-        
-          if (reverse) {
-            cmp_lhs = wrap_arg(cj->cexp.lhs);
-            cmp_rhs = wrap_arg(cj->cexp.rhs);
+          outputFile << "\tsubq $" << n_stack_args * 8 + 8 << ", %rsp\n\tjmp " << f_name << "\n";
+          break;
+        }
+        case L1::runtime_call_op: {
+          L1::RuntimeCall *rCall = static_cast<L1::RuntimeCall *>(i);
+          if (rCall->function_name.name == "allocate" && rCall->n_args == 3) {
+            // profiled allocation, rdx holds the allocation site
+            string return_label = ".Lalloc_done_" + to_string(allocate_sites++);
+            outputFile << "\tcall allocate_site\n" << return_label << ":\n";
+            stack_map_entries.push_back(make_pair(return_label, stack_maps[i]));
+          } else if (rCall->function_name.name == "allocate") {
+            string return_label = emit_inline_allocate(outputFile);
+            stack_map_entries.push_back(make_pair(return_label, stack_maps[i]));
           } else {
-            cmp_lhs = wrap_arg(cj->cexp.rhs);
-            cmp_rhs = wrap_arg(cj->cexp.lhs);
+            outputFile << "\tcall " << rCall->function_name.name << "\n";
+          }
+          break;
+        }
+        case L1::label_op: {
+          L1::Label *lbl = static_cast<L1::Label *>(i);
+          outputFile << lbl->name << ":\n";
+          if (stack_maps.count(i)) {
+            stack_map_entries.push_back(make_pair(lbl->name, stack_maps[i]));
           }
+          break;
+        }
+        case L1::wawwe_op: {
+          L1::WawweOperation *wawwe = static_cast<L1::WawweOperation *>(i);
+          outputFile << "\tlea (%" << wawwe->start.name << ", %" << wawwe->mult.name << ", " << wawwe->e << "), %" << wawwe->lhs.name << "\n";
+          break;
+        }
+        case L1::cjump_op: {
+          L1::CjumpOperation *cj = static_cast<L1::CjumpOperation *>(i);
+          bool reverse = !cj->cexp.lhs.r;
+          std::string jmp_string;
+          L1::L1_item cmp_lhs;
+          L1::L1_item cmp_rhs;
 
-          if (reverse) {
+          if (!cj->cexp.lhs.r && !cj->cexp.rhs.r) {
+            // number to number comparison
+            int lhs_int = std::stoi(cj->cexp.lhs.name);
+            int rhs_int = std::stoi(cj->cexp.lhs.name);
+            bool correct = false;
             switch(cj->cexp.op) {
               case L1::lessthan:
-                jmp_string = "jg ";
+                correct = lhs_int < rhs_int;
                 break;
               case L1::lessthanorequal:
-                jmp_string = "jge ";
+                correct = lhs_int <= rhs_int;
                 break;
               case L1::equal:
-                jmp_string = "je ";
+                correct = lhs_int == rhs_int;
                 break;
               default: break;
             }
+            emit_jump(outputFile, correct ? cj->then_label : cj->else_label, next_label);
           } else {
-            switch(cj->cexp.op) {
-              case L1::lessthan:
-                jmp_string = "jl ";
-                break;
-              case L1::lessthanorequal:
-                jmp_string = "jle ";
-                break;
-              case L1::equal:
-                jmp_string = "je ";
-                break;
-              default: break;
+
+            if (reverse) {
+              cmp_lhs = cj->cexp.lhs;
+              cmp_rhs = cj->cexp.rhs;
+            } else {
+              cmp_lhs = cj->cexp.rhs;
+              cmp_rhs = cj->cexp.lhs;
+            }
+
+            if (reverse) {
+              switch(cj->cexp.op) {
+                case L1::lessthan:
+                  jmp_string = "jg ";
+                  break;
+                case L1::lessthanorequal:
+                  jmp_string = "jge ";
+                  break;
+                case L1::equal:
+                  jmp_string = "je ";
+                  break;
+                default: break;
+              }
+            } else {
+              switch(cj->cexp.op) {
+                case L1::lessthan:
+                  jmp_string = "jl ";
+                  break;
+                case L1::lessthanorequal:
+                  jmp_string = "jle ";
+                  break;
+                case L1::equal:
+                  jmp_string = "je ";
+                  break;
+                default: break;
+              }
+            }
+            emit_compare(outputFile, cmp_lhs, cmp_rhs);
+            if (cj->then_label == next_label) {
+              // fall through to then, jump to else on the opposite
+              outputFile << "\t" << inverse_jumps.at(jmp_string) << " " << cj->else_label << "\n";
+              emitted_branches++;
+            } else {
+              outputFile << "\t" << jmp_string << " " << cj->then_label << "\n";
+              emitted_branches++;
+              emit_jump(outputFile, cj->else_label, next_label);
             }
           }
-          outputFile << "\tcmpq " << cmp_lhs << ", " << cmp_rhs << "\n\t" << jmp_string << " " << cj->then_label << "\n\tjmp " << cj->else_label << endl;
+          break;
+        }
+        case L1::goto_op: {
+          L1::GotoOperation *gt = static_cast<L1::GotoOperation *>(i);
+          emit_jump(outputFile, gt->lbl.name, next_label);
+          break;
         }
-      }
-      else if (L1::GotoOperation *gt = dynamic_cast<L1::GotoOperation *>(i)) {
-        outputFile << "\tjmp " << gt->lbl.name << endl;
-        outputFile << "\tjmp " << gt->lbl.name << endl;
       }
     }
   }
 
-  outputFile.close();
-
-}
-
-int main(
-  int argc, 
-  char **argv
-  ){
-  bool verbose;
-
-  /* Check the input.
-   */
-  if( argc < 2 ) {
-    std::cerr << "Usage: " << argv[ 0 ] << " SOURCE [-v]" << std::endl;
-    return 1;
-  }
-  int32_t opt;
-  while ((opt = getopt(argc, argv, "v")) != -1) {
-    switch (opt){
-      case 'v':
-        verbose = true;
-        break ;
-
-      default:
-        std::cerr << "Usage: " << argv[ 0 ] << "[-v] SOURCE" << std::endl;
-        return 1;
-    }
-  }
-
-  /* Parse the L1 program.
-   */
-  L1::Program p = L1::L1_parse_file(argv[optind]);
-  compile_L1(p);
-
-  return 0;
+  emit_stack_maps(outputFile);
 }
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <ostream>
+#include <stdint.h>
+
+#include "L1.h"
+
+// the jumps compile_L1 has emitted for gotos and cjumps
+extern int64_t emitted_branches;
+
+// how often each cheaper encoding for a constant operand was picked
+extern std::map<std::string, int64_t> selection_hits;
+
+void compile_L1(L1::Program p, std::ostream &outputFile);
@@ -0,0 +1,94 @@
+#include <string>
+#include <map>
+#include <stdexcept>
+#include <cstring>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "jit.h"
+
+using namespace std;
+
+/*
+ * The runtime, built with -DJIT (see lib/runtime.c).
+ */
+struct RuntimeSymbol {
+  const char *name;
+  void *address;
+};
+
+extern "C" {
+  extern RuntimeSymbol runtime_symbols[];
+  extern int64_t stack_map_count;
+  extern void *stack_maps;
+  extern void *go;
+  int runtime_main();
+}
+
+namespace L1 {
+
+  int64_t page_align(int64_t bytes) {
+    int64_t page = sysconf(_SC_PAGESIZE);
+    return (bytes + page - 1) / page * page;
+  }
+
+  int run(const ObjectCode &object) {
+    map<string, uint8_t *> runtime;
+    for (RuntimeSymbol *s = runtime_symbols; s->name != NULL; s++) {
+      runtime[s->name] = (uint8_t *)s->address;
+    }
+
+    /* .text, then .data on the pages after it, both in the low 2GB
+     */
+    int64_t text_size = page_align(object.text.size());
+    int64_t data_size = page_align(object.data.size());
+    void *memory = mmap(NULL, text_size + data_size, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS | MAP_32BIT, -1, 0);
+    if (memory == MAP_FAILED) {
+      throw runtime_error("can't map memory for the program");
+    }
+    uint8_t *sections[2] = {(uint8_t *)memory, (uint8_t *)memory + text_size};
+    memcpy(sections[text_section], object.text.data(), object.text.size());
+    memcpy(sections[data_section], object.data.data(), object.data.size());
+
+    auto address = [&](const string &symbol) {
+      auto l = object.labels.find(symbol);
+      if (l != object.labels.end()) {
+        return sections[l->second.first] + l->second.second;
+      }
+      auto r = runtime.find(symbol);
+      if (r == runtime.end()) {
+        throw runtime_error("undefined symbol " + symbol);
+      }
+      return r->second;
+    };
+
+    for (auto r : object.relocations) {
+      uint8_t *place = sections[r.section] + r.offset;
+      int64_t value = (int64_t)address(r.symbol) + r.addend;
+      if (r.type == R_X86_64_PC32 || r.type == R_X86_64_PLT32) {
+        value -= (int64_t)place;
+      }
+      if (r.type == R_X86_64_64) {
+        memcpy(place, &value, 8);
+        continue;
+      }
+      if (value < INT32_MIN || value > INT32_MAX) {
+        throw runtime_error("relocation against " + r.symbol + " out of range");
+      }
+      int32_t value32 = value;
+      memcpy(place, &value32, 4);
+    }
+
+    if (mprotect(memory, text_size, PROT_READ | PROT_EXEC) != 0) {
+      throw runtime_error("can't make the program executable");
+    }
+
+    go = address("go");
+    stack_maps = address("stack_maps");
+    memcpy(&stack_map_count, address("stack_map_count"), 8);
+    return runtime_main();
+  }
+
+} // L1
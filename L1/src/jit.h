@@ -0,0 +1,17 @@
+#pragma once
+
+#include "assembler.h"
+
+namespace L1 {
+
+  /*
+   * Loads object into memory, links it against the copy of the
+   * runtime built into this binary and runs it as a.out would,
+   * returning what the runtime's main() returns. Needs the binary
+   * and the program within 2GB of each other and of address 0 (the
+   * code uses RIP-relative and 32 bit absolute addresses), so it
+   * has to be linked with -no-pie.
+   */
+  int run(const ObjectCode &object);
+
+} // L1
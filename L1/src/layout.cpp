@@ -0,0 +1,114 @@
+#include <string>
+#include <vector>
+#include <map>
+#include <stdint.h>
+
+#include "layout.h"
+
+using namespace std;
+
+namespace L1 {
+
+  struct Block {
+    vector<Instruction *> instructions;
+    bool placed = false;
+  };
+
+  /*
+   * Whether control can go from i to the instruction after it.
+   */
+  bool falls_through(Instruction *i) {
+    switch (i->opcode) {
+      case goto_op:
+      case cjump_op:
+      case return_op:
+        return false;
+      case runtime_call_op:
+        return static_cast<RuntimeCall *>(i)->function_name.name != "array_error";
+      default:
+        return true;
+    }
+  }
+
+  /*
+   * The labels i jumps to, the one to put after it first.
+   */
+  vector<string> preferred_successors(Instruction *i) {
+    switch (i->opcode) {
+      case goto_op:
+        return {static_cast<GotoOperation *>(i)->lbl.name};
+      case cjump_op: {
+        CjumpOperation *cj = static_cast<CjumpOperation *>(i);
+        return {cj->else_label, cj->then_label};
+      }
+      default:
+        return {};
+    }
+  }
+
+  void layout_blocks(Function *f) {
+    // split f at its labels, dropping what follows a jump or return
+    // until the next label
+    vector<Block> blocks(1);
+    map<string, int64_t> labels;
+    bool reachable = true;
+    for (auto i : f->instructions) {
+      if (i->opcode == label_op) {
+        if (!blocks.back().instructions.empty()) {
+          blocks.push_back(Block());
+        }
+        labels[static_cast<Label *>(i)->name] = blocks.size() - 1;
+        reachable = true;
+      }
+      if (reachable) {
+        blocks.back().instructions.push_back(i);
+        reachable = falls_through(i);
+      }
+    }
+
+    vector<Instruction *> laid_out;
+    int64_t next_unplaced = 0;
+    int64_t b = 0;
+    while (b >= 0) {
+      Block &block = blocks[b];
+      block.placed = true;
+      laid_out.insert(laid_out.end(), block.instructions.begin(), block.instructions.end());
+
+      // a block falling off its end has to be followed by the next
+      // one, or jump to it
+      Instruction *last = block.instructions.empty() ? NULL : block.instructions.back();
+      bool open = last == NULL || falls_through(last);
+      int64_t next = -1;
+      if (open && b + 1 < (int64_t)blocks.size()) {
+        if (!blocks[b + 1].placed) {
+          next = b + 1;
+        } else {
+          GotoOperation *gt = new GotoOperation();
+          gt->lbl.name = static_cast<Label *>(blocks[b + 1].instructions[0])->name;
+          laid_out.push_back(gt);
+        }
+      } else if (!open) {
+        for (auto label : preferred_successors(last)) {
+          auto target = labels.find(label);
+          if (target != labels.end() && !blocks[target->second].placed) {
+            next = target->second;
+            break;
+          }
+        }
+      }
+
+      // otherwise carry on in the original order
+      if (next < 0) {
+        while (next_unplaced < (int64_t)blocks.size() && blocks[next_unplaced].placed) {
+          next_unplaced++;
+        }
+        if (next_unplaced < (int64_t)blocks.size()) {
+          next = next_unplaced;
+        }
+      }
+      b = next;
+    }
+    f->instructions = laid_out;
+  }
+
+} // L1
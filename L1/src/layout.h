@@ -0,0 +1,19 @@
+#pragma once
+
+#include "L1.h"
+
+namespace L1 {
+
+  /*
+   * Reorders the basic blocks of f so that as many jumps as possible
+   * become fallthroughs: each block is followed by the block its
+   * goto goes to, or by the else (failing that, the then) block of
+   * its cjump, unless that block has already been placed. compile_L1
+   * then leaves out jumps to the next label and inverts a cjump
+   * whose then block comes next. Blocks that fall off their end keep
+   * their successor after them or get a goto to it. Unlabeled code
+   * after a jump or return can't run and is dropped.
+   */
+  void layout_blocks(Function *f);
+
+} // L1
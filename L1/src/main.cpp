@@ -0,0 +1,102 @@
+#include <iostream>
+#include <cstdlib>
+#include <stdint.h>
+#include <unistd.h>
+#include <sstream>
+#include <chrono>
+
+#include "parser.h"
+#include "compiler.h"
+#include "peephole.h"
+#include "assembler.h"
+#include "jit.h"
+#include "emitter.h"
+
+using namespace std;
+
+int main(
+  int argc, 
+  char **argv
+  ){
+  bool verbose = false;
+  bool object = false;
+  bool run = false;
+
+  /* Check the input.
+   */
+  if( argc < 2 ) {
+    std::cerr << "Usage: " << argv[ 0 ] << " SOURCE [-v] [-e | -r]" << std::endl;
+    return 1;
+  }
+  int32_t opt;
+  while ((opt = getopt(argc, argv, "ver")) != -1) {
+    switch (opt){
+      case 'v':
+        verbose = true;
+        break ;
+
+      case 'e':
+        object = true;
+        break ;
+
+      case 'r':
+        run = true;
+        break ;
+
+      default:
+        std::cerr << "Usage: " << argv[ 0 ] << "[-v] [-e | -r] SOURCE" << std::endl;
+        return 1;
+    }
+  }
+
+  /* Parse the L1 program.
+   */
+  auto start = chrono::steady_clock::now();
+  L1::Program p = L1::L1_parse_file(argv[optind]);
+  auto parsed = chrono::steady_clock::now();
+  if (!object && !run) {
+    Emitter outputFile("prog.S");
+    compile_L1(p, outputFile);
+    outputFile.close();
+  }
+  auto compiled = chrono::steady_clock::now();
+
+  /* With -e, assemble the program ourselves into prog.o instead
+   * of leaving prog.S to `as`. With -r, assemble it into memory
+   * and run it.
+   */
+  L1::ObjectCode code;
+  if (object || run) {
+    ostringstream assembly;
+    compile_L1(p, assembly);
+    compiled = chrono::steady_clock::now();
+    code = L1::assemble(assembly.str());
+  }
+  if (object) {
+    Emitter outputFile("prog.o");
+    L1::write_elf(code, outputFile);
+    outputFile.close();
+  }
+  auto assembled = chrono::steady_clock::now();
+
+  if (verbose) {
+    cerr << "parse: " << chrono::duration_cast<chrono::milliseconds>(parsed - start).count() << " ms\n";
+    cerr << "compile: " << chrono::duration_cast<chrono::milliseconds>(compiled - parsed).count() << " ms\n";
+    if (object || run) {
+      cerr << "assemble: " << chrono::duration_cast<chrono::milliseconds>(assembled - compiled).count() << " ms\n";
+    }
+    cerr << "branches: " << emitted_branches << "\n";
+    for (auto hits : L1::peephole_hits) {
+      cerr << "peephole " << hits.first << ": " << hits.second << "\n";
+    }
+    for (auto hits : selection_hits) {
+      cerr << "selection " << hits.first << ": " << hits.second << "\n";
+    }
+  }
+
+  if (run) {
+    return L1::run(code);
+  }
+
+  return 0;
+}
@@ -588,35 +588,54 @@ namespace L1 {
     > {};
 
   /*
-   * Data structures required to parse
+   * What a parse has read but not yet put into the program. Every
+   * parse gets its own, passed to the actions, so several parses
+   * can run at once.
    */
-  std::vector<L1_item> parsed_registers;
-  std::vector<L1_w> parsed_w_vals;
-  std::vector<int64_t> parsed_e_vals;
-  std::vector<L1_a> parsed_a_vals;
-  std::vector<L1_s> parsed_s_vals;
-  std::vector<L1_t> parsed_t_vals;
-  std::vector<L1_x> parsed_x_vals;
-  std::vector<L1_m> parsed_m_vals;
-  std::vector<L1_u> parsed_u_vals;
-  std::vector<int64_t> parsed_n_vals;
-  std::vector<MemoryReference> parsed_mem_refs;
-  L1::ArithmeticOperator current_aop;
-  L1::ShiftOperator current_sop;
-  L1_w load_lhs;
-  L1_w arithmetic_lhs;
-  L1_t arithmetic_rhs;
-  L1_w assignment_lhs;
-  L1_s assignment_rhs;
-  L1_item shift_rhs;
-  L1_w cmp_lhs;
-  L1_t current_cexp_lhs;
-  L1_t current_cexp_rhs;
-  L1::ComparisonOperator current_cop;
-  L1::ComparisonExpression current_cexp;
-  std::string cjump_then;
-  std::string cjump_else;
-  bool parsed_register = true;
+  struct ParseState {
+    std::vector<L1_item> parsed_registers;
+    std::vector<L1_w> parsed_w_vals;
+    std::vector<int64_t> parsed_e_vals;
+    std::vector<L1_a> parsed_a_vals;
+    std::vector<L1_s> parsed_s_vals;
+    std::vector<L1_t> parsed_t_vals;
+    std::vector<L1_x> parsed_x_vals;
+    std::vector<L1_m> parsed_m_vals;
+    std::vector<L1_u> parsed_u_vals;
+    std::vector<int64_t> parsed_n_vals;
+    std::vector<MemoryReference> parsed_mem_refs;
+    L1::ArithmeticOperator current_aop;
+    L1::ShiftOperator current_sop;
+    L1_w load_lhs;
+    L1_w arithmetic_lhs;
+    L1_t arithmetic_rhs;
+    L1_w assignment_lhs;
+    L1_s assignment_rhs;
+    L1_item shift_rhs;
+    L1_w cmp_lhs;
+    L1_t current_cexp_lhs;
+    L1_t current_cexp_rhs;
+    L1::ComparisonOperator current_cop;
+    L1::ComparisonExpression current_cexp;
+    std::string cjump_then;
+    std::string cjump_else;
+    bool parsed_register = true;
+
+    // the tokens of an instruction are no use once it is built
+    void clear_memory() {
+      parsed_registers.clear();
+      parsed_w_vals.clear();
+      parsed_e_vals.clear();
+      parsed_a_vals.clear();
+      parsed_s_vals.clear();
+      parsed_t_vals.clear();
+      parsed_x_vals.clear();
+      parsed_m_vals.clear();
+      parsed_u_vals.clear();
+      parsed_n_vals.clear();
+      parsed_mem_refs.clear();
+    }
+  };
 
   /*
    * Actions attached to grammar rules.
@@ -625,18 +644,18 @@ namespace L1 {
   struct action : pegtl::nothing< Rule > {};
 
   template<> struct action < label > {
-    static void apply( const pegtl::input & in, L1::Program & p){
+    static void apply( const pegtl::input & in, L1::Program & p, ParseState & state){
     }
   };
 
   template<> struct action < L1_e_rule > {
-    static void apply( const pegtl::input & in, L1::Program & p){
-      parsed_e_vals.push_back(std::stoi(in.string()));
+    static void apply( const pegtl::input & in, L1::Program & p, ParseState & state){
+      state.parsed_e_vals.push_back(std::stoi(in.string()));
     }
   };
 
   template<> struct action < function_name > {
-    static void apply( const pegtl::input & in, L1::Program & p){
+    static void apply( const pegtl::input & in, L1::Program & p, ParseState & state){
       L1::Function *newF = new L1::Function();
       newF->name = in.string();
       p.functions.push_back(newF);
@@ -644,122 +663,122 @@ namespace L1 {
   };
 
   template<> struct action < L1_wawwe_rule > {
-    static void apply( const pegtl::input & in, L1::Program & p){
+    static void apply( const pegtl::input & in, L1::Program & p, ParseState & state){
       L1::WawweOperation *wawwe = new L1::WawweOperation();
-      wawwe->lhs = parsed_w_vals[parsed_w_vals.size() - 3];
-      wawwe->start = parsed_w_vals[parsed_w_vals.size() - 2];
-      wawwe->mult = parsed_w_vals[parsed_w_vals.size() - 1];
-      wawwe->e = parsed_e_vals.back();
+      wawwe->lhs = state.parsed_w_vals[state.parsed_w_vals.size() - 3];
+      wawwe->start = state.parsed_w_vals[state.parsed_w_vals.size() - 2];
+      wawwe->mult = state.parsed_w_vals[state.parsed_w_vals.size() - 1];
+      wawwe->e = state.parsed_e_vals.back();
       p.functions.back()->instructions.push_back(wawwe);
     }
   };
 
   template<> struct action < L1_string_rule > {
-    static void apply( const pegtl::input & in, L1::Program & p){
+    static void apply( const pegtl::input & in, L1::Program & p, ParseState & state){
       L1_item i;
       i.name = in.string();
-      parsed_register = false;
-      parsed_registers.push_back(i);
+      state.parsed_register = false;
+      state.parsed_registers.push_back(i);
     }
   };
 
   template<> struct action < L1_label_rule > {
-    static void apply( const pegtl::input & in, L1::Program & p){
+    static void apply( const pegtl::input & in, L1::Program & p, ParseState & state){
       if (p.entryPointLabel.empty()){
         p.entryPointLabel = in.string();
       }
       L1_item i;
       i.name = in.string().replace(0,1,"_");
-      parsed_registers.push_back(i);
+      state.parsed_registers.push_back(i);
     }
   };
 
   template<> struct action < number > {
-    static void apply( const pegtl::input & in, L1::Program & p){
-      parsed_register = false;
+    static void apply( const pegtl::input & in, L1::Program & p, ParseState & state){
+      state.parsed_register = false;
     }
   };
 
   template<> struct action < argument_number > {
-    static void apply( const pegtl::input & in, L1::Program & p){
+    static void apply( const pegtl::input & in, L1::Program & p, ParseState & state){
       p.functions.back()->arguments = std::stoll(in.string());
     }
   };
 
   template<> struct action < local_number > {
-    static void apply( const pegtl::input & in, L1::Program & p){
+    static void apply( const pegtl::input & in, L1::Program & p, ParseState & state){
       p.functions.back()->locals = std::stoll(in.string());
     }
   };
 
   template<> struct action < functioncall_argument_number > {
-    static void apply( const pegtl::input & in, L1::Program & p){
-      parsed_n_vals.push_back(std::stoll(in.string()));
+    static void apply( const pegtl::input & in, L1::Program & p, ParseState & state){
+      state.parsed_n_vals.push_back(std::stoll(in.string()));
     }
   };
 
   template<> struct action < L1_w_rule > {
-    static void apply( const pegtl::input & in, L1::Program & p){
+    static void apply( const pegtl::input & in, L1::Program & p, ParseState & state){
       L1::L1_w newW;
       newW.name = in.string();
       newW.r = true;
-      parsed_register = true;
-      parsed_w_vals.push_back(newW);
+      state.parsed_register = true;
+      state.parsed_w_vals.push_back(newW);
     }
   };
 
   template<> struct action < L1_s_rule > {
-    static void apply( const pegtl::input & in, L1::Program & p){
+    static void apply( const pegtl::input & in, L1::Program & p, ParseState & state){
       L1::L1_s newS;
-      newS.r = parsed_register;
+      newS.r = state.parsed_register;
       newS.name = in.string();
       if (newS.name[0] == ':') {
         newS.name[0] = '_';
       }
-      parsed_s_vals.push_back(newS);
+      state.parsed_s_vals.push_back(newS);
     }
   };
 
   template<> struct action < L1_t_rule > {
-    static void apply( const pegtl::input & in, L1::Program & p){
+    static void apply( const pegtl::input & in, L1::Program & p, ParseState & state){
       L1::L1_t newT;
-      newT.r = parsed_register;
+      newT.r = state.parsed_register;
       newT.name = in.string();
-      parsed_t_vals.push_back(newT);
+      state.parsed_t_vals.push_back(newT);
     }
   };
 
   template<> struct action < L1_x_rule > {
-    static void apply( const pegtl::input & in, L1::Program & p){
+    static void apply( const pegtl::input & in, L1::Program & p, ParseState & state){
       L1::L1_x newX;
       newX.name = in.string();
       newX.r = true;
-      parsed_register = true;
-      parsed_x_vals.push_back(newX);
+      state.parsed_register = true;
+      state.parsed_x_vals.push_back(newX);
     }
   };
 
   template<> struct action < L1_m_rule > {
-    static void apply( const pegtl::input & in, L1::Program & p){
+    static void apply( const pegtl::input & in, L1::Program & p, ParseState & state){
       L1::L1_m newM;
       newM.name = in.string();
-      parsed_m_vals.push_back(newM);
+      state.parsed_m_vals.push_back(newM);
     }
   };
 
   template<> struct action < L1_u_rule > {
-    static void apply( const pegtl::input & in, L1::Program & p){
+    static void apply( const pegtl::input & in, L1::Program & p, ParseState & state){
       L1::L1_u newU;
       newU.name = in.string();
       if (newU.name[0] == ':') {
         newU.name[0] = '_';
       }
-      parsed_u_vals.push_back(newU);
+      state.parsed_u_vals.push_back(newU);
     }
   };
 
   template<> struct action < L1_label_instruction_rule > {
-    static void apply( const pegtl::input & in, L1::Program & p){
+    static void apply( const pegtl::input & in, L1::Program & p, ParseState & state){
       L1::Label *lbl = new L1::Label();
       lbl->name = in.string().replace(0,1, "_");
       p.functions.back()->instructions.push_back(lbl);
@@ -767,156 +786,156 @@ namespace L1 {
   };
 
   template<> struct action < L1_memref_rule > {
-    static void apply( const pegtl::input & in, L1::Program & p){
+    static void apply( const pegtl::input & in, L1::Program & p, ParseState & state){
       L1::MemoryReference memRef;
-      L1::L1_x x = parsed_x_vals.back();
-      L1::L1_m m = parsed_m_vals.back();
+      L1::L1_x x = state.parsed_x_vals.back();
+      L1::L1_m m = state.parsed_m_vals.back();
       memRef.value = x;
       memRef.offset = m;
       memRef.offset_int = std::stoll(m.name);
-      parsed_mem_refs.push_back(memRef);
+      state.parsed_mem_refs.push_back(memRef);
     }
   };
 
   template<> struct action < L1_goto_rule > {
-    static void apply( const pegtl::input & in, L1::Program & p){
+    static void apply( const pegtl::input & in, L1::Program & p, ParseState & state){
       L1::GotoOperation *goto_op = new L1::GotoOperation();
-      goto_op->lbl = parsed_registers.back();
+      goto_op->lbl = state.parsed_registers.back();
       p.functions.back()->instructions.push_back(goto_op);
     }
   };
 
   template<> struct action < L1_cjump_then_label_rule > {
-    static void apply( const pegtl::input & in, L1::Program & p){
-      cjump_then = parsed_registers.back().name;
+    static void apply( const pegtl::input & in, L1::Program & p, ParseState & state){
+      state.cjump_then = state.parsed_registers.back().name;
     }
   };
 
   template<> struct action < L1_cjump_else_label_rule > {
-    static void apply( const pegtl::input & in, L1::Program & p){
-      cjump_else = parsed_registers.back().name;
+    static void apply( const pegtl::input & in, L1::Program & p, ParseState & state){
+      state.cjump_else = state.parsed_registers.back().name;
     }
   };
 
   template<> struct action < L1_cjump_rule > {
-    static void apply( const pegtl::input & in, L1::Program & p){
+    static void apply( const pegtl::input & in, L1::Program & p, ParseState & state){
       L1::CjumpOperation *cjump = new L1::CjumpOperation();
-      cjump->cexp = current_cexp;
-      cjump->then_label = cjump_then;
-      cjump->else_label = cjump_else;
+      cjump->cexp = state.current_cexp;
+      cjump->then_label = state.cjump_then;
+      cjump->else_label = state.cjump_else;
       p.functions.back()->instructions.push_back(cjump);
     }
   };
 
   template<> struct action < L1_cmp_lhs_rule > {
-    static void apply( const pegtl::input & in, L1::Program & p){
-      cmp_lhs.name = in.string();
-      cmp_lhs.r = parsed_register;
+    static void apply( const pegtl::input & in, L1::Program & p, ParseState & state){
+      state.cmp_lhs.name = in.string();
+      state.cmp_lhs.r = state.parsed_register;
     }
   };
 
   template<> struct action < L1_cexp_lhs_rule > {
-    static void apply( const pegtl::input & in, L1::Program & p){
-      current_cexp_lhs.name = in.string();
-      current_cexp_lhs.r = parsed_register;
+    static void apply( const pegtl::input & in, L1::Program & p, ParseState & state){
+      state.current_cexp_lhs.name = in.string();
+      state.current_cexp_lhs.r = state.parsed_register;
     }
   };
 
   template<> struct action < L1_cexp_rhs_rule > {
-    static void apply( const pegtl::input & in, L1::Program & p){
-      current_cexp_rhs.name = in.string();
-      current_cexp_rhs.r = parsed_register;
+    static void apply( const pegtl::input & in, L1::Program & p, ParseState & state){
+      state.current_cexp_rhs.name = in.string();
+      state.current_cexp_rhs.r = state.parsed_register;
     }
   };
 
   template<> struct action < L1_cop_rule > {
-    static void apply( const pegtl::input & in, L1::Program & p){
+    static void apply( const pegtl::input & in, L1::Program & p, ParseState & state){
       std::string op_string = in.string();
       std::string lt ("<");
       std::string lte ("<=");
       std::string eq ("=");
       if (op_string.compare(lt) == 0) {
-        current_cop = lessthan;
+        state.current_cop = lessthan;
       }
       else if (op_string.compare(lte) == 0) {
-        current_cop = lessthanorequal;
+        state.current_cop = lessthanorequal;
       }
       else if (op_string.compare(eq) == 0) {
-        current_cop = equal;
+        state.current_cop = equal;
       }
     }
   };
 
   template<> struct action < L1_cmp_rule > {
-    static void apply( const pegtl::input & in, L1::Program & p){
-      current_cexp.lhs = current_cexp_lhs;
-      current_cexp.rhs = current_cexp_rhs;
-      current_cexp.op = current_cop;
+    static void apply( const pegtl::input & in, L1::Program & p, ParseState & state){
+      state.current_cexp.lhs = state.current_cexp_lhs;
+      state.current_cexp.rhs = state.current_cexp_rhs;
+      state.current_cexp.op = state.current_cop;
     }
   };
 
   template<> struct action < L1_cmp_instruction_rule > {
-    static void apply( const pegtl::input & in, L1::Program & p){
+    static void apply( const pegtl::input & in, L1::Program & p, ParseState & state){
       L1::ComparisonOperation *cop = new L1::ComparisonOperation();
-      cop->lhs = cmp_lhs;
-      cop->cexp = current_cexp;
+      cop->lhs = state.cmp_lhs;
+      cop->cexp = state.current_cexp;
       p.functions.back()->instructions.push_back(cop);
     }
   };
 
   template<> struct action < L1_shift_rhs_rule > {
-    static void apply( const pegtl::input & in, L1::Program & p){
-      shift_rhs.name = in.string();
-      if (shift_rhs.name == "rcx") {
-        shift_rhs.name = "%cl";
+    static void apply( const pegtl::input & in, L1::Program & p, ParseState & state){
+      state.shift_rhs.name = in.string();
+      if (state.shift_rhs.name == "rcx") {
+        state.shift_rhs.name = "%cl";
       } else {
-        shift_rhs.name = "$" + in.string();
+        state.shift_rhs.name = "$" + in.string();
       }
     }
   };
 
   template<> struct action < L1_sop_rule > {
-    static void apply( const pegtl::input & in, L1::Program & p){
+    static void apply( const pegtl::input & in, L1::Program & p, ParseState & state){
       std::string op_string = in.string();
       std::string ls ("<<=");
       std::string rs (">>=");
       if (op_string.compare(ls) == 0) {
-        current_sop = lshift;
+        state.current_sop = lshift;
       }
       else if (op_string.compare(rs) == 0) {
-        current_sop = rshift;
+        state.current_sop = rshift;
       }
     }
   };
 
   template<> struct action < L1_shift_rule > {
-    static void apply( const pegtl::input & in, L1::Program & p){
+    static void apply( const pegtl::input & in, L1::Program & p, ParseState & state){
       L1::ShiftOperation *sop = new L1::ShiftOperation();
-      sop->op = current_sop;
-      sop->lhs = parsed_w_vals.back();
-      sop->rhs = shift_rhs;
+      sop->op = state.current_sop;
+      sop->lhs = state.parsed_w_vals.back();
+      sop->rhs = state.shift_rhs;
       p.functions.back()->instructions.push_back(sop);
     }
   };
 
   template<> struct action < L1_aop_rule > {
-    static void apply( const pegtl::input & in, L1::Program & p){
+    static void apply( const pegtl::input & in, L1::Program & p, ParseState & state){
       std::string op_string = in.string();
       std::string peq ("+=");
       std::string meq ("-=");
       std::string teq ("*=");
       std::string aeq ("&=");
       if (op_string.compare(peq) == 0) {
-        current_aop = plusequal;
+        state.current_aop = plusequal;
       }
       else if (op_string.compare(meq) == 0) {
-        current_aop = minusequal;
+        state.current_aop = minusequal;
       }
       else if (op_string.compare(teq) == 0) {
-        current_aop = timesequal;
+        state.current_aop = timesequal;
       }
       else if (op_string.compare(aeq) == 0) {
-        current_aop = andequal;
+        state.current_aop = andequal;
       }
       else {
         cerr << "error" << endl;
@@ -925,169 +944,188 @@ namespace L1 {
   };
 
   template<> struct action < L1_arithmetic_lhs_rule > {
-    static void apply( const pegtl::input & in, L1::Program & p){
-      arithmetic_lhs = parsed_w_vals.back();
+    static void apply( const pegtl::input & in, L1::Program & p, ParseState & state){
+      state.arithmetic_lhs = state.parsed_w_vals.back();
     }
   };
 
   template<> struct action < L1_arithmetic_rhs_rule > {
-    static void apply( const pegtl::input & in, L1::Program & p){
-      arithmetic_rhs = parsed_t_vals.back();
+    static void apply( const pegtl::input & in, L1::Program & p, ParseState & state){
+      state.arithmetic_rhs = state.parsed_t_vals.back();
     }
   };
 
   template<> struct action < L1_arithmetic_rule > {
-    static void apply( const pegtl::input & in, L1::Program & p){
+    static void apply( const pegtl::input & in, L1::Program & p, ParseState & state){
       L1::ArithmeticOperation *aop = new L1::ArithmeticOperation();
-      aop->op = current_aop;
-      aop->lhs = arithmetic_lhs;
-      aop->rhs = arithmetic_rhs;
+      aop->op = state.current_aop;
+      aop->lhs = state.arithmetic_lhs;
+      aop->rhs = state.arithmetic_rhs;
       p.functions.back()->instructions.push_back(aop);
     }
   };
 
   template<> struct action < L1_inc_rule > {
-    static void apply( const pegtl::input & in, L1::Program & p){
+    static void apply( const pegtl::input & in, L1::Program & p, ParseState & state){
       L1::ArithmeticOperation *aop = new L1::ArithmeticOperation();
       aop->op = plusequal;
       aop->rhs.name = "1";
-      aop->lhs = parsed_w_vals.back();
+      aop->lhs = state.parsed_w_vals.back();
       p.functions.back()->instructions.push_back(aop);
     }
   };
 
   template<> struct action < L1_dec_rule > {
-    static void apply( const pegtl::input & in, L1::Program & p){
+    static void apply( const pegtl::input & in, L1::Program & p, ParseState & state){
       L1::ArithmeticOperation *aop = new L1::ArithmeticOperation();
       aop->op = minusequal;
       aop->rhs.name = "1";
-      aop->lhs = parsed_w_vals.back();
+      aop->lhs = state.parsed_w_vals.back();
       p.functions.back()->instructions.push_back(aop);
     }
   };
 
   template<> struct action < L1_mem_arithmetic_rule > {
-    static void apply( const pegtl::input & in, L1::Program & p){
+    static void apply( const pegtl::input & in, L1::Program & p, ParseState & state){
       L1::MemoryArithmeticOperation *maop = new L1::MemoryArithmeticOperation();
-      L1::MemoryReference memRef = parsed_mem_refs.back();
-      maop->op = current_aop;
+      L1::MemoryReference memRef = state.parsed_mem_refs.back();
+      maop->op = state.current_aop;
       maop->lhs = memRef;
-      maop->rhs = parsed_t_vals.back();
+      maop->rhs = state.parsed_t_vals.back();
       p.functions.back()->instructions.push_back(maop);
     }
   };
 
   template<> struct action < L1_mem_arithmetic_rule_2 > {
-    static void apply( const pegtl::input & in, L1::Program & p){
+    static void apply( const pegtl::input & in, L1::Program & p, ParseState & state){
       L1::MemoryArithmeticOperation2 *maop = new L1::MemoryArithmeticOperation2();
-      L1::MemoryReference memRef = parsed_mem_refs.back();
-      maop->op = current_aop;
-      maop->lhs = parsed_w_vals.back();
+      L1::MemoryReference memRef = state.parsed_mem_refs.back();
+      maop->op = state.current_aop;
+      maop->lhs = state.parsed_w_vals.back();
       maop->rhs = memRef;
       p.functions.back()->instructions.push_back(maop);
     }
   };
 
   template<> struct action < L1_assignment_lhs_rule > {
-    static void apply( const pegtl::input & in, L1::Program & p){
-      assignment_lhs = parsed_w_vals.back();
+    static void apply( const pegtl::input & in, L1::Program & p, ParseState & state){
+      state.assignment_lhs = state.parsed_w_vals.back();
     }
   };
 
   template<> struct action < L1_assignment_rhs_rule > {
-    static void apply( const pegtl::input & in, L1::Program & p){
-      assignment_rhs = parsed_s_vals.back();
+    static void apply( const pegtl::input & in, L1::Program & p, ParseState & state){
+      state.assignment_rhs = state.parsed_s_vals.back();
     }
   };
 
   template<> struct action < L1_assignment_rule > {
-    static void apply( const pegtl::input & in, L1::Program & p){
+    static void apply( const pegtl::input & in, L1::Program & p, ParseState & state){
       L1::Assignment *assignment = new L1::Assignment();
-      assignment->lhs = assignment_lhs;
-      assignment->rhs = assignment_rhs;
+      assignment->lhs = state.assignment_lhs;
+      assignment->rhs = state.assignment_rhs;
       p.functions.back()->instructions.push_back(assignment);
     }
   };
 
   template<> struct action < L1_load_lhs_rule > {
-    static void apply( const pegtl::input & in, L1::Program & p){
-      load_lhs = parsed_w_vals.back();
+    static void apply( const pegtl::input & in, L1::Program & p, ParseState & state){
+      state.load_lhs = state.parsed_w_vals.back();
     }
   };
 
   template<> struct action < L1_load_rule > {
-    static void apply( const pegtl::input & in, L1::Program & p){
+    static void apply( const pegtl::input & in, L1::Program & p, ParseState & state){
       L1::Load *load = new L1::Load();
-      load->lhs = load_lhs;
-      load->rhs = parsed_mem_refs.back();
+      load->lhs = state.load_lhs;
+      load->rhs = state.parsed_mem_refs.back();
       p.functions.back()->instructions.push_back(load);
     }
   };
 
   template<> struct action < L1_store_rule > {
-    static void apply( const pegtl::input & in, L1::Program & p){
+    static void apply( const pegtl::input & in, L1::Program & p, ParseState & state){
       L1::Store *store = new L1::Store();
-      store->lhs = parsed_mem_refs.back();
-      store->rhs = parsed_s_vals.back();
+      store->lhs = state.parsed_mem_refs.back();
+      store->rhs = state.parsed_s_vals.back();
       p.functions.back()->instructions.push_back(store);
     }
   };
 
   template<> struct action < L1_runtime_function_name > {
-    static void apply( const pegtl::input & in, L1::Program & p){
+    static void apply( const pegtl::input & in, L1::Program & p, ParseState & state){
       L1_item i;
       i.name = in.string();
-      parsed_register = false;
-      parsed_registers.push_back(i);
+      state.parsed_register = false;
+      state.parsed_registers.push_back(i);
     }
   };
 
   template<> struct action < L1_runtimecall_rule > {
-    static void apply( const pegtl::input & in, L1::Program & p){
+    static void apply( const pegtl::input & in, L1::Program & p, ParseState & state){
       L1::RuntimeCall *rCall = new L1::RuntimeCall();
-      rCall->function_name = parsed_registers.back();
+      rCall->function_name = state.parsed_registers.back();
       if (rCall->function_name.name == "array-error") {
         rCall->function_name.name = "array_error";
       }
-      rCall->n_args = parsed_n_vals.back();
+      rCall->n_args = state.parsed_n_vals.back();
       p.functions.back()->instructions.push_back(rCall);
     }
   };
 
   template<> struct action < L1_functioncall_rule > {
-    static void apply( const pegtl::input & in, L1::Program & p){
+    static void apply( const pegtl::input & in, L1::Program & p, ParseState & state){
       L1::FunctionCall *fCall = new L1::FunctionCall();
-      fCall->function_name = parsed_u_vals.back();
-      fCall->n_args = parsed_n_vals.back();
+      fCall->function_name = state.parsed_u_vals.back();
+      fCall->n_args = state.parsed_n_vals.back();
       p.functions.back()->instructions.push_back(fCall);
     }
   };
 
   template<> struct action < L1_return_rule > {
-    static void apply( const pegtl::input & in, L1::Program & p){
+    static void apply( const pegtl::input & in, L1::Program & p, ParseState & state){
       L1::ReturnCall *rCall = new L1::ReturnCall();
       p.functions.back()->instructions.push_back(rCall);
     }
   };
 
+  template<> struct action < L1_instruction_rule > {
+    static void apply( const pegtl::input & in, L1::Program & p, ParseState & state){
+      state.clear_memory();
+    }
+  };
+
   template<> struct action < L1_instructions_rule > {
-    static void apply( const pegtl::input & in, L1::Program & p){
+    static void apply( const pegtl::input & in, L1::Program & p, ParseState & state){
 
     }
   };
 
+  /*
+   * Walks the grammar for rules that could loop without consuming
+   * input, which costs more than parsing a small program. Only
+   * builds made with CHECK_GRAMMAR=1 do it, once per process.
+   */
+  void check_grammar() {
+#ifdef CHECK_GRAMMAR
+    static size_t issues = pegtl::analyze< L1::grammar >();
+    (void)issues;
+#endif
+  }
+
   L1::Program L1_parse_file (char *fileName){
 
     /*
      * Check the grammar for some possible issues.
      */
-    pegtl::analyze< L1::grammar >();
+    check_grammar();
 
     /*
      * Parse.
      */
     L1::Program p;
-    pegtl::file_parser(fileName).parse< L1::grammar, L1::action >(p);
+    ParseState state;
+    pegtl::file_parser(fileName).parse< L1::grammar, L1::action >(p, state);
 
     return p;
   }
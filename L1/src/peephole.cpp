@@ -0,0 +1,76 @@
+#include <string>
+#include <vector>
+#include <map>
+#include <cstdlib>
+#include <stdint.h>
+
+#include "peephole.h"
+
+using namespace std;
+
+namespace L1 {
+
+  map<string, int64_t> peephole_hits;
+
+  bool is_zero(const L1_item &item) {
+    return !item.r && item.name[0] != '_' && strtoll(item.name.c_str(), NULL, 10) == 0;
+  }
+
+  /*
+   * The rule that removes i, or "" if i stays. Nothing is live in
+   * the flags between instructions, so dropping an addq $0 can't
+   * change a later jump.
+   */
+  string redundant(Instruction *i) {
+    switch (i->opcode) {
+      case assignment_op: {
+        Assignment *assn = static_cast<Assignment *>(i);
+        if (assn->rhs.r && assn->rhs.name == assn->lhs.name) {
+          return "self move";
+        }
+        break;
+      }
+      case arithmetic_op: {
+        ArithmeticOperation *aop = static_cast<ArithmeticOperation *>(i);
+        if ((aop->op == plusequal || aop->op == minusequal) && is_zero(aop->rhs)) {
+          return "add zero";
+        }
+        break;
+      }
+      case memory_arithmetic_op: {
+        MemoryArithmeticOperation *maop = static_cast<MemoryArithmeticOperation *>(i);
+        if ((maop->op == plusequal || maop->op == minusequal) && is_zero(maop->rhs)) {
+          return "add zero";
+        }
+        break;
+      }
+      default:
+        break;
+    }
+    return "";
+  }
+
+  void peephole(Function *f) {
+    vector<Instruction *> kept;
+    for (auto i : f->instructions) {
+      string rule = redundant(i);
+      if (rule != "") {
+        peephole_hits[rule]++;
+        continue;
+      }
+
+      // a goto falling through to its own label, possibly after
+      // instructions the rules above took out
+      if (i->opcode == label_op && !kept.empty() && kept.back()->opcode == goto_op) {
+        GotoOperation *gt = static_cast<GotoOperation *>(kept.back());
+        if (gt->lbl.name == static_cast<Label *>(i)->name) {
+          kept.pop_back();
+          peephole_hits["goto next label"]++;
+        }
+      }
+      kept.push_back(i);
+    }
+    f->instructions = kept;
+  }
+
+} // L1
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <stdint.h>
+
+#include "L1.h"
+
+namespace L1 {
+
+  /*
+   * How many instructions each peephole rule has removed so far,
+   * by the rule's name.
+   */
+  extern std::map<std::string, int64_t> peephole_hits;
+
+  /*
+   * Removes the instructions of f that do nothing once they are
+   * x86: moves from a register to itself, adding or subtracting
+   * zero, and gotos to the label right after them. Run before
+   * compute_stack_maps(), which keys on what is left.
+   */
+  void peephole(Function *f);
+
+} // L1
@@ -0,0 +1,389 @@
+#include <string>
+#include <vector>
+#include <set>
+#include <map>
+#include <stdint.h>
+
+#include "stack_maps.h"
+
+using namespace std;
+
+namespace L1 {
+
+  // the order allocate() in the runtime spills them in
+  const vector<string> allocate_spilled_registers = {
+    "rbx", "rbp", "r12", "r13", "r14", "r15"
+  };
+
+  const vector<string> caller_save_registers = {
+    "r10", "r11", "r8", "r9", "rax", "rcx", "rdi", "rdx", "rsi"
+  };
+
+  const vector<string> arg_registers = {
+    "rdi", "rsi", "rdx", "rcx", "r8", "r9"
+  };
+
+  const set<string> all_registers = {
+    "rax", "rbx", "rbp", "rcx", "rdx", "rdi", "rsi", "rsp",
+    "r8", "r9", "r10", "r11", "r12", "r13", "r14", "r15"
+  };
+
+  /*
+   * Gen, kill and successors of one instruction. Frame words are
+   * numbered from rsp up, so (mem rsp 8k) is slot k. A call's
+   * successors are all the return points, which are shared rather
+   * than listed on every call.
+   */
+  struct SlotLiveness {
+    set<string> gen_registers;
+    set<string> kill_registers;
+    set<int64_t> gen_slots;
+    set<int64_t> kill_slots;
+    vector<int64_t> successors;
+    bool returns = false;
+    set<string> in_registers;
+    set<string> out_registers;
+    set<int64_t> in_slots;
+    set<int64_t> out_slots;
+  };
+
+  /*
+   * Labels used as values anywhere in the program. Return addresses
+   * are always stored before a call, so these are the only labels a
+   * frame can be suspended at.
+   */
+  set<string> stored_labels(Program &p) {
+    set<string> labels;
+    for (auto f : p.functions) {
+      for (auto i : f->instructions) {
+        switch (i->opcode) {
+          case store_op: {
+            Store *store = static_cast<Store *>(i);
+            if (store->rhs.name[0] == '_') {
+              labels.insert(store->rhs.name);
+            }
+            break;
+          }
+          case assignment_op: {
+            Assignment *assn = static_cast<Assignment *>(i);
+            if (assn->rhs.name[0] == '_') {
+              labels.insert(assn->rhs.name);
+            }
+            break;
+          }
+          default:
+            break;
+        }
+      }
+    }
+    return labels;
+  }
+
+  class SlotAnalysis {
+    public:
+      SlotAnalysis(Function *f, const set<string> &return_labels);
+      map<Instruction *, StackMap> stack_maps();
+
+    private:
+      void use(SlotLiveness &l, const string &name);
+      void define(SlotLiveness &l, const string &name);
+      void read_memory(SlotLiveness &l, MemoryReference &m);
+      void write_memory(SlotLiveness &l, MemoryReference &m);
+      void compare(SlotLiveness &l, ComparisonExpression &cexp);
+      void jump(SlotLiveness &l, const string &label);
+      void analyze(int64_t index, Instruction *i);
+      StackMap make_map(const set<string> &registers, const set<int64_t> &slots);
+
+      Function *f;
+      int64_t frame_words;
+      bool conservative;
+      map<string, int64_t> labels;
+      vector<int64_t> return_points;
+      vector<SlotLiveness> instructions;
+  };
+
+  SlotAnalysis::SlotAnalysis(Function *f, const set<string> &return_labels)
+    : f(f), conservative(false), instructions(f->instructions.size()) {
+    frame_words = f->locals + (f->arguments > 6 ? f->arguments - 6 : 0);
+
+    for (int64_t k = 0; k < (int64_t)f->instructions.size(); k++) {
+      if (f->instructions[k]->opcode == label_op) {
+        Label *lbl = static_cast<Label *>(f->instructions[k]);
+        labels[lbl->name] = k;
+        if (return_labels.count(lbl->name)) {
+          return_points.push_back(k);
+        }
+      }
+    }
+    for (int64_t k = 0; k < (int64_t)f->instructions.size(); k++) {
+      analyze(k, f->instructions[k]);
+    }
+  }
+
+  void SlotAnalysis::use(SlotLiveness &l, const string &name) {
+    if (name == "rsp") {
+      // the frame's address escapes, so any word of it can be read
+      conservative = true;
+    } else if (all_registers.count(name)) {
+      l.gen_registers.insert(name);
+    }
+  }
+
+  void SlotAnalysis::define(SlotLiveness &l, const string &name) {
+    l.kill_registers.insert(name);
+  }
+
+  void SlotAnalysis::read_memory(SlotLiveness &l, MemoryReference &m) {
+    if (m.value.name != "rsp") {
+      use(l, m.value.name);
+      return;
+    }
+    if (m.offset_int < 0 || m.offset_int % 8 != 0 || m.offset_int / 8 >= frame_words) {
+      conservative = true;
+      return;
+    }
+    l.gen_slots.insert(m.offset_int / 8);
+  }
+
+  void SlotAnalysis::write_memory(SlotLiveness &l, MemoryReference &m) {
+    if (m.value.name != "rsp") {
+      use(l, m.value.name);
+      return;
+    }
+    if (m.offset_int < 0) {
+      // arguments and return address of the next call, which belong
+      // to the callee's frame
+      return;
+    }
+    if (m.offset_int % 8 != 0 || m.offset_int / 8 >= frame_words) {
+      conservative = true;
+      return;
+    }
+    l.kill_slots.insert(m.offset_int / 8);
+  }
+
+  void SlotAnalysis::compare(SlotLiveness &l, ComparisonExpression &cexp) {
+    // comparing against rsp doesn't let the frame escape
+    if (cexp.lhs.name != "rsp") {
+      use(l, cexp.lhs.name);
+    }
+    if (cexp.rhs.name != "rsp") {
+      use(l, cexp.rhs.name);
+    }
+  }
+
+  void SlotAnalysis::jump(SlotLiveness &l, const string &label) {
+    auto target = labels.find(label);
+    if (target == labels.end()) {
+      conservative = true;
+      return;
+    }
+    l.successors.push_back(target->second);
+  }
+
+  void SlotAnalysis::analyze(int64_t index, Instruction *i) {
+    SlotLiveness &l = instructions[index];
+    bool falls_through = true;
+
+    switch (i->opcode) {
+      case load_op: {
+        Load *load = static_cast<Load *>(i);
+        read_memory(l, load->rhs);
+        define(l, load->lhs.name);
+        break;
+      }
+      case store_op: {
+        Store *store = static_cast<Store *>(i);
+        write_memory(l, store->lhs);
+        use(l, store->rhs.name);
+        break;
+      }
+      case assignment_op: {
+        Assignment *assn = static_cast<Assignment *>(i);
+        use(l, assn->rhs.name);
+        define(l, assn->lhs.name);
+        break;
+      }
+      case return_op: {
+        l.gen_registers.insert("rax");
+        for (auto r : allocate_spilled_registers) {
+          l.gen_registers.insert(r);
+        }
+        falls_through = false;
+        break;
+      }
+      case arithmetic_op: {
+        ArithmeticOperation *aop = static_cast<ArithmeticOperation *>(i);
+        use(l, aop->lhs.name);
+        use(l, aop->rhs.name);
+        break;
+      }
+      case memory_arithmetic_op: {
+        MemoryArithmeticOperation *maop = static_cast<MemoryArithmeticOperation *>(i);
+        read_memory(l, maop->lhs);
+        use(l, maop->rhs.name);
+        break;
+      }
+      case memory_arithmetic2_op: {
+        MemoryArithmeticOperation2 *maop = static_cast<MemoryArithmeticOperation2 *>(i);
+        read_memory(l, maop->rhs);
+        use(l, maop->lhs.name);
+        break;
+      }
+      case shift_op: {
+        ShiftOperation *sop = static_cast<ShiftOperation *>(i);
+        use(l, sop->lhs.name);
+        if (sop->rhs.name == "%cl") {
+          use(l, "rcx");
+        }
+        break;
+      }
+      case comparison_op: {
+        ComparisonOperation *comp = static_cast<ComparisonOperation *>(i);
+        compare(l, comp->cexp);
+        define(l, comp->lhs.name);
+        break;
+      }
+      case function_call_op: {
+        FunctionCall *fCall = static_cast<FunctionCall *>(i);
+        use(l, fCall->function_name.name);
+        for (int64_t a = 0; a < fCall->n_args && a < 6; a++) {
+          l.gen_registers.insert(arg_registers[a]);
+        }
+        for (auto r : caller_save_registers) {
+          define(l, r);
+        }
+        // the callee comes back to whichever return label was stored
+        l.returns = true;
+        break;
+      }
+      case runtime_call_op: {
+        RuntimeCall *rCall = static_cast<RuntimeCall *>(i);
+        for (int64_t a = 0; a < rCall->n_args && a < 6; a++) {
+          l.gen_registers.insert(arg_registers[a]);
+        }
+        for (auto r : caller_save_registers) {
+          define(l, r);
+        }
+        falls_through = rCall->function_name.name != "array_error";
+        break;
+      }
+      case wawwe_op: {
+        WawweOperation *wawwe = static_cast<WawweOperation *>(i);
+        use(l, wawwe->start.name);
+        use(l, wawwe->mult.name);
+        define(l, wawwe->lhs.name);
+        break;
+      }
+      case cjump_op: {
+        CjumpOperation *cj = static_cast<CjumpOperation *>(i);
+        compare(l, cj->cexp);
+        jump(l, cj->then_label);
+        jump(l, cj->else_label);
+        falls_through = false;
+        break;
+      }
+      case goto_op: {
+        GotoOperation *gt = static_cast<GotoOperation *>(i);
+        jump(l, gt->lbl.name);
+        falls_through = false;
+        break;
+      }
+      case label_op:
+        break;
+    }
+
+    if (falls_through && index + 1 < (int64_t)instructions.size()) {
+      l.successors.push_back(index + 1);
+    }
+  }
+
+  StackMap SlotAnalysis::make_map(const set<string> &registers, const set<int64_t> &slots) {
+    StackMap map;
+    map.frame_words = frame_words;
+    map.conservative = conservative;
+    map.live_registers = 0;
+    for (int64_t r = 0; r < (int64_t)allocate_spilled_registers.size(); r++) {
+      if (conservative || registers.count(allocate_spilled_registers[r])) {
+        map.live_registers |= (int64_t)1 << r;
+      }
+    }
+    if (!conservative) {
+      map.live_slots.assign(slots.begin(), slots.end());
+    }
+    return map;
+  }
+
+  /*
+   * Backward liveness over the registers and frame words of f, then
+   * one map per allocate call (what is live after it) and per return
+   * label (what is live while a callee runs).
+   */
+  map<Instruction *, StackMap> SlotAnalysis::stack_maps() {
+    bool changed = true;
+    while (changed && !conservative) {
+      changed = false;
+      set<string> return_registers;
+      set<int64_t> return_slots;
+      for (auto k : return_points) {
+        return_registers.insert(instructions[k].in_registers.begin(), instructions[k].in_registers.end());
+        return_slots.insert(instructions[k].in_slots.begin(), instructions[k].in_slots.end());
+      }
+      for (int64_t k = (int64_t)instructions.size() - 1; k >= 0; k--) {
+        SlotLiveness &l = instructions[k];
+        set<string> out_registers;
+        set<int64_t> out_slots;
+        if (l.returns) {
+          out_registers = return_registers;
+          out_slots = return_slots;
+        }
+        for (auto s : l.successors) {
+          out_registers.insert(instructions[s].in_registers.begin(), instructions[s].in_registers.end());
+          out_slots.insert(instructions[s].in_slots.begin(), instructions[s].in_slots.end());
+        }
+
+        set<string> in_registers = l.gen_registers;
+        for (auto r : out_registers) {
+          if (!l.kill_registers.count(r)) {
+            in_registers.insert(r);
+          }
+        }
+        set<int64_t> in_slots = l.gen_slots;
+        for (auto s : out_slots) {
+          if (!l.kill_slots.count(s)) {
+            in_slots.insert(s);
+          }
+        }
+
+        if (in_registers != l.in_registers || in_slots != l.in_slots) {
+          changed = true;
+        }
+        l.in_registers = in_registers;
+        l.in_slots = in_slots;
+        l.out_registers = out_registers;
+        l.out_slots = out_slots;
+      }
+    }
+
+    map<Instruction *, StackMap> maps;
+    for (int64_t k = 0; k < (int64_t)instructions.size(); k++) {
+      Instruction *i = f->instructions[k];
+      if (i->opcode == runtime_call_op) {
+        RuntimeCall *rCall = static_cast<RuntimeCall *>(i);
+        if (rCall->function_name.name == "allocate") {
+          maps[i] = make_map(instructions[k].out_registers, instructions[k].out_slots);
+        }
+      }
+    }
+    for (auto k : return_points) {
+      maps[f->instructions[k]] = make_map(instructions[k].in_registers, instructions[k].in_slots);
+    }
+    return maps;
+  }
+
+  map<Instruction *, StackMap> compute_stack_maps(Function *f, const set<string> &return_labels) {
+    SlotAnalysis analysis(f, return_labels);
+    return analysis.stack_maps();
+  }
+
+} // L1
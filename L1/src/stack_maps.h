@@ -0,0 +1,32 @@
+#pragma once
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "L1.h"
+
+namespace L1 {
+
+  /*
+   * What the collector has to look at while a frame is suspended at
+   * a given return address: the frame's size in words, the frame
+   * words live there, and which callee-save registers are live (one
+   * bit each, in the order allocate() spills them). A conservative
+   * map covers the whole frame.
+   */
+  struct StackMap {
+    int64_t frame_words;
+    bool conservative;
+    std::vector<int64_t> live_slots;
+    int64_t live_registers;
+  };
+
+  extern const std::vector<std::string> allocate_spilled_registers;
+
+  std::set<std::string> stored_labels(Program &p);
+
+  std::map<Instruction *, StackMap> compute_stack_maps(Function *f, const std::set<std::string> &return_labels);
+
+} // L1
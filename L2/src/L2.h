@@ -1,6 +1,8 @@
 #pragma once
 
 #include <vector>
+#include <set>
+#include <string>
 #include "../../L1/src/L1.h"
 
 namespace L2 {
@@ -15,7 +17,7 @@ namespace L2 {
 
   struct L2_item {
     std::string name;
-    bool r;
+    bool r = false;
   };
 
   struct L2_w : L2_item {};
@@ -35,10 +37,11 @@ namespace L2 {
   struct MemoryReference : L2_item {
     L2::L2_x value;
     L2::L2_m offset;
-    int64_t offset_int;
+    int64_t offset_int = 0;
   };
 
   struct Instruction : L1::Instruction {
+    Instruction(L1::Opcode opcode) : L1::Instruction(opcode) {};
     virtual ~Instruction() {};
     L2::L2_item lhs;
     L2::L2_item rhs;
@@ -46,14 +49,16 @@ namespace L2 {
   };
 
   struct GotoOperation : public Instruction{
+    GotoOperation() : Instruction(L1::goto_op) {};
     L2::L2_item lbl;
   };
 
   struct WawweOperation : public Instruction{
+    WawweOperation() : Instruction(L1::wawwe_op) {};
     L2::L2_w lhs;
     L2::L2_w start;
     L2::L2_w mult;
-    int64_t e;
+    int64_t e = 0;
   };
 
   enum ComparisonOperator { lessthan, lessthanorequal, equal };
@@ -66,11 +71,13 @@ namespace L2 {
   };
 
   struct ComparisonOperation : public Instruction{
+    ComparisonOperation() : Instruction(L1::comparison_op) {};
     L2::L2_w lhs;
     ComparisonExpression cexp;
   };
 
   struct CjumpOperation : public Instruction{
+    CjumpOperation() : Instruction(L1::cjump_op) {};
     ComparisonExpression cexp;
     std::string then_label;
     std::string else_label;
@@ -79,6 +86,7 @@ namespace L2 {
   enum ArithmeticOperator { plusequal, minusequal, timesequal, andequal };
 
   struct MemoryArithmeticOperation : public Instruction{
+    MemoryArithmeticOperation() : Instruction(L1::memory_arithmetic_op) {};
     L2::MemoryReference lhs;
     ArithmeticOperator op;
     L2::L2_t rhs;
@@ -86,6 +94,7 @@ namespace L2 {
   };
 
   struct MemoryArithmeticOperation2 : public Instruction{
+    MemoryArithmeticOperation2() : Instruction(L1::memory_arithmetic2_op) {};
     L2::L2_w lhs;
     ArithmeticOperator op;
     L2::MemoryReference rhs;
@@ -93,6 +102,7 @@ namespace L2 {
   };
 
   struct ArithmeticOperation : public Instruction{
+    ArithmeticOperation() : Instruction(L1::arithmetic_op) {};
     L2::L2_w lhs;
     ArithmeticOperator op;
     L2::L2_t rhs;
@@ -100,34 +110,42 @@ namespace L2 {
   };
 
   struct Label : public Instruction{
+    Label() : Instruction(L1::label_op) {};
     std::string name;
   };
 
   struct FunctionCall : public Instruction{
+    FunctionCall() : Instruction(L1::function_call_op) {};
     L2_item function_name;
-    int64_t n_args;
+    int64_t n_args = 0;
   };
 
   struct RuntimeCall : public Instruction{
+    RuntimeCall() : Instruction(L1::runtime_call_op) {};
     L2_item function_name;
-    int64_t n_args;
+    int64_t n_args = 0;
   };
 
-  struct ReturnCall : public Instruction{};
+  struct ReturnCall : public Instruction{
+    ReturnCall() : Instruction(L1::return_op) {};
+  };
 
   struct Assignment : public Instruction{
+    Assignment() : Instruction(L1::assignment_op) {};
     L2::L2_item lhs;
     L2::L2_item rhs;
     bool y_to_x_type = true;
   };
 
   struct Load : public Instruction{
+    Load() : Instruction(L1::load_op) {};
     L2::L2_w lhs;
     L2::MemoryReference rhs;
     bool y_to_x_type = true;
   };
 
   struct Store : public Instruction{
+    Store() : Instruction(L1::store_op) {};
     L2::MemoryReference lhs;
     L2::L2_s rhs;
     bool y_to_x_type = true;
@@ -136,6 +154,7 @@ namespace L2 {
   enum ShiftOperator { lshift, rshift };
 
   struct ShiftOperation : public Instruction{
+    ShiftOperation() : Instruction(L1::shift_op) {};
     L2::L2_w lhs;
     L2::ShiftOperator op;
     L2::L2_item rhs;
@@ -0,0 +1,390 @@
+#include <string>
+#include <vector>
+#include <utility>
+#include <set>
+#include <iostream>
+#include <map>
+#include <chrono>
+#include <cctype>
+
+#include "compiler.h"
+#include "liveness.h"
+#include "interference.h"
+
+using namespace std;
+
+const set<string> L1_registers = {
+  "rax", "rbx", "rbp", "rcx", "rdx", "rdi", "rsi", "rsp",
+  "r8", "r9", "r10", "r11", "r12", "r13", "r14", "r15"
+};
+
+/*
+ * An L2 label as L1 names it, _ instead of :. The L2 parser leaves
+ * whatever followed a cjump's labels (spaces, comments) on them.
+ */
+string to_L1_label(const string &label) {
+  size_t end = 1;
+  while (end < label.size() && (isalnum(label[end]) || label[end] == '_' || label[end] == '-')) {
+    end++;
+  }
+  return "_" + label.substr(1, end - 1);
+}
+
+/*
+ * An allocated L2 item as the L1 parser would have read it: labels
+ * start with _ rather than :, and only registers are marked r.
+ */
+template <typename T>
+T to_L1_item(const L2::L2_item &item) {
+  T newItem;
+  newItem.name = item.name[0] == ':' ? to_L1_label(item.name) : item.name;
+  newItem.r = L1_registers.count(newItem.name) > 0;
+  return newItem;
+}
+
+L1::MemoryReference to_L1_memory(const L2::MemoryReference &m) {
+  L1::MemoryReference memRef;
+  memRef.value = to_L1_item<L1::L1_x>(m.value);
+  memRef.offset.name = to_string(m.offset_int);
+  memRef.offset_int = m.offset_int;
+  return memRef;
+}
+
+L1::ComparisonExpression to_L1_cexp(const L2::ComparisonExpression &cexp) {
+  L1::ComparisonExpression newCexp;
+  newCexp.lhs = to_L1_item<L1::L1_t>(cexp.lhs);
+  newCexp.op = (L1::ComparisonOperator)cexp.op;
+  newCexp.rhs = to_L1_item<L1::L1_t>(cexp.rhs);
+  return newCexp;
+}
+
+/*
+ * Turns an allocated function, whose instructions only name
+ * registers, into the L1 function it stands for.
+ */
+L1::Function *to_L1(L2::Function *f) {
+  L1::Function *newF = new L1::Function();
+  newF->name = f->name;
+  newF->arguments = f->arguments;
+  newF->locals = f->locals;
+  for (auto i : f->instructions) {
+    L1::Instruction *newI = NULL;
+    switch (i->opcode) {
+      case L1::load_op: {
+        L2::Load *load = static_cast<L2::Load *>(i);
+        L1::Load *newLoad = new L1::Load();
+        newLoad->lhs = to_L1_item<L1::L1_w>(load->lhs);
+        newLoad->rhs = to_L1_memory(load->rhs);
+        newI = newLoad;
+        break;
+      }
+      case L1::store_op: {
+        L2::Store *store = static_cast<L2::Store *>(i);
+        L1::Store *newStore = new L1::Store();
+        newStore->lhs = to_L1_memory(store->lhs);
+        newStore->rhs = to_L1_item<L1::L1_s>(store->rhs);
+        newI = newStore;
+        break;
+      }
+      case L1::assignment_op: {
+        L2::Assignment *assn = static_cast<L2::Assignment *>(i);
+        L1::Assignment *newAssn = new L1::Assignment();
+        newAssn->lhs = to_L1_item<L1::L1_w>(assn->lhs);
+        newAssn->rhs = to_L1_item<L1::L1_s>(assn->rhs);
+        newI = newAssn;
+        break;
+      }
+      case L1::return_op:
+        newI = new L1::ReturnCall();
+        break;
+      case L1::arithmetic_op: {
+        L2::ArithmeticOperation *aop = static_cast<L2::ArithmeticOperation *>(i);
+        L1::ArithmeticOperation *newAop = new L1::ArithmeticOperation();
+        newAop->lhs = to_L1_item<L1::L1_w>(aop->lhs);
+        newAop->op = (L1::ArithmeticOperator)aop->op;
+        newAop->rhs = to_L1_item<L1::L1_t>(aop->rhs);
+        newI = newAop;
+        break;
+      }
+      case L1::memory_arithmetic_op: {
+        L2::MemoryArithmeticOperation *maop = static_cast<L2::MemoryArithmeticOperation *>(i);
+        L1::MemoryArithmeticOperation *newMaop = new L1::MemoryArithmeticOperation();
+        newMaop->lhs = to_L1_memory(maop->lhs);
+        newMaop->op = (L1::ArithmeticOperator)maop->op;
+        newMaop->rhs = to_L1_item<L1::L1_t>(maop->rhs);
+        newI = newMaop;
+        break;
+      }
+      case L1::memory_arithmetic2_op: {
+        L2::MemoryArithmeticOperation2 *maop = static_cast<L2::MemoryArithmeticOperation2 *>(i);
+        L1::MemoryArithmeticOperation2 *newMaop = new L1::MemoryArithmeticOperation2();
+        newMaop->lhs = to_L1_item<L1::L1_w>(maop->lhs);
+        newMaop->op = (L1::ArithmeticOperator)maop->op;
+        newMaop->rhs = to_L1_memory(maop->rhs);
+        newI = newMaop;
+        break;
+      }
+      case L1::shift_op: {
+        L2::ShiftOperation *sop = static_cast<L2::ShiftOperation *>(i);
+        L1::ShiftOperation *newSop = new L1::ShiftOperation();
+        newSop->lhs = to_L1_item<L1::L1_w>(sop->lhs);
+        newSop->op = (L1::ShiftOperator)sop->op;
+        // the shift amount is kept ready to print, as the L1 parser does
+        newSop->rhs.name = sop->rhs.name == "rcx" ? "%cl" : "$" + sop->rhs.name;
+        newI = newSop;
+        break;
+      }
+      case L1::comparison_op: {
+        L2::ComparisonOperation *comp = static_cast<L2::ComparisonOperation *>(i);
+        L1::ComparisonOperation *newComp = new L1::ComparisonOperation();
+        newComp->lhs = to_L1_item<L1::L1_w>(comp->lhs);
+        newComp->cexp = to_L1_cexp(comp->cexp);
+        newI = newComp;
+        break;
+      }
+      case L1::runtime_call_op: {
+        L2::RuntimeCall *rCall = static_cast<L2::RuntimeCall *>(i);
+        L1::RuntimeCall *newCall = new L1::RuntimeCall();
+        newCall->function_name.name = rCall->function_name.name == "array-error" ? "array_error" : rCall->function_name.name;
+        newCall->n_args = rCall->n_args;
+        newI = newCall;
+        break;
+      }
+      case L1::function_call_op: {
+        L2::FunctionCall *fCall = static_cast<L2::FunctionCall *>(i);
+        L1::FunctionCall *newCall = new L1::FunctionCall();
+        newCall->function_name = to_L1_item<L1::L1_item>(fCall->function_name);
+        newCall->function_name.r = false;
+        newCall->n_args = fCall->n_args;
+        newI = newCall;
+        break;
+      }
+      case L1::label_op: {
+        L2::Label *lbl = static_cast<L2::Label *>(i);
+        L1::Label *newLbl = new L1::Label();
+        newLbl->name = to_L1_label(lbl->name);
+        newI = newLbl;
+        break;
+      }
+      case L1::wawwe_op: {
+        L2::WawweOperation *wawwe = static_cast<L2::WawweOperation *>(i);
+        L1::WawweOperation *newWawwe = new L1::WawweOperation();
+        newWawwe->lhs = to_L1_item<L1::L1_w>(wawwe->lhs);
+        newWawwe->start = to_L1_item<L1::L1_w>(wawwe->start);
+        newWawwe->mult = to_L1_item<L1::L1_w>(wawwe->mult);
+        newWawwe->e = wawwe->e;
+        newI = newWawwe;
+        break;
+      }
+      case L1::cjump_op: {
+        L2::CjumpOperation *cj = static_cast<L2::CjumpOperation *>(i);
+        L1::CjumpOperation *newCj = new L1::CjumpOperation();
+        newCj->cexp = to_L1_cexp(cj->cexp);
+        newCj->then_label = to_L1_label(cj->then_label);
+        newCj->else_label = to_L1_label(cj->else_label);
+        newI = newCj;
+        break;
+      }
+      case L1::goto_op: {
+        L2::GotoOperation *gt = static_cast<L2::GotoOperation *>(i);
+        L1::GotoOperation *newGoto = new L1::GotoOperation();
+        newGoto->lbl = to_L1_item<L1::L1_item>(gt->lbl);
+        newI = newGoto;
+        break;
+      }
+    }
+    newF->instructions.push_back(newI);
+  }
+  return newF;
+}
+
+/*
+ * An L1 item as it is written in L1 source.
+ */
+string L1_source(const L1::L1_item &item) {
+  if (item.name[0] == '_') {
+    return ":" + item.name.substr(1);
+  }
+  return item.name;
+}
+
+string L1_source(const L1::MemoryReference &m) {
+  return "(mem " + m.value.name + " " + to_string(m.offset_int) + ")";
+}
+
+string L1_source(L1::ArithmeticOperator op) {
+  switch (op) {
+    case L1::plusequal:
+      return "+=";
+    case L1::minusequal:
+      return "-=";
+    case L1::andequal:
+      return "&=";
+    case L1::timesequal:
+      return "*=";
+  }
+  return "";
+}
+
+string L1_source(const L1::ComparisonExpression &cexp) {
+  string op_string;
+  switch (cexp.op) {
+    case L1::lessthan:
+      op_string = "<";
+      break;
+    case L1::lessthanorequal:
+      op_string = "<=";
+      break;
+    case L1::equal:
+      op_string = "=";
+      break;
+  }
+  return cexp.lhs.name + " " + op_string + " " + cexp.rhs.name;
+}
+
+/*
+ * Writes p out as L1 source.
+ */
+void dump_program(const L1::Program &p, ostream &outputFile) {
+  outputFile << "(" << p.entryPointLabel << "\n";
+  for (auto f : p.functions) {
+    outputFile << "(" << f->name << "\n" << f->arguments << " " << f->locals << "\n";
+    for (auto i : f->instructions) {
+      switch (i->opcode) {
+        case L1::load_op: {
+          L1::Load *load = static_cast<L1::Load *>(i);
+          outputFile << "(" << load->lhs.name << " <- " << L1_source(load->rhs) << ")\n";
+          break;
+        }
+        case L1::store_op: {
+          L1::Store *store = static_cast<L1::Store *>(i);
+          outputFile << "(" << L1_source(store->lhs) << " <- " << L1_source(store->rhs) << ")\n";
+          break;
+        }
+        case L1::assignment_op: {
+          L1::Assignment *assn = static_cast<L1::Assignment *>(i);
+          outputFile << "(" << assn->lhs.name << " <- " << L1_source(assn->rhs) << ")\n";
+          break;
+        }
+        case L1::return_op: {
+          outputFile << "(return)\n";
+          break;
+        }
+        case L1::arithmetic_op: {
+          L1::ArithmeticOperation *aop = static_cast<L1::ArithmeticOperation *>(i);
+          outputFile << "(" << aop->lhs.name << " " << L1_source(aop->op) << " " << aop->rhs.name << ")\n";
+          break;
+        }
+        case L1::memory_arithmetic_op: {
+          L1::MemoryArithmeticOperation *maop = static_cast<L1::MemoryArithmeticOperation *>(i);
+          outputFile << "(" << L1_source(maop->lhs) << " " << L1_source(maop->op) << " " << maop->rhs.name << ")\n";
+          break;
+        }
+        case L1::memory_arithmetic2_op: {
+          L1::MemoryArithmeticOperation2 *maop = static_cast<L1::MemoryArithmeticOperation2 *>(i);
+          outputFile << "(" << maop->lhs.name << " " << L1_source(maop->op) << " " << L1_source(maop->rhs) << ")\n";
+          break;
+        }
+        case L1::shift_op: {
+          L1::ShiftOperation *sop = static_cast<L1::ShiftOperation *>(i);
+          string sop_string = sop->op == L1::lshift ? "<<=" : ">>=";
+          string amount = sop->rhs.name == "%cl" ? "rcx" : sop->rhs.name.substr(1);
+          outputFile << "(" << sop->lhs.name << " " << sop_string << " " << amount << ")\n";
+          break;
+        }
+        case L1::comparison_op: {
+          L1::ComparisonOperation *comp = static_cast<L1::ComparisonOperation *>(i);
+          outputFile << "(" << comp->lhs.name << " <- " << L1_source(comp->cexp) << ")\n";
+          break;
+        }
+        case L1::runtime_call_op: {
+          L1::RuntimeCall *rCall = static_cast<L1::RuntimeCall *>(i);
+          string name = rCall->function_name.name == "array_error" ? "array-error" : rCall->function_name.name;
+          outputFile << "(call " << name << " " << rCall->n_args << ")\n";
+          break;
+        }
+        case L1::function_call_op: {
+          L1::FunctionCall *fCall = static_cast<L1::FunctionCall *>(i);
+          outputFile << "(call " << L1_source(fCall->function_name) << " " << fCall->n_args << ")\n";
+          break;
+        }
+        case L1::label_op: {
+          L1::Label *lbl = static_cast<L1::Label *>(i);
+          outputFile << ":" << lbl->name.substr(1) << "\n";
+          break;
+        }
+        case L1::wawwe_op: {
+          L1::WawweOperation *wawwe = static_cast<L1::WawweOperation *>(i);
+          outputFile << "(" << wawwe->lhs.name << " @ " << wawwe->start.name << " " << wawwe->mult.name << " " << wawwe->e << ")\n";
+          break;
+        }
+        case L1::cjump_op: {
+          L1::CjumpOperation *cj = static_cast<L1::CjumpOperation *>(i);
+          outputFile << "(cjump " << L1_source(cj->cexp) << " :" << cj->then_label.substr(1) << " :" << cj->else_label.substr(1) << ")\n";
+          break;
+        }
+        case L1::goto_op: {
+          L1::GotoOperation *gt = static_cast<L1::GotoOperation *>(i);
+          outputFile << "(goto " << L1_source(gt->lbl) << ")\n";
+          break;
+        }
+      }
+
+    }
+    outputFile << ")\n";
+  }
+  outputFile << ")\n";
+}
+
+/*
+ * Allocates registers for every function of p, spilling until each
+ * one colors, and returns the resulting L1 program.
+ */
+L1::Program compile_L2(L2::Program p, bool verbose) {
+  auto start = chrono::steady_clock::now();
+  chrono::steady_clock::duration liveness_time(0);
+
+  /* Generate GEN/KILL first
+   */
+  L1::Program newP;
+  newP.entryPointLabel = p.entryPointLabel;
+  vector<L2::Function *> allocated_functions;
+  int int_i;
+  for (auto f : p.functions) {
+    bool spilled = false;
+    bool needs_spilled = false;
+    int n_spilled = 0;
+    int doof;
+    pair<map<string, int>, vector<string>> analysis;
+    do {
+      spilled = false;
+      auto liveness_start = chrono::steady_clock::now();
+      L2::Liveness liveness = liveness_analysis(f);
+      liveness_time += chrono::steady_clock::now() - liveness_start;
+      analysis = Analysis::interference_analysis(liveness.IN, liveness.OUT, liveness.KILL, f);
+      needs_spilled = analysis.second.size() > 0;
+      if (needs_spilled) {
+        for (auto v : analysis.second) {
+          spilled = true;
+          f = Analysis::spill(f, v, f->locals+1);
+        }
+      }
+    } while (spilled == true);
+    f = Analysis::translate_to_L1(f, analysis.second);
+    allocated_functions.push_back(f);
+  }
+
+  auto allocated = chrono::steady_clock::now();
+  for (auto f : allocated_functions) {
+    newP.functions.push_back(to_L1(f));
+  }
+  auto translated = chrono::steady_clock::now();
+
+  if (verbose) {
+    cerr << "liveness: " << chrono::duration_cast<chrono::milliseconds>(liveness_time).count() << " ms\n";
+    cerr << "interference, spilling: " << chrono::duration_cast<chrono::milliseconds>(allocated - start - liveness_time).count() << " ms\n";
+    cerr << "translation: " << chrono::duration_cast<chrono::milliseconds>(translated - allocated).count() << " ms\n";
+  }
+
+  return newP;
+}
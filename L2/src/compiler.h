@@ -0,0 +1,9 @@
+#pragma once
+
+#include <ostream>
+
+#include "L2.h"
+
+L1::Program compile_L2(L2::Program p, bool verbose);
+
+void dump_program(const L1::Program &p, std::ostream &outputFile);
@@ -64,152 +64,174 @@ L2::Store* generate_spill_store(string rhs_name, int64_t offset) {
   stackref.value = rsp;
   stackref.offset_int = (offset - 1) * 8;
   rhs.name = rhs_name;
+  rhs.r = true;
   spill_store->rhs = rhs;
   spill_store->lhs = stackref;
   return spill_store;
 }
 
 L2::Instruction *replace_var(L2::Instruction *i, string var, string var_name) {
-  if (L2::Load *load = dynamic_cast<L2::Load *>(i)) {
-    if (load->lhs.name == var)
-      load->lhs.name = var_name;
-    if (load->rhs.value.name == var)
-      load->rhs.value.name = var_name;
-    return load;
-  }
-  else if (L2::Store *store = dynamic_cast<L2::Store *>(i)) {
-    if (store->rhs.name == var)
-      store->rhs.name = var_name;
-    if (store->lhs.value.name == var)
-      store->lhs.value.name = var_name;
-    return store;
-  }
-  else if (L2::Assignment *assn = dynamic_cast<L2::Assignment *>(i)) {
-    if (assn->lhs.name == var)
-      assn->lhs.name = var_name;
-    if (assn->rhs.name == var)
-      assn->rhs.name = var_name;
-    return assn;
-  }
-  else if (L2::ReturnCall *ret = dynamic_cast<L2::ReturnCall *>(i)) {
-    return ret;
-  }
-  else if (L2::ArithmeticOperation *aop = dynamic_cast<L2::ArithmeticOperation *>(i)) {
-    if (aop->lhs.name == var)
-      aop->lhs.name = var_name;
-    if (aop->rhs.name == var)
-      aop->rhs.name =var_name;
-    return aop;
-  }
-  else if (L2::MemoryArithmeticOperation *maop = dynamic_cast<L2::MemoryArithmeticOperation *>(i)) {
-    if (maop->lhs.value.name == var)
-      maop->lhs.value.name = var_name;
-    if (maop->rhs.name == var)
-      maop->rhs.name = var_name;
-    return maop;
-  }
-  else if (L2::MemoryArithmeticOperation2 *maop = dynamic_cast<L2::MemoryArithmeticOperation2 *>(i)) {
-    if (maop->lhs.name == var)
-      maop->lhs.name = var_name;
-    if (maop->rhs.value.name == var)
-      maop->rhs.value.name = var_name;
-    return maop;
-  }
-  else if (L2::ShiftOperation *sop = dynamic_cast<L2::ShiftOperation *>(i)) {
-    if (sop->lhs.name == var)
-      sop->lhs.name = var_name;
-    if (sop->rhs.name == var)
-      sop->rhs.name = var_name;
-    return sop;
-  }
-  else if (L2::ComparisonOperation *comp = dynamic_cast<L2::ComparisonOperation *>(i)) {
-    if (comp->lhs.name == var)
-      comp->lhs.name = var_name;
-    if (comp->cexp.lhs.name == var)
-      comp->cexp.lhs.name = var_name;
-    if (comp->cexp.rhs.name == var)
-      comp->cexp.rhs.name = var_name;
-    return comp;
-  }
-  else if (L2::RuntimeCall *rCall = dynamic_cast<L2::RuntimeCall *>(i)) {
-    if (rCall->function_name.name == var)
-      rCall->function_name.name = var_name;
-    return rCall;
-  }
-  else if (L2::FunctionCall *fCall = dynamic_cast<L2::FunctionCall *>(i)) {
-    if (fCall->function_name.name == var)
-      fCall->function_name.name = var_name;
-    return fCall;
-  }
-  else if (L2::Label *lbl = dynamic_cast<L2::Label *>(i)) {
-    return lbl;
-  }
-  else if (L2::WawweOperation *wawwe = dynamic_cast<L2::WawweOperation *>(i)) {
-    if (wawwe->lhs.name == var)
-      wawwe->lhs.name = var_name;
-    if (wawwe->start.name == var)
-      wawwe->start.name = var_name;
-    if (wawwe->mult.name == var)
-      wawwe->mult.name = var_name;
-    return wawwe;
-  }
-  else if (L2::CjumpOperation *cj = dynamic_cast<L2::CjumpOperation *>(i)) {
-    if (cj->cexp.lhs.name == var)
-      cj->cexp.lhs.name = var_name;
-    if (cj->cexp.rhs.name == var)
-      cj->cexp.rhs.name = var_name;
-    return cj;
-  }
-  else if (L2::GotoOperation *gt = dynamic_cast<L2::GotoOperation *>(i)) {
-    return gt;
+  switch (i->opcode) {
+    case L1::load_op: {
+      L2::Load *load = static_cast<L2::Load *>(i);
+      if (load->lhs.name == var)
+        load->lhs.name = var_name;
+      if (load->rhs.value.name == var)
+        load->rhs.value.name = var_name;
+      break;
+    }
+    case L1::store_op: {
+      L2::Store *store = static_cast<L2::Store *>(i);
+      if (store->rhs.name == var)
+        store->rhs.name = var_name;
+      if (store->lhs.value.name == var)
+        store->lhs.value.name = var_name;
+      break;
+    }
+    case L1::assignment_op: {
+      L2::Assignment *assn = static_cast<L2::Assignment *>(i);
+      if (assn->lhs.name == var)
+        assn->lhs.name = var_name;
+      if (assn->rhs.name == var)
+        assn->rhs.name = var_name;
+      break;
+    }
+    case L1::return_op:
+      break;
+    case L1::arithmetic_op: {
+      L2::ArithmeticOperation *aop = static_cast<L2::ArithmeticOperation *>(i);
+      if (aop->lhs.name == var)
+        aop->lhs.name = var_name;
+      if (aop->rhs.name == var)
+        aop->rhs.name =var_name;
+      break;
+    }
+    case L1::memory_arithmetic_op: {
+      L2::MemoryArithmeticOperation *maop = static_cast<L2::MemoryArithmeticOperation *>(i);
+      if (maop->lhs.value.name == var)
+        maop->lhs.value.name = var_name;
+      if (maop->rhs.name == var)
+        maop->rhs.name = var_name;
+      break;
+    }
+    case L1::memory_arithmetic2_op: {
+      L2::MemoryArithmeticOperation2 *maop = static_cast<L2::MemoryArithmeticOperation2 *>(i);
+      if (maop->lhs.name == var)
+        maop->lhs.name = var_name;
+      if (maop->rhs.value.name == var)
+        maop->rhs.value.name = var_name;
+      break;
+    }
+    case L1::shift_op: {
+      L2::ShiftOperation *sop = static_cast<L2::ShiftOperation *>(i);
+      if (sop->lhs.name == var)
+        sop->lhs.name = var_name;
+      if (sop->rhs.name == var)
+        sop->rhs.name = var_name;
+      break;
+    }
+    case L1::comparison_op: {
+      L2::ComparisonOperation *comp = static_cast<L2::ComparisonOperation *>(i);
+      if (comp->lhs.name == var)
+        comp->lhs.name = var_name;
+      if (comp->cexp.lhs.name == var)
+        comp->cexp.lhs.name = var_name;
+      if (comp->cexp.rhs.name == var)
+        comp->cexp.rhs.name = var_name;
+      break;
+    }
+    case L1::runtime_call_op: {
+      L2::RuntimeCall *rCall = static_cast<L2::RuntimeCall *>(i);
+      if (rCall->function_name.name == var)
+        rCall->function_name.name = var_name;
+      break;
+    }
+    case L1::function_call_op: {
+      L2::FunctionCall *fCall = static_cast<L2::FunctionCall *>(i);
+      if (fCall->function_name.name == var)
+        fCall->function_name.name = var_name;
+      break;
+    }
+    case L1::label_op:
+      break;
+    case L1::wawwe_op: {
+      L2::WawweOperation *wawwe = static_cast<L2::WawweOperation *>(i);
+      if (wawwe->lhs.name == var)
+        wawwe->lhs.name = var_name;
+      if (wawwe->start.name == var)
+        wawwe->start.name = var_name;
+      if (wawwe->mult.name == var)
+        wawwe->mult.name = var_name;
+      break;
+    }
+    case L1::cjump_op: {
+      L2::CjumpOperation *cj = static_cast<L2::CjumpOperation *>(i);
+      if (cj->cexp.lhs.name == var)
+        cj->cexp.lhs.name = var_name;
+      if (cj->cexp.rhs.name == var)
+        cj->cexp.rhs.name = var_name;
+      break;
+    }
+    case L1::goto_op:
+      break;
   }
+  return i;
 }
 
 bool needs_spilled(L2::Instruction *i, string var) {
-  if (L2::Load *load = dynamic_cast<L2::Load *>(i))  {
-    return (load->lhs.name == var || load->rhs.value.name == var);
-  }
-  else if (L2::Store *store = dynamic_cast<L2::Store *>(i)) {
-    return (store->rhs.name == var || store->lhs.value.name == var);
-  }
-  else if (L2::Assignment *assn = dynamic_cast<L2::Assignment *>(i)) {
-    return (assn->lhs.name == var || assn->rhs.name == var);
-  }
-  else if (L2::ReturnCall *ret = dynamic_cast<L2::ReturnCall *>(i)) {
-    return false;
-  }
-  else if (L2::ArithmeticOperation *aop = dynamic_cast<L2::ArithmeticOperation *>(i)) {
-    return (aop->lhs.name == var || aop->rhs.name == var);
-  }
-  else if (L2::MemoryArithmeticOperation *maop = dynamic_cast<L2::MemoryArithmeticOperation *>(i)) {
-    return (maop->lhs.value.name == var || maop->rhs.name == var);
-  }
-  else if (L2::MemoryArithmeticOperation2 *maop = dynamic_cast<L2::MemoryArithmeticOperation2 *>(i)) {
-    return (maop->lhs.name == var || maop->rhs.value.name == var);
-  }
-  else if (L2::ShiftOperation *sop = dynamic_cast<L2::ShiftOperation *>(i)) {
-    return (sop->lhs.name == var || sop->rhs.name == var);
-  }
-  else if (L2::ComparisonOperation *comp = dynamic_cast<L2::ComparisonOperation *>(i)) {
-    return (comp->lhs.name == var || comp->cexp.lhs.name == var || comp->cexp.rhs.name == var);
-  }
-  else if (L2::RuntimeCall *rCall = dynamic_cast<L2::RuntimeCall *>(i)) {
-    return (rCall->function_name.name == var);
-  }
-  else if (L2::FunctionCall *fCall = dynamic_cast<L2::FunctionCall *>(i)) {
-    return (fCall->function_name.name == var);
-  }
-  else if (L2::Label *lbl = dynamic_cast<L2::Label *>(i)) {
-    return false;
-  }
-  else if (L2::WawweOperation *wawwe = dynamic_cast<L2::WawweOperation *>(i)) {
-    return (wawwe->lhs.name == var || wawwe->start.name == var || wawwe->mult.name == var);
-  }
-  else if (L2::CjumpOperation *cj = dynamic_cast<L2::CjumpOperation *>(i)) {
-    return (cj->cexp.lhs.name == var || cj->cexp.rhs.name == var);
-  }
-  else if (L2::GotoOperation *gt = dynamic_cast<L2::GotoOperation *>(i)) {
-    return false;
+  switch (i->opcode) {
+    case L1::load_op: {
+      L2::Load *load = static_cast<L2::Load *>(i);
+      return (load->lhs.name == var || load->rhs.value.name == var);
+    }
+    case L1::store_op: {
+      L2::Store *store = static_cast<L2::Store *>(i);
+      return (store->rhs.name == var || store->lhs.value.name == var);
+    }
+    case L1::assignment_op: {
+      L2::Assignment *assn = static_cast<L2::Assignment *>(i);
+      return (assn->lhs.name == var || assn->rhs.name == var);
+    }
+    case L1::arithmetic_op: {
+      L2::ArithmeticOperation *aop = static_cast<L2::ArithmeticOperation *>(i);
+      return (aop->lhs.name == var || aop->rhs.name == var);
+    }
+    case L1::memory_arithmetic_op: {
+      L2::MemoryArithmeticOperation *maop = static_cast<L2::MemoryArithmeticOperation *>(i);
+      return (maop->lhs.value.name == var || maop->rhs.name == var);
+    }
+    case L1::memory_arithmetic2_op: {
+      L2::MemoryArithmeticOperation2 *maop = static_cast<L2::MemoryArithmeticOperation2 *>(i);
+      return (maop->lhs.name == var || maop->rhs.value.name == var);
+    }
+    case L1::shift_op: {
+      L2::ShiftOperation *sop = static_cast<L2::ShiftOperation *>(i);
+      return (sop->lhs.name == var || sop->rhs.name == var);
+    }
+    case L1::comparison_op: {
+      L2::ComparisonOperation *comp = static_cast<L2::ComparisonOperation *>(i);
+      return (comp->lhs.name == var || comp->cexp.lhs.name == var || comp->cexp.rhs.name == var);
+    }
+    case L1::runtime_call_op: {
+      L2::RuntimeCall *rCall = static_cast<L2::RuntimeCall *>(i);
+      return (rCall->function_name.name == var);
+    }
+    case L1::function_call_op: {
+      L2::FunctionCall *fCall = static_cast<L2::FunctionCall *>(i);
+      return (fCall->function_name.name == var);
+    }
+    case L1::wawwe_op: {
+      L2::WawweOperation *wawwe = static_cast<L2::WawweOperation *>(i);
+      return (wawwe->lhs.name == var || wawwe->start.name == var || wawwe->mult.name == var);
+    }
+    case L1::cjump_op: {
+      L2::CjumpOperation *cj = static_cast<L2::CjumpOperation *>(i);
+      return (cj->cexp.lhs.name == var || cj->cexp.rhs.name == var);
+    }
+    case L1::return_op:
+    case L1::label_op:
+    case L1::goto_op:
+      return false;
   }
   return false;
 }
@@ -436,67 +458,87 @@ L2::Function* Analysis::translate_to_L1(L2::Function *f, std::vector<std::string
   // ((mem rsp X) <- non-var-name)
   int idx;
   for (auto i : f->instructions) {
-    if (L2::Load *load = dynamic_cast<L2::Load *>(i)) {
-      load->lhs = convert_L2_item(load->lhs);
-      load->rhs.value = convert_L2_item(load->rhs.value);
-    }
-    else if (L2::Store *store = dynamic_cast<L2::Store *>(i)) {
-      store->rhs = convert_L2_item(store->rhs);
-      store->lhs.value = convert_L2_item(store->lhs.value);
-    }
-    else if (L2::Assignment *assn = dynamic_cast<L2::Assignment *>(i)) {
-      assn->lhs = convert_L2_item(assn->lhs);
-      assn->rhs = convert_L2_item(assn->rhs);
-    }
-    else if (L2::ReturnCall *ret = dynamic_cast<L2::ReturnCall *>(i)) {
-      ;
-    }
-    else if (L2::ArithmeticOperation *aop = dynamic_cast<L2::ArithmeticOperation *>(i)) {
-      aop->lhs = convert_L2_item(aop->lhs);
-      aop->rhs = convert_L2_item(aop->rhs);
-    }
-    else if (L2::MemoryArithmeticOperation *maop = dynamic_cast<L2::MemoryArithmeticOperation *>(i)) {
-      // rhs is potentially a variable.
-      maop->rhs = convert_L2_item(maop->rhs);
-    }
-    else if (L2::MemoryArithmeticOperation2 *maop = dynamic_cast<L2::MemoryArithmeticOperation2 *>(i)) {
-      maop->lhs = convert_L2_item(maop->lhs);
-    }
-    else if (L2::ShiftOperation *sop = dynamic_cast<L2::ShiftOperation *>(i)) {
-      sop->lhs = convert_L2_item(sop->lhs);
-      sop->rhs = convert_L2_item(sop->rhs);
-    }
-    else if (L2::ComparisonOperation *comp = dynamic_cast<L2::ComparisonOperation *>(i)) {
-      // comparison is very tedious. lhs, and both halves of the comparison
-      // might need to be spilled/have their values replaced with registers
-      // to be checked for spilling.
-      comp->lhs = convert_L2_item(comp->lhs);
-      comp->cexp.lhs = convert_L2_item(comp->cexp.lhs);
-      comp->cexp.rhs = convert_L2_item(comp->cexp.rhs);
-    }
-    else if (L2::RuntimeCall *rCall = dynamic_cast<L2::RuntimeCall *>(i)) {
-      rCall->function_name = convert_L2_item(rCall->function_name);
-      ;
-    }
-    else if (L2::FunctionCall *fCall = dynamic_cast<L2::FunctionCall *>(i)) {
-      fCall->function_name = convert_L2_item(fCall->function_name);
-      ;
-    }
-    else if (L2::Label *lbl = dynamic_cast<L2::Label *>(i)) {
-      ;
-    }
-    else if (L2::WawweOperation *wawwe = dynamic_cast<L2::WawweOperation *>(i)) {
-      wawwe->lhs = convert_L2_item(wawwe->lhs);
-      wawwe->start = convert_L2_item(wawwe->lhs);
-      wawwe->mult = convert_L2_item(wawwe->mult);
-    }
-    else if (L2::CjumpOperation *cj = dynamic_cast<L2::CjumpOperation *>(i)) {
-      cj->cexp.lhs = convert_L2_item(cj->cexp.lhs);
-      cj->cexp.rhs = convert_L2_item(cj->cexp.rhs);
-    }
-    else if (L2::GotoOperation *gt = dynamic_cast<L2::GotoOperation *>(i)) {
-      ;
-    } else {
+    switch (i->opcode) {
+      case L1::load_op: {
+        L2::Load *load = static_cast<L2::Load *>(i);
+        load->lhs = convert_L2_item(load->lhs);
+        load->rhs.value = convert_L2_item(load->rhs.value);
+        break;
+      }
+      case L1::store_op: {
+        L2::Store *store = static_cast<L2::Store *>(i);
+        store->rhs = convert_L2_item(store->rhs);
+        store->lhs.value = convert_L2_item(store->lhs.value);
+        break;
+      }
+      case L1::assignment_op: {
+        L2::Assignment *assn = static_cast<L2::Assignment *>(i);
+        assn->lhs = convert_L2_item(assn->lhs);
+        assn->rhs = convert_L2_item(assn->rhs);
+        break;
+      }
+      case L1::return_op:
+        break;
+      case L1::arithmetic_op: {
+        L2::ArithmeticOperation *aop = static_cast<L2::ArithmeticOperation *>(i);
+        aop->lhs = convert_L2_item(aop->lhs);
+        aop->rhs = convert_L2_item(aop->rhs);
+        break;
+      }
+      case L1::memory_arithmetic_op: {
+        L2::MemoryArithmeticOperation *maop = static_cast<L2::MemoryArithmeticOperation *>(i);
+        // rhs is potentially a variable.
+        maop->rhs = convert_L2_item(maop->rhs);
+        break;
+      }
+      case L1::memory_arithmetic2_op: {
+        L2::MemoryArithmeticOperation2 *maop = static_cast<L2::MemoryArithmeticOperation2 *>(i);
+        maop->lhs = convert_L2_item(maop->lhs);
+        break;
+      }
+      case L1::shift_op: {
+        L2::ShiftOperation *sop = static_cast<L2::ShiftOperation *>(i);
+        sop->lhs = convert_L2_item(sop->lhs);
+        sop->rhs = convert_L2_item(sop->rhs);
+        break;
+      }
+      case L1::comparison_op: {
+        L2::ComparisonOperation *comp = static_cast<L2::ComparisonOperation *>(i);
+        // comparison is very tedious. lhs, and both halves of the comparison
+        // might need to be spilled/have their values replaced with registers
+        // to be checked for spilling.
+        comp->lhs = convert_L2_item(comp->lhs);
+        comp->cexp.lhs = convert_L2_item(comp->cexp.lhs);
+        comp->cexp.rhs = convert_L2_item(comp->cexp.rhs);
+        break;
+      }
+      case L1::runtime_call_op: {
+        L2::RuntimeCall *rCall = static_cast<L2::RuntimeCall *>(i);
+        rCall->function_name = convert_L2_item(rCall->function_name);
+        break;
+      }
+      case L1::function_call_op: {
+        L2::FunctionCall *fCall = static_cast<L2::FunctionCall *>(i);
+        fCall->function_name = convert_L2_item(fCall->function_name);
+        break;
+      }
+      case L1::label_op:
+        break;
+      case L1::wawwe_op: {
+        L2::WawweOperation *wawwe = static_cast<L2::WawweOperation *>(i);
+        wawwe->lhs = convert_L2_item(wawwe->lhs);
+        wawwe->start = convert_L2_item(wawwe->lhs);
+        wawwe->mult = convert_L2_item(wawwe->mult);
+        break;
+      }
+      case L1::cjump_op: {
+        L2::CjumpOperation *cj = static_cast<L2::CjumpOperation *>(i);
+        cj->cexp.lhs = convert_L2_item(cj->cexp.lhs);
+        cj->cexp.rhs = convert_L2_item(cj->cexp.rhs);
+        break;
+      }
+      case L1::goto_op:
+        break;
     }
   }
 
@@ -528,7 +570,8 @@ pair<map<string, int>, vector<string>> Analysis::interference_analysis(
   // as colored to rcx.
 
   for (auto i : f->instructions) {
-    if (L2::ShiftOperation *sop = dynamic_cast<L2::ShiftOperation *>(i)) {
+    if (i->opcode == L1::shift_op) {
+      L2::ShiftOperation *sop = static_cast<L2::ShiftOperation *>(i);
       if (!(is_number(sop->rhs.name)))
       {
         int rcx_pos = (int) distance(x86_registers.begin(), find(x86_registers.begin(), x86_registers.end(), "rcx"));
@@ -14,8 +14,7 @@
 #include <fstream>
 #include <map>
 
-#include "parser.h"
-#include "interference.h"
+#include "liveness.h"
 
 using namespace std;
 
@@ -31,144 +30,6 @@ std::vector<std::string> arg_registers = {
   "rdi", "rsi", "rdx", "rcx", "r8", "r9"
 };
 
-void dump_program(L2::Program p) {
-  ofstream outputFile;
-  outputFile.open("prog.L1");
-  outputFile << "(" << p.entryPointLabel << endl;
-  for (auto f : p.functions) {
-    outputFile << "(" << f->name << "\n" << f->arguments << " " << f->locals << endl;
-    for (auto i : f->instructions) {
-      if (L2::Load *load = dynamic_cast<L2::Load *>(i)) {
-        outputFile << "(" << load->lhs.name << " <- (mem " << load->rhs.value.name << " " << load->rhs.offset_int << "))\n";
-      }
-      else if (L2::Store *store = dynamic_cast<L2::Store *>(i)) {
-        outputFile << "((mem " << store->lhs.value.name<< " " << store->lhs.offset_int << ") <- " << store->rhs.name << ")\n";
-      }
-      else if (L2::Assignment *assn = dynamic_cast<L2::Assignment *>(i)) {
-        outputFile << "(" << assn->lhs.name << " <- " << assn->rhs.name << ")\n";
-      }
-      else if (L2::ReturnCall *ret = dynamic_cast<L2::ReturnCall *>(i)) {
-        outputFile << "(return)\n";
-      }
-      else if (L2::ArithmeticOperation *aop = dynamic_cast<L2::ArithmeticOperation *>(i)) {
-        string aop_string;
-        switch(aop->op) {
-          case L2::plusequal:
-            aop_string = "+=";
-            break;
-          case L2::minusequal:
-            aop_string = "-=";
-            break;
-          case L2::andequal:
-            aop_string = "&=";
-            break;
-          case L2::timesequal:
-            aop_string = "*=";
-            break;
-        }
-        outputFile << "(" << aop->lhs.name << " " << aop_string << " " << aop->rhs.name << ")\n";
-      }
-      else if (L2::MemoryArithmeticOperation *maop = dynamic_cast<L2::MemoryArithmeticOperation *>(i)) {
-        string maop_string;
-        switch(maop->op) {
-          case L2::plusequal:
-            maop_string = "+=";
-            break;
-          case L2::minusequal:
-            maop_string = "-=";
-            break;
-          case L2::andequal:
-            maop_string = "&=";
-            break;
-          case L2::timesequal:
-            maop_string = "*=";
-            break;
-        }
-        outputFile << "((mem " << maop->lhs.value.name << " " << maop->lhs.offset_int << ") " <<  maop_string << " " << maop->rhs.name << ")\n";
-      }
-      else if (L2::MemoryArithmeticOperation2 *maop = dynamic_cast<L2::MemoryArithmeticOperation2 *>(i)) {
-        string maop_string;
-        switch(maop->op) {
-          case L2::plusequal:
-            maop_string = "+=";
-            break;
-          case L2::minusequal:
-            maop_string = "-=";
-            break;
-          case L2::andequal:
-            maop_string = "&=";
-            break;
-          case L2::timesequal:
-            maop_string = "*=";
-            break;
-        }
-        outputFile << "(" << maop->lhs.name << " " << maop_string << " (mem " << maop->rhs.value.name << " " << maop->rhs.offset_int << "))\n";
-      }
-      else if (L2::ShiftOperation *sop = dynamic_cast<L2::ShiftOperation *>(i)) {
-        string sop_string;
-        switch(sop->op) {
-          case L2::lshift:
-            sop_string = "<<=";
-            break;
-          case L2::rshift:
-            sop_string = ">>=";
-            break;
-        }
-        outputFile << "(" << sop->lhs.name << " " << sop_string << " " << sop->rhs.name << ")\n";
-      }
-      else if (L2::ComparisonOperation *comp = dynamic_cast<L2::ComparisonOperation *>(i)) {
-        string cexp_op_string;
-        switch(comp->cexp.op) {
-          case L2::lessthan:
-            cexp_op_string = "<";
-            break;
-          case L2::lessthanorequal:
-            cexp_op_string = "<=";
-            break;
-          case L2::equal:
-            cexp_op_string = "=";
-            break;
-        }
-        outputFile << "(" << comp->lhs.name << " <- " << comp->cexp.lhs.name << " " << cexp_op_string << " " << comp->cexp.rhs.name << ")\n";
-      }
-      else if (L2::RuntimeCall *rCall = dynamic_cast<L2::RuntimeCall *>(i)) {
-        outputFile << "(call " << rCall->function_name.name << " " << rCall->n_args << ")\n";
-      }
-      else if (L2::FunctionCall *fCall = dynamic_cast<L2::FunctionCall *>(i)) {
-        outputFile << "(call " << fCall->function_name.name << " " << fCall->n_args << ")\n";
-      }
-      else if (L2::Label *lbl = dynamic_cast<L2::Label *>(i)) {
-        outputFile << lbl->name << endl;
-      }
-      else if (L2::WawweOperation *wawwe = dynamic_cast<L2::WawweOperation *>(i)) {
-        outputFile << "(" << wawwe->lhs.name << " @ " << wawwe->start.name << " " << wawwe->mult.name << " " << wawwe->e << ")\n";
-      }
-      else if (L2::CjumpOperation *cj = dynamic_cast<L2::CjumpOperation *>(i)) {
-        string cexp_op_string;
-        switch(cj->cexp.op) {
-          case L2::lessthan:
-            cexp_op_string = "<";
-            break;
-          case L2::lessthanorequal:
-            cexp_op_string = "<=";
-            break;
-          case L2::equal:
-            cexp_op_string = "=";
-            break;
-        }
-        outputFile << "(cjump " << cj->cexp.lhs.name << " " << cexp_op_string << " " << cj->cexp.rhs.name << " " << cj->then_label << " " << cj->else_label << ")\n";
-      }
-      else if (L2::GotoOperation *gt = dynamic_cast<L2::GotoOperation *>(i)) {
-        outputFile << "(goto " << gt->lbl.name << ")\n";
-      }
-
-    }
-    outputFile << ")\n";
-  }
-  outputFile << ")\n";
-  outputFile.close();
-}
-
 template <typename T>
 std::set<T> custom_set_union(const std::set<T>& a, const std::set<T>& b)
 {
@@ -252,117 +113,146 @@ L2::Liveness liveness_analysis(L2::Function *f) {
     GEN.push_back(std::set<std::string>());
     KILL.push_back(std::set<std::string>());
     successors.push_back({});
-    if (L2::Load *load = dynamic_cast<L2::Load *>(i)) {
-      KILL.back().insert(load->lhs.name);
-      if (load->rhs.value.name != "rsp")
-        GEN.back().insert(load->rhs.value.name);
-    }
-    else if (L2::Store *store = dynamic_cast<L2::Store *>(i)) {
-      if (store->rhs.r || store->rhs.name[0] == '_')
-        GEN.back().insert(store->rhs.name);
-      if (store->lhs.value.name != "rsp")
-        GEN.back().insert(store->lhs.value.name);
-    }
-    else if (L2::Assignment *assn = dynamic_cast<L2::Assignment *>(i)) {
-      if (assn->rhs.r)
-        GEN.back().insert(assn->rhs.name);
-      KILL.back().insert(assn->lhs.name);
-    }
-    else if (L2::ReturnCall *ret = dynamic_cast<L2::ReturnCall *>(i)) {
-      GEN.back().insert("rax");
-      for (auto r : callee_save_registers) {
-        GEN.back().insert(r);
+    switch (i->opcode) {
+      case L1::load_op: {
+        L2::Load *load = static_cast<L2::Load *>(i);
+        KILL.back().insert(load->lhs.name);
+        if (load->rhs.value.name != "rsp")
+          GEN.back().insert(load->rhs.value.name);
+        break;
       }
-    }
-    else if (L2::ArithmeticOperation *aop = dynamic_cast<L2::ArithmeticOperation *>(i)) {
-      if (aop->rhs.r) {
-        GEN.back().insert(aop->rhs.name);
+      case L1::store_op: {
+        L2::Store *store = static_cast<L2::Store *>(i);
+        if (store->rhs.r || store->rhs.name[0] == '_')
+          GEN.back().insert(store->rhs.name);
+        if (store->lhs.value.name != "rsp")
+          GEN.back().insert(store->lhs.value.name);
+        break;
       }
-      GEN.back().insert(aop->lhs.name);
-      KILL.back().insert(aop->lhs.name);
-    }
-    else if (L2::MemoryArithmeticOperation *maop = dynamic_cast<L2::MemoryArithmeticOperation *>(i)) {
-      if (maop->lhs.value.r)
-        GEN.back().insert(maop->lhs.value.name);
-      if (maop->rhs.r)
-        GEN.back().insert(maop->rhs.name);
-    }
-    else if (L2::MemoryArithmeticOperation2 *maop = dynamic_cast<L2::MemoryArithmeticOperation2 *>(i)) {
-      if (maop->lhs.r)
-        GEN.back().insert(maop->lhs.name);
-      if (maop->rhs.value.r)
-        GEN.back().insert(maop->rhs.value.name);
-    }
-    else if (L2::ShiftOperation *sop = dynamic_cast<L2::ShiftOperation *>(i)) {
-      if (sop->lhs.r)
-        KILL.back().insert(sop->lhs.name);
-      if (sop->rhs.r)
-        GEN.back().insert(sop->rhs.name);
-    }
-    else if (L2::ComparisonOperation *comp = dynamic_cast<L2::ComparisonOperation *>(i)) {
-      KILL.back().insert(comp->lhs.name);
-      if (comp->cexp.lhs.r)
-        GEN.back().insert(comp->cexp.lhs.name);
-      if (comp->cexp.rhs.r)
-        GEN.back().insert(comp->cexp.rhs.name);
-    }
-    else if (L2::RuntimeCall *rCall = dynamic_cast<L2::RuntimeCall *>(i)) {
-      KILL.back().insert("rax");
-      for (auto c_r : caller_save_registers) {
-        KILL.back().insert(c_r);
+      case L1::assignment_op: {
+        L2::Assignment *assn = static_cast<L2::Assignment *>(i);
+        if (assn->rhs.r)
+          GEN.back().insert(assn->rhs.name);
+        KILL.back().insert(assn->lhs.name);
+        break;
       }
-      for (auto arg : arg_registers) {
-        GEN.back().insert(arg);
+      case L1::return_op: {
+        GEN.back().insert("rax");
+        for (auto r : callee_save_registers) {
+          GEN.back().insert(r);
+        }
+        break;
       }
-    }
-    else if (L2::FunctionCall *fCall = dynamic_cast<L2::FunctionCall *>(i)) {
-      KILL.back().insert("rax");
-      for (auto c_r : caller_save_registers) {
-        KILL.back().insert(c_r);
+      case L1::arithmetic_op: {
+        L2::ArithmeticOperation *aop = static_cast<L2::ArithmeticOperation *>(i);
+        if (aop->rhs.r) {
+          GEN.back().insert(aop->rhs.name);
+        }
+        GEN.back().insert(aop->lhs.name);
+        KILL.back().insert(aop->lhs.name);
+        break;
       }
-      // if it's a non-label function call, it's var or register
-      if (!(fCall->function_name.name[0] == ':' ||
-            fCall->function_name.name == "print" ||
-            fCall->function_name.name == "allocate" ||
-            fCall->function_name.name == "array-error"))
-      {
-        GEN.back().insert(fCall->function_name.name);
+      case L1::memory_arithmetic_op: {
+        L2::MemoryArithmeticOperation *maop = static_cast<L2::MemoryArithmeticOperation *>(i);
+        if (maop->lhs.value.r)
+          GEN.back().insert(maop->lhs.value.name);
+        if (maop->rhs.r)
+          GEN.back().insert(maop->rhs.name);
+        break;
       }
-      std::vector<std::string> relevant_arg_registers;
-      relevant_arg_registers = std::vector<std::string>(arg_registers.begin(), arg_registers.begin() + std::min((int)fCall->n_args, 6));
-      for (auto arg : relevant_arg_registers) {
-        GEN.back().insert(arg);
+      case L1::memory_arithmetic2_op: {
+        L2::MemoryArithmeticOperation2 *maop = static_cast<L2::MemoryArithmeticOperation2 *>(i);
+        if (maop->lhs.r)
+          GEN.back().insert(maop->lhs.name);
+        if (maop->rhs.value.r)
+          GEN.back().insert(maop->rhs.value.name);
+        break;
       }
-    }
-    else if (L2::Label *lbl = dynamic_cast<L2::Label *>(i)) {
-
-    }
-    else if (L2::WawweOperation *wawwe = dynamic_cast<L2::WawweOperation *>(i)) {
-      KILL.back().insert(wawwe->lhs.name);
-      GEN.back().insert(wawwe->start.name);
-      GEN.back().insert(wawwe->mult.name);
-    }
-    else if (L2::CjumpOperation *cj = dynamic_cast<L2::CjumpOperation *>(i)) {
-      // look for the successors
-      for (int j = int_i; j != f->instructions.size(); j++) {
-        if (L2::Label *lbl = dynamic_cast<L2::Label *>(f->instructions[j])) {
-          if (lbl->name == cj->else_label || lbl->name == cj->then_label) {
-            successors.back().push_back(j);
+      case L1::shift_op: {
+        L2::ShiftOperation *sop = static_cast<L2::ShiftOperation *>(i);
+        if (sop->lhs.r)
+          KILL.back().insert(sop->lhs.name);
+        if (sop->rhs.r)
+          GEN.back().insert(sop->rhs.name);
+        break;
+      }
+      case L1::comparison_op: {
+        L2::ComparisonOperation *comp = static_cast<L2::ComparisonOperation *>(i);
+        KILL.back().insert(comp->lhs.name);
+        if (comp->cexp.lhs.r)
+          GEN.back().insert(comp->cexp.lhs.name);
+        if (comp->cexp.rhs.r)
+          GEN.back().insert(comp->cexp.rhs.name);
+        break;
+      }
+      case L1::runtime_call_op: {
+        KILL.back().insert("rax");
+        for (auto c_r : caller_save_registers) {
+          KILL.back().insert(c_r);
+        }
+        for (auto arg : arg_registers) {
+          GEN.back().insert(arg);
+        }
+        break;
+      }
+      case L1::function_call_op: {
+        L2::FunctionCall *fCall = static_cast<L2::FunctionCall *>(i);
+        KILL.back().insert("rax");
+        for (auto c_r : caller_save_registers) {
+          KILL.back().insert(c_r);
+        }
+        // if it's a non-label function call, it's var or register
+        if (!(fCall->function_name.name[0] == ':' ||
+              fCall->function_name.name == "print" ||
+              fCall->function_name.name == "allocate" ||
+              fCall->function_name.name == "array-error"))
+        {
+          GEN.back().insert(fCall->function_name.name);
+        }
+        std::vector<std::string> relevant_arg_registers;
+        relevant_arg_registers = std::vector<std::string>(arg_registers.begin(), arg_registers.begin() + std::min((int)fCall->n_args, 6));
+        for (auto arg : relevant_arg_registers) {
+          GEN.back().insert(arg);
+        }
+        break;
+      }
+      case L1::label_op:
+        break;
+      case L1::wawwe_op: {
+        L2::WawweOperation *wawwe = static_cast<L2::WawweOperation *>(i);
+        KILL.back().insert(wawwe->lhs.name);
+        GEN.back().insert(wawwe->start.name);
+        GEN.back().insert(wawwe->mult.name);
+        break;
+      }
+      case L1::cjump_op: {
+        L2::CjumpOperation *cj = static_cast<L2::CjumpOperation *>(i);
+        // look for the successors
+        for (int j = int_i; j != f->instructions.size(); j++) {
+          if (f->instructions[j]->opcode == L1::label_op) {
+            L2::Label *lbl = static_cast<L2::Label *>(f->instructions[j]);
+            if (lbl->name == cj->else_label || lbl->name == cj->then_label) {
+              successors.back().push_back(j);
+            }
           }
         }
+        if (cj->cexp.lhs.r)
+          GEN.back().insert(cj->cexp.lhs.name);
+        if (cj->cexp.rhs.r)
+          GEN.back().insert(cj->cexp.rhs.name);
+        break;
       }
-      if (cj->cexp.lhs.r)
-        GEN.back().insert(cj->cexp.lhs.name);
-      if (cj->cexp.rhs.r)
-        GEN.back().insert(cj->cexp.rhs.name);
-    }
-    else if (L2::GotoOperation *gt = dynamic_cast<L2::GotoOperation *>(i)) {
-      for (int j = int_i; j != f->instructions.size(); ++j) {
-        if (L2::Label *lbl = dynamic_cast<L2::Label *>(f->instructions[j])) {
-          if (lbl->name == gt->lbl.name) {
-            successors.back().push_back(j);
+      case L1::goto_op: {
+        L2::GotoOperation *gt = static_cast<L2::GotoOperation *>(i);
+        for (int j = int_i; j != f->instructions.size(); ++j) {
+          if (f->instructions[j]->opcode == L1::label_op) {
+            L2::Label *lbl = static_cast<L2::Label *>(f->instructions[j]);
+            if (lbl->name == gt->lbl.name) {
+              successors.back().push_back(j);
+            }
           }
         }
+        break;
       }
     }
     if (!successors.back().size())
@@ -380,63 +270,3 @@ L2::Liveness liveness_analysis(L2::Function *f) {
 
   return liveness;
 }
-
-int main(
-  int argc,
-  char **argv
-  ){
-  bool verbose;
-
-  /* Check the input.
-   */
-  if( argc < 2 ) {
-    std::cerr << "Usage: " << argv[ 0 ] << " SOURCE [-v]" << std::endl;
-    return 1;
-  }
-  int32_t opt;
-  while ((opt = getopt(argc, argv, "v")) != -1) {
-    switch (opt){
-      case 'v':
-        verbose = true;
-        break ;
-
-      default:
-        std::cerr << "Usage: " << argv[ 0 ] << "[-v] SOURCE" << std::endl;
-        return 1;
-    }
-  }
-
-  /* Parse the L2 program.
-   */
-  L2::Program p = L2::L2_parse_file(argv[optind]);
-
-  /* Generate GEN/KILL first
-   */
-  L2::Program *newP = new L2::Program();
-  newP->entryPointLabel = p.entryPointLabel;
-  int int_i;
-  for (auto f : p.functions) {
-    bool spilled = false;
-    bool needs_spilled = false;
-    int n_spilled = 0;
-    int doof;
-    pair<map<string, int>, vector<string>> analysis;
-    do {
-      spilled = false;
-      L2::Liveness liveness = liveness_analysis(f);
-      analysis = Analysis::interference_analysis(liveness.IN, liveness.OUT, liveness.KILL, f);
-      needs_spilled = analysis.second.size() > 0;
-      if (needs_spilled) {
-        for (auto v : analysis.second) {
-          spilled = true;
-          f = Analysis::spill(f, v, f->locals+1);
-        }
-      }
-    } while (spilled == true);
-    f = Analysis::translate_to_L1(f, analysis.second);
-    newP->functions.push_back(f);
-  }
-
-  dump_program(*newP);
-  return 0;
-}
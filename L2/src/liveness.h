@@ -0,0 +1,5 @@
+#pragma once
+
+#include "L2.h"
+
+L2::Liveness liveness_analysis(L2::Function *f);
@@ -0,0 +1,52 @@
+#include <iostream>
+#include <cstdlib>
+#include <stdint.h>
+#include <unistd.h>
+#include <chrono>
+
+#include "parser.h"
+#include "compiler.h"
+#include "emitter.h"
+
+using namespace std;
+
+int main(
+  int argc,
+  char **argv
+  ){
+  bool verbose = false;
+
+  /* Check the input.
+   */
+  if( argc < 2 ) {
+    std::cerr << "Usage: " << argv[ 0 ] << " SOURCE [-v]" << std::endl;
+    return 1;
+  }
+  int32_t opt;
+  while ((opt = getopt(argc, argv, "v")) != -1) {
+    switch (opt){
+      case 'v':
+        verbose = true;
+        break ;
+
+      default:
+        std::cerr << "Usage: " << argv[ 0 ] << "[-v] SOURCE" << std::endl;
+        return 1;
+    }
+  }
+
+  /* Parse the L2 program.
+   */
+  auto start = chrono::steady_clock::now();
+  L2::Program p = L2::L2_parse_file(argv[optind]);
+  auto parsed = chrono::steady_clock::now();
+  if (verbose) {
+    cerr << "parse: " << chrono::duration_cast<chrono::milliseconds>(parsed - start).count() << " ms\n";
+  }
+
+  L1::Program compiled = compile_L2(p, verbose);
+  Emitter outputFile("prog.L1");
+  dump_program(compiled, outputFile);
+  outputFile.close();
+  return 0;
+}
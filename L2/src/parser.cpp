@@ -622,36 +622,56 @@ namespace L2 {
     > {};
 
   /*
-   * Data structures required to parse
+   * What a parse has read but not yet put into the program. Every
+   * parse gets its own, passed to the actions, so several parses
+   * can run at once.
    */
-  std::vector<L2_item> parsed_registers;
-  std::vector<L2_w> parsed_w_vals;
-  std::vector<int64_t> parsed_e_vals;
-  std::vector<L2_a> parsed_a_vals;
-  std::vector<L2_s> parsed_s_vals;
-  std::vector<L2_t> parsed_t_vals;
-  std::vector<L2_x> parsed_x_vals;
-  std::vector<L2_m> parsed_m_vals;
-  std::vector<L2_u> parsed_u_vals;
-  std::vector<std::string> variables;
-  std::vector<int64_t> parsed_n_vals;
-  std::vector<MemoryReference> parsed_mem_refs;
-  L2::ArithmeticOperator current_aop;
-  L2::ShiftOperator current_sop;
-  L2_w load_lhs;
-  L2_w arithmetic_lhs;
-  L2_t arithmetic_rhs;
-  L2_w assignment_lhs;
-  L2_s assignment_rhs;
-  L2_item shift_rhs;
-  L2_w cmp_lhs;
-  L2_t current_cexp_lhs;
-  L2_t current_cexp_rhs;
-  L2::ComparisonOperator current_cop;
-  L2::ComparisonExpression current_cexp;
-  std::string cjump_then;
-  std::string cjump_else;
-  bool parsed_register = true;
+  struct ParseState {
+    std::vector<L2_item> parsed_registers;
+    std::vector<L2_w> parsed_w_vals;
+    std::vector<int64_t> parsed_e_vals;
+    std::vector<L2_a> parsed_a_vals;
+    std::vector<L2_s> parsed_s_vals;
+    std::vector<L2_t> parsed_t_vals;
+    std::vector<L2_x> parsed_x_vals;
+    std::vector<L2_m> parsed_m_vals;
+    std::vector<L2_u> parsed_u_vals;
+    std::vector<std::string> variables;
+    std::vector<int64_t> parsed_n_vals;
+    std::vector<MemoryReference> parsed_mem_refs;
+    L2::ArithmeticOperator current_aop;
+    L2::ShiftOperator current_sop;
+    L2_w load_lhs;
+    L2_w arithmetic_lhs;
+    L2_t arithmetic_rhs;
+    L2_w assignment_lhs;
+    L2_s assignment_rhs;
+    L2_item shift_rhs;
+    L2_w cmp_lhs;
+    L2_t current_cexp_lhs;
+    L2_t current_cexp_rhs;
+    L2::ComparisonOperator current_cop;
+    L2::ComparisonExpression current_cexp;
+    std::string cjump_then;
+    std::string cjump_else;
+    bool parsed_register = true;
+
+    // the tokens of an instruction are no use once it is built
+    void clear_memory() {
+      parsed_registers.clear();
+      parsed_w_vals.clear();
+      parsed_e_vals.clear();
+      parsed_a_vals.clear();
+      parsed_s_vals.clear();
+      parsed_t_vals.clear();
+      parsed_x_vals.clear();
+      parsed_m_vals.clear();
+      parsed_u_vals.clear();
+      variables.clear();
+      parsed_n_vals.clear();
+      parsed_mem_refs.clear();
+    }
+  };
 
   /*
    * Actions attached to grammar rules.
@@ -660,18 +680,18 @@ namespace L2 {
   struct action : pegtl::nothing< Rule > {};
 
   template<> struct action < label > {
-    static void apply( const pegtl::input & in, L2::Program & p){
+    static void apply( const pegtl::input & in, L2::Program & p, ParseState & state){
     }
   };
 
   template<> struct action < L2_e_rule > {
-    static void apply( const pegtl::input & in, L2::Program & p){
-      parsed_e_vals.push_back(std::stoi(in.string()));
+    static void apply( const pegtl::input & in, L2::Program & p, ParseState & state){
+      state.parsed_e_vals.push_back(std::stoi(in.string()));
     }
   };
 
   template<> struct action < function_name > {
-    static void apply( const pegtl::input & in, L2::Program & p){
+    static void apply( const pegtl::input & in, L2::Program & p, ParseState & state){
       L2::Function *newF = new L2::Function();
       newF->name = in.string();
       p.functions.push_back(newF);
@@ -679,39 +699,39 @@ namespace L2 {
   };
 
   template<> struct action < L2_wawwe_rule > {
-    static void apply( const pegtl::input & in, L2::Program & p){
+    static void apply( const pegtl::input & in, L2::Program & p, ParseState & state){
       L2::WawweOperation *wawwe = new L2::WawweOperation();
-      wawwe->lhs = parsed_w_vals[parsed_w_vals.size() - 3];
-      wawwe->start = parsed_w_vals[parsed_w_vals.size() - 2];
-      wawwe->mult = parsed_w_vals[parsed_w_vals.size() - 1];
-      wawwe->e = parsed_e_vals.back();
+      wawwe->lhs = state.parsed_w_vals[state.parsed_w_vals.size() - 3];
+      wawwe->start = state.parsed_w_vals[state.parsed_w_vals.size() - 2];
+      wawwe->mult = state.parsed_w_vals[state.parsed_w_vals.size() - 1];
+      wawwe->e = state.parsed_e_vals.back();
       p.functions.back()->instructions.push_back(wawwe);
     }
   };
 
   template<> struct action < L2_stackarg_rule > {
-    static void apply( const pegtl::input & in, L2::Program & p){
+    static void apply( const pegtl::input & in, L2::Program & p, ParseState & state){
       // treat stackarg like a load but with some strings attached
       L2::Load *load = new L2::Load();
       L2::L2_x rhs;
-      load->lhs = load_lhs;
+      load->lhs = state.load_lhs;
       load->rhs.value.name = "rsp";
-      load->rhs.offset_int = p.functions.back()->locals * 8 + std::stoi(parsed_m_vals.back().name);
+      load->rhs.offset_int = p.functions.back()->locals * 8 + std::stoi(state.parsed_m_vals.back().name);
       p.functions.back()->instructions.push_back(load);
     }
   };
 
   template<> struct action < L2_string_rule > {
-    static void apply( const pegtl::input & in, L2::Program & p){
+    static void apply( const pegtl::input & in, L2::Program & p, ParseState & state){
       L2_item i;
       i.name = in.string();
-      parsed_register = false;
-      parsed_registers.push_back(i);
+      state.parsed_register = false;
+      state.parsed_registers.push_back(i);
     }
   };
 
   template<> struct action < L2_variable_rule > {
-    static void apply( const pegtl::input & in, L2::Program &p ){
+    static void apply( const pegtl::input & in, L2::Program &p, ParseState &state){
       if (p.functions.size() > 0 &&
           in.string() != "print" &&
           in.string() != "array-error" &&
@@ -723,97 +743,97 @@ namespace L2 {
   };
 
   template<> struct action < L2_label_rule > {
-    static void apply( const pegtl::input & in, L2::Program & p){
+    static void apply( const pegtl::input & in, L2::Program & p, ParseState & state){
       if (p.entryPointLabel.empty()){
         p.entryPointLabel = in.string();
       }
       L2_item i;
-      parsed_register = false;
+      state.parsed_register = false;
       i.name = in.string();
-      parsed_registers.push_back(i);
+      state.parsed_registers.push_back(i);
     }
   };
 
   template<> struct action < number > {
-    static void apply( const pegtl::input & in, L2::Program & p){
-      parsed_register = false;
+    static void apply( const pegtl::input & in, L2::Program & p, ParseState & state){
+      state.parsed_register = false;
     }
   };
 
   template<> struct action < argument_number > {
-    static void apply( const pegtl::input & in, L2::Program & p){
+    static void apply( const pegtl::input & in, L2::Program & p, ParseState & state){
       p.functions.back()->arguments = std::stoll(in.string());
     }
   };
 
   template<> struct action < local_number > {
-    static void apply( const pegtl::input & in, L2::Program & p){
+    static void apply( const pegtl::input & in, L2::Program & p, ParseState & state){
       p.functions.back()->locals = std::stoll(in.string());
     }
   };
 
   template<> struct action < functioncall_argument_number > {
-    static void apply( const pegtl::input & in, L2::Program & p){
-      parsed_n_vals.push_back(std::stoll(in.string()));
+    static void apply( const pegtl::input & in, L2::Program & p, ParseState & state){
+      state.parsed_n_vals.push_back(std::stoll(in.string()));
     }
   };
 
   template<> struct action < L2_w_rule > {
-    static void apply( const pegtl::input & in, L2::Program & p){
+    static void apply( const pegtl::input & in, L2::Program & p, ParseState & state){
       L2::L2_w newW;
       newW.name = in.string();
       newW.r = true;
-      parsed_register = true;
-      parsed_w_vals.push_back(newW);
+      state.parsed_register = true;
+      state.parsed_w_vals.push_back(newW);
     }
   };
 
   template<> struct action < L2_s_rule > {
-    static void apply( const pegtl::input & in, L2::Program & p){
+    static void apply( const pegtl::input & in, L2::Program & p, ParseState & state){
       L2::L2_s newS;
-      newS.r = parsed_register;
+      newS.r = state.parsed_register;
       newS.name = in.string();
-      parsed_s_vals.push_back(newS);
+      state.parsed_s_vals.push_back(newS);
     }
   };
 
   template<> struct action < L2_t_rule > {
-    static void apply( const pegtl::input & in, L2::Program & p){
+    static void apply( const pegtl::input & in, L2::Program & p, ParseState & state){
       L2::L2_t newT;
-      newT.r = parsed_register;
+      newT.r = state.parsed_register;
       newT.name = in.string();
-      parsed_t_vals.push_back(newT);
+      state.parsed_t_vals.push_back(newT);
     }
   };
 
   template<> struct action < L2_x_rule > {
-    static void apply( const pegtl::input & in, L2::Program & p){
+    static void apply( const pegtl::input & in, L2::Program & p, ParseState & state){
       L2::L2_x newX;
       newX.name = in.string();
       newX.r = true;
-      parsed_register = true;
-      parsed_x_vals.push_back(newX);
+      state.parsed_register = true;
+      state.parsed_x_vals.push_back(newX);
     }
   };
 
   template<> struct action < L2_m_rule > {
-    static void apply( const pegtl::input & in, L2::Program & p){
+    static void apply( const pegtl::input & in, L2::Program & p, ParseState & state){
       L2::L2_m newM;
       newM.name = in.string();
-      parsed_m_vals.push_back(newM);
+      state.parsed_m_vals.push_back(newM);
     }
   };
 
   template<> struct action < L2_u_rule > {
-    static void apply( const pegtl::input & in, L2::Program & p){
+    static void apply( const pegtl::input & in, L2::Program & p, ParseState & state){
       L2::L2_u newU;
       newU.name = in.string();
-      parsed_u_vals.push_back(newU);
+      state.parsed_u_vals.push_back(newU);
     }
   };
 
   template<> struct action < L2_label_instruction_rule > {
-    static void apply( const pegtl::input & in, L2::Program & p){
+    static void apply( const pegtl::input & in, L2::Program & p, ParseState & state){
       L2::Label *lbl = new L2::Label();
       lbl->name = in.string();
       p.functions.back()->instructions.push_back(lbl);
@@ -821,154 +841,156 @@ namespace L2 {
   };
 
   template<> struct action < L2_memref_rule > {
-    static void apply( const pegtl::input & in, L2::Program & p){
+    static void apply( const pegtl::input & in, L2::Program & p, ParseState & state){
       L2::MemoryReference memRef;
-      L2::L2_x x = parsed_x_vals.back();
-      L2::L2_m m = parsed_m_vals.back();
+      L2::L2_x x = state.parsed_x_vals.back();
+      L2::L2_m m = state.parsed_m_vals.back();
       memRef.value = x;
       memRef.offset = m;
       memRef.offset_int = std::stoll(m.name);
-      parsed_mem_refs.push_back(memRef);
+      state.parsed_mem_refs.push_back(memRef);
     }
   };
 
   template<> struct action < L2_goto_rule > {
-    static void apply( const pegtl::input & in, L2::Program & p){
+    static void apply( const pegtl::input & in, L2::Program & p, ParseState & state){
       L2::GotoOperation *goto_op = new L2::GotoOperation();
-      goto_op->lbl = parsed_registers.back();
+      goto_op->lbl = state.parsed_registers.back();
       p.functions.back()->instructions.push_back(goto_op);
     }
   };
 
   template<> struct action < L2_cjump_then_label_rule > {
-    static void apply( const pegtl::input & in, L2::Program & p){
-      cjump_then = in.string();
+    static void apply( const pegtl::input & in, L2::Program & p, ParseState & state){
+      // the rule's input includes the separators after the label
+      state.cjump_then = state.parsed_registers.back().name;
     }
   };
 
   template<> struct action < L2_cjump_else_label_rule > {
-    static void apply( const pegtl::input & in, L2::Program & p){
-      cjump_else = in.string();
+    static void apply( const pegtl::input & in, L2::Program & p, ParseState & state){
+      // the rule's input includes the separators after the label
+      state.cjump_else = state.parsed_registers.back().name;
     }
   };
 
   template<> struct action < L2_cjump_rule > {
-    static void apply( const pegtl::input & in, L2::Program & p){
+    static void apply( const pegtl::input & in, L2::Program & p, ParseState & state){
       L2::CjumpOperation *cjump = new L2::CjumpOperation();
-      cjump->cexp = current_cexp;
-      cjump->then_label = cjump_then;
-      cjump->else_label = cjump_else;
+      cjump->cexp = state.current_cexp;
+      cjump->then_label = state.cjump_then;
+      cjump->else_label = state.cjump_else;
       p.functions.back()->instructions.push_back(cjump);
     }
   };
 
   template<> struct action < L2_cmp_lhs_rule > {
-    static void apply( const pegtl::input & in, L2::Program & p){
-      cmp_lhs.name = in.string();
-      cmp_lhs.r = parsed_register;
+    static void apply( const pegtl::input & in, L2::Program & p, ParseState & state){
+      state.cmp_lhs.name = in.string();
+      state.cmp_lhs.r = state.parsed_register;
     }
   };
 
   template<> struct action < L2_cexp_lhs_rule > {
-    static void apply( const pegtl::input & in, L2::Program & p){
-      current_cexp_lhs.name = in.string();
-      current_cexp_lhs.r = parsed_register;
+    static void apply( const pegtl::input & in, L2::Program & p, ParseState & state){
+      state.current_cexp_lhs.name = in.string();
+      state.current_cexp_lhs.r = state.parsed_register;
     }
   };
 
   template<> struct action < L2_cexp_rhs_rule > {
-    static void apply( const pegtl::input & in, L2::Program & p){
-      current_cexp_rhs.name = in.string();
-      current_cexp_rhs.r = parsed_register;
+    static void apply( const pegtl::input & in, L2::Program & p, ParseState & state){
+      state.current_cexp_rhs.name = in.string();
+      state.current_cexp_rhs.r = state.parsed_register;
     }
   };
 
   template<> struct action < L2_cop_rule > {
-    static void apply( const pegtl::input & in, L2::Program & p){
+    static void apply( const pegtl::input & in, L2::Program & p, ParseState & state){
       std::string op_string = in.string();
       std::string lt ("<");
       std::string lte ("<=");
       std::string eq ("=");
       if (op_string.compare(lt) == 0) {
-        current_cop = lessthan;
+        state.current_cop = lessthan;
       }
       else if (op_string.compare(lte) == 0) {
-        current_cop = lessthanorequal;
+        state.current_cop = lessthanorequal;
       }
       else if (op_string.compare(eq) == 0) {
-        current_cop = equal;
+        state.current_cop = equal;
       }
     }
   };
 
   template<> struct action < L2_cmp_rule > {
-    static void apply( const pegtl::input & in, L2::Program & p){
-      current_cexp.lhs = current_cexp_lhs;
-      current_cexp.rhs = current_cexp_rhs;
-      current_cexp.op = current_cop;
+    static void apply( const pegtl::input & in, L2::Program & p, ParseState & state){
+      state.current_cexp.lhs = state.current_cexp_lhs;
+      state.current_cexp.rhs = state.current_cexp_rhs;
+      state.current_cexp.op = state.current_cop;
     }
   };
 
   template<> struct action < L2_cmp_instruction_rule > {
-    static void apply( const pegtl::input & in, L2::Program & p){
+    static void apply( const pegtl::input & in, L2::Program & p, ParseState & state){
       L2::ComparisonOperation *cop = new L2::ComparisonOperation();
-      cop->lhs = cmp_lhs;
-      cop->cexp = current_cexp;
+      cop->lhs = state.cmp_lhs;
+      cop->cexp = state.current_cexp;
       p.functions.back()->instructions.push_back(cop);
     }
   };
 
   template<> struct action < L2_shift_rhs_rule > {
-    static void apply( const pegtl::input & in, L2::Program & p){
-      shift_rhs.name = in.string();
-      if (shift_rhs.name == "rcx") {
-        shift_rhs.name = "%cl";
+    static void apply( const pegtl::input & in, L2::Program & p, ParseState & state){
+      state.shift_rhs.name = in.string();
+      if (state.shift_rhs.name == "rcx") {
+        state.shift_rhs.name = "%cl";
       }
     }
   };
 
   template<> struct action < L2_sop_rule > {
-    static void apply( const pegtl::input & in, L2::Program & p){
+    static void apply( const pegtl::input & in, L2::Program & p, ParseState & state){
       std::string op_string = in.string();
       std::string ls ("<<=");
       std::string rs (">>=");
       if (op_string.compare(ls) == 0) {
-        current_sop = lshift;
+        state.current_sop = lshift;
       }
       else if (op_string.compare(rs) == 0) {
-        current_sop = rshift;
+        state.current_sop = rshift;
       }
     }
   };
 
   template<> struct action < L2_shift_rule > {
-    static void apply( const pegtl::input & in, L2::Program & p){
+    static void apply( const pegtl::input & in, L2::Program & p, ParseState & state){
       L2::ShiftOperation *sop = new L2::ShiftOperation();
-      sop->op = current_sop;
-      sop->lhs = parsed_w_vals.back();
-      sop->rhs = shift_rhs;
+      sop->op = state.current_sop;
+      sop->lhs = state.parsed_w_vals.back();
+      sop->rhs = state.shift_rhs;
       p.functions.back()->instructions.push_back(sop);
     }
   };
 
   template<> struct action < L2_aop_rule > {
-    static void apply( const pegtl::input & in, L2::Program & p){
+    static void apply( const pegtl::input & in, L2::Program & p, ParseState & state){
       std::string op_string = in.string();
       std::string peq ("+=");
       std::string meq ("-=");
       std::string teq ("*=");
       std::string aeq ("&=");
       if (op_string.compare(peq) == 0) {
-        current_aop = plusequal;
+        state.current_aop = plusequal;
       }
       else if (op_string.compare(meq) == 0) {
-        current_aop = minusequal;
+        state.current_aop = minusequal;
       }
       else if (op_string.compare(teq) == 0) {
-        current_aop = timesequal;
+        state.current_aop = timesequal;
       }
       else if (op_string.compare(aeq) == 0) {
-        current_aop = andequal;
+        state.current_aop = andequal;
       }
       else {
         cerr << "error" << endl;
@@ -977,165 +999,184 @@ namespace L2 {
   };
 
   template<> struct action < L2_arithmetic_lhs_rule > {
-    static void apply( const pegtl::input & in, L2::Program & p){
-      arithmetic_lhs = parsed_w_vals.back();
+    static void apply( const pegtl::input & in, L2::Program & p, ParseState & state){
+      state.arithmetic_lhs = state.parsed_w_vals.back();
     }
   };
 
   template<> struct action < L2_arithmetic_rhs_rule > {
-    static void apply( const pegtl::input & in, L2::Program & p){
-      arithmetic_rhs = parsed_t_vals.back();
+    static void apply( const pegtl::input & in, L2::Program & p, ParseState & state){
+      state.arithmetic_rhs = state.parsed_t_vals.back();
     }
   };
 
   template<> struct action < L2_arithmetic_rule > {
-    static void apply( const pegtl::input & in, L2::Program & p){
+    static void apply( const pegtl::input & in, L2::Program & p, ParseState & state){
       L2::ArithmeticOperation *aop = new L2::ArithmeticOperation();
-      aop->op = current_aop;
-      aop->lhs = arithmetic_lhs;
-      aop->rhs = arithmetic_rhs;
+      aop->op = state.current_aop;
+      aop->lhs = state.arithmetic_lhs;
+      aop->rhs = state.arithmetic_rhs;
       p.functions.back()->instructions.push_back(aop);
     }
   };
 
   template<> struct action < L2_inc_rule > {
-    static void apply( const pegtl::input & in, L2::Program & p){
+    static void apply( const pegtl::input & in, L2::Program & p, ParseState & state){
       L2::ArithmeticOperation *aop = new L2::ArithmeticOperation();
       aop->op = plusequal;
       aop->rhs.name = "1";
-      aop->lhs = parsed_w_vals.back();
+      aop->lhs = state.parsed_w_vals.back();
       p.functions.back()->instructions.push_back(aop);
     }
   };
 
   template<> struct action < L2_dec_rule > {
-    static void apply( const pegtl::input & in, L2::Program & p){
+    static void apply( const pegtl::input & in, L2::Program & p, ParseState & state){
       L2::ArithmeticOperation *aop = new L2::ArithmeticOperation();
       aop->op = minusequal;
       aop->rhs.name = "1";
-      aop->lhs = parsed_w_vals.back();
+      aop->lhs = state.parsed_w_vals.back();
       p.functions.back()->instructions.push_back(aop);
     }
   };
 
   template<> struct action < L2_mem_arithmetic_rule > {
-    static void apply( const pegtl::input & in, L2::Program & p){
+    static void apply( const pegtl::input & in, L2::Program & p, ParseState & state){
       L2::MemoryArithmeticOperation *maop = new L2::MemoryArithmeticOperation();
-      L2::MemoryReference memRef = parsed_mem_refs.back();
-      maop->op = current_aop;
+      L2::MemoryReference memRef = state.parsed_mem_refs.back();
+      maop->op = state.current_aop;
       maop->lhs = memRef;
-      maop->rhs = parsed_t_vals.back();
+      maop->rhs = state.parsed_t_vals.back();
       p.functions.back()->instructions.push_back(maop);
     }
   };
 
   template<> struct action < L2_mem_arithmetic_rule_2 > {
-    static void apply( const pegtl::input & in, L2::Program & p){
+    static void apply( const pegtl::input & in, L2::Program & p, ParseState & state){
       L2::MemoryArithmeticOperation2 *maop = new L2::MemoryArithmeticOperation2();
-      L2::MemoryReference memRef = parsed_mem_refs.back();
-      maop->op = current_aop;
-      maop->lhs = parsed_w_vals.back();
+      L2::MemoryReference memRef = state.parsed_mem_refs.back();
+      maop->op = state.current_aop;
+      maop->lhs = state.parsed_w_vals.back();
       maop->rhs = memRef;
       p.functions.back()->instructions.push_back(maop);
     }
   };
 
   template<> struct action < L2_assignment_lhs_rule > {
-    static void apply( const pegtl::input & in, L2::Program & p){
-      assignment_lhs = parsed_w_vals.back();
+    static void apply( const pegtl::input & in, L2::Program & p, ParseState & state){
+      state.assignment_lhs = state.parsed_w_vals.back();
     }
   };
 
   template<> struct action < L2_assignment_rhs_rule > {
-    static void apply( const pegtl::input & in, L2::Program & p){
-      assignment_rhs = parsed_s_vals.back();
+    static void apply( const pegtl::input & in, L2::Program & p, ParseState & state){
+      state.assignment_rhs = state.parsed_s_vals.back();
     }
   };
 
   template<> struct action < L2_assignment_rule > {
-    static void apply( const pegtl::input & in, L2::Program & p){
+    static void apply( const pegtl::input & in, L2::Program & p, ParseState & state){
       L2::Assignment *assignment = new L2::Assignment();
-      assignment->lhs = assignment_lhs;
-      assignment->rhs = assignment_rhs;
+      assignment->lhs = state.assignment_lhs;
+      assignment->rhs = state.assignment_rhs;
       p.functions.back()->instructions.push_back(assignment);
     }
   };
 
   template<> struct action < L2_load_lhs_rule > {
-    static void apply( const pegtl::input & in, L2::Program & p){
-      load_lhs = parsed_w_vals.back();
+    static void apply( const pegtl::input & in, L2::Program & p, ParseState & state){
+      state.load_lhs = state.parsed_w_vals.back();
     }
   };
 
   template<> struct action < L2_load_rule > {
-    static void apply( const pegtl::input & in, L2::Program & p){
+    static void apply( const pegtl::input & in, L2::Program & p, ParseState & state){
       L2::Load *load = new L2::Load();
-      load->lhs = load_lhs;
-      load->rhs = parsed_mem_refs.back();
+      load->lhs = state.load_lhs;
+      load->rhs = state.parsed_mem_refs.back();
       p.functions.back()->instructions.push_back(load);
     }
   };
 
   template<> struct action < L2_store_rule > {
-    static void apply( const pegtl::input & in, L2::Program & p){
+    static void apply( const pegtl::input & in, L2::Program & p, ParseState & state){
       L2::Store *store = new L2::Store();
-      store->lhs = parsed_mem_refs.back();
-      store->rhs = parsed_s_vals.back();
+      store->lhs = state.parsed_mem_refs.back();
+      store->rhs = state.parsed_s_vals.back();
       p.functions.back()->instructions.push_back(store);
     }
   };
 
   template<> struct action < L2_functioncall_rule > {
-    static void apply( const pegtl::input & in, L2::Program & p){
+    static void apply( const pegtl::input & in, L2::Program & p, ParseState & state){
       L2::FunctionCall *fCall = new L2::FunctionCall();
-      fCall->function_name = parsed_u_vals.back();
-      fCall->n_args = parsed_n_vals.back();
+      fCall->function_name = state.parsed_u_vals.back();
+      fCall->n_args = state.parsed_n_vals.back();
       p.functions.back()->instructions.push_back(fCall);
     }
   };
 
   template<> struct action < runtimename_rule > {
-    static void apply( const pegtl::input & in, L2::Program & p){
+    static void apply( const pegtl::input & in, L2::Program & p, ParseState & state){
       L2::L2_item name;
       name.name = in.string();
-      parsed_registers.push_back(name);
+      state.parsed_registers.push_back(name);
     }
   };
 
   template<> struct action < L2_runtimecall_rule > {
-    static void apply( const pegtl::input & in, L2::Program & p){
+    static void apply( const pegtl::input & in, L2::Program & p, ParseState & state){
       L2::RuntimeCall *rCall = new L2::RuntimeCall();
-      rCall->function_name = parsed_registers.back();
-      rCall->n_args = parsed_n_vals.back();
+      rCall->function_name = state.parsed_registers.back();
+      rCall->n_args = state.parsed_n_vals.back();
       p.functions.back()->instructions.push_back(rCall);
     }
   };
 
   template<> struct action < L2_return_rule > {
-    static void apply( const pegtl::input & in, L2::Program & p){
+    static void apply( const pegtl::input & in, L2::Program & p, ParseState & state){
       L2::ReturnCall *rCall = new L2::ReturnCall();
       p.functions.back()->instructions.push_back(rCall);
     }
   };
 
+  template<> struct action < L2_instruction_rule > {
+    static void apply( const pegtl::input & in, L2::Program & p, ParseState & state){
+      state.clear_memory();
+    }
+  };
+
   template<> struct action < L2_instructions_rule > {
-    static void apply( const pegtl::input & in, L2::Program & p){
+    static void apply( const pegtl::input & in, L2::Program & p, ParseState & state){
 
     }
   };
 
+  /*
+   * Walks the grammar for rules that could loop without consuming
+   * input, which costs more than parsing a small program. Only
+   * builds made with CHECK_GRAMMAR=1 do it, once per process.
+   */
+  void check_grammar() {
+#ifdef CHECK_GRAMMAR
+    static size_t issues = pegtl::analyze< L2::grammar >();
+    (void)issues;
+#endif
+  }
+
   L2::Program L2_parse_file (char *fileName){
 
     /*
      * Check the grammar for some possible issues.
      */
-    pegtl::analyze< L2::grammar >();
+    check_grammar();
 
     /*
      * Parse.
      */
     L2::Program p;
-    pegtl::file_parser(fileName).parse< L2::grammar, L2::action >(p);
+    ParseState state;
+    pegtl::file_parser(fileName).parse< L2::grammar, L2::action >(p, state);
 
     return p;
   }
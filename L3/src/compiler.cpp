@@ -0,0 +1,237 @@
+#include <string>
+#include <vector>
+#include <iostream>
+#include <set>
+#include <cctype>
+
+#include "compiler.h"
+#include "tile.h"
+
+using namespace std;
+
+vector<string> L3::caller_save_registers = {
+        "r10", "r11", "r8", "r9", "rax", "rcx", "rdi", "rdx", "rsi"
+};
+
+vector<string> L3::arg_registers = {
+        "rdi", "rsi", "rdx", "rcx", "r8", "r9"
+};
+
+vector<string> L3::callee_save_registers = {
+        "r12", "r13", "r14", "r15", "rbp", "rbx"
+};
+
+const set<string> L2_registers = {
+        "rax", "rbx", "rcx", "rdx", "rdi", "rsi", "rbp", "rsp",
+        "r8", "r9", "r10", "r11", "r12", "r13", "r14", "r15"
+};
+
+/*
+ * The names of f that the L2 parser would have recorded as variables.
+ */
+void record_variables(L2::Function *f) {
+  set<string> variables;
+  auto record = [&](const string &name) {
+    if (!(name[0] == ':' || name[0] == '-' || name[0] == '%' || isdigit(name[0]) ||
+          L2_registers.count(name)))
+      variables.insert(name);
+  };
+  for (auto i : f->instructions) {
+    switch (i->opcode) {
+      case L1::assignment_op: {
+        L2::Assignment *assn = static_cast<L2::Assignment *>(i);
+        record(assn->lhs.name);
+        record(assn->rhs.name);
+        break;
+      }
+      case L1::arithmetic_op: {
+        L2::ArithmeticOperation *aop = static_cast<L2::ArithmeticOperation *>(i);
+        record(aop->lhs.name);
+        record(aop->rhs.name);
+        break;
+      }
+      case L1::shift_op: {
+        L2::ShiftOperation *sop = static_cast<L2::ShiftOperation *>(i);
+        record(sop->lhs.name);
+        record(sop->rhs.name);
+        break;
+      }
+      case L1::comparison_op: {
+        L2::ComparisonOperation *comp = static_cast<L2::ComparisonOperation *>(i);
+        record(comp->lhs.name);
+        record(comp->cexp.lhs.name);
+        record(comp->cexp.rhs.name);
+        break;
+      }
+      case L1::cjump_op: {
+        L2::CjumpOperation *cj = static_cast<L2::CjumpOperation *>(i);
+        record(cj->cexp.lhs.name);
+        break;
+      }
+      case L1::load_op: {
+        L2::Load *load = static_cast<L2::Load *>(i);
+        record(load->lhs.name);
+        record(load->rhs.value.name);
+        break;
+      }
+      case L1::store_op: {
+        L2::Store *store = static_cast<L2::Store *>(i);
+        record(store->lhs.value.name);
+        record(store->rhs.name);
+        break;
+      }
+      case L1::function_call_op: {
+        L2::FunctionCall *fCall = static_cast<L2::FunctionCall *>(i);
+        record(fCall->function_name.name);
+        break;
+      }
+      default:
+        break;
+    }
+  }
+  f->variables.assign(variables.begin(), variables.end());
+}
+
+L2::Program compile_L3(L3::Program p) {
+  L2::Program newP;
+  newP.entryPointLabel = ":main";
+
+  // generate trees
+  for (auto fun : p.functions) {
+    L2::Function *newF = new L2::Function();
+    newF->name = fun->name;
+    newF->arguments = fun->args.size();
+    newF->locals = 0;
+    string fun_id = fun->name.erase(0, 1) + "uniqid";
+    vector<shared_ptr<tree::Tree>> forest = generate_forest(*fun, fun_id);
+    forest = merge_forest(forest);
+
+    // tile the trees
+    vector<vector<shared_ptr<tile::Tile>>> tiles = tile_forest(forest);
+
+    // generate the output
+    for (auto tiling : tiles)
+      for (auto i = tiling.size(); i > 0; i--)
+        for (auto instruction : tiling[i - 1]->L2_instructions())
+          newF->instructions.push_back(instruction);
+
+    record_variables(newF);
+    newP.functions.push_back(newF);
+  }
+
+  return newP;
+}
+
+string L2_source(const L2::MemoryReference &m) {
+  return "(mem " + m.value.name + " " + to_string(m.offset_int) + ")";
+}
+
+string L2_source(L2::ArithmeticOperator op) {
+  switch (op) {
+    case L2::plusequal:
+      return "+=";
+    case L2::minusequal:
+      return "-=";
+    case L2::andequal:
+      return "&=";
+    case L2::timesequal:
+      return "*=";
+  }
+  return "";
+}
+
+string L2_source(const L2::ComparisonExpression &cexp) {
+  string op_string;
+  switch (cexp.op) {
+    case L2::lessthan:
+      op_string = "<";
+      break;
+    case L2::lessthanorequal:
+      op_string = "<=";
+      break;
+    case L2::equal:
+      op_string = "=";
+      break;
+  }
+  return cexp.lhs.name + " " + op_string + " " + cexp.rhs.name;
+}
+
+/*
+ * Writes p out as L2 source. Only covers the instructions the tiles
+ * emit.
+ */
+void dump_program(const L2::Program &p, ostream &output) {
+  output << "(" << p.entryPointLabel << "\n";
+  for (auto f : p.functions) {
+    output << "(" << f->name << "\n" << f->arguments << " " << f->locals << "\n";
+    for (auto i : f->instructions) {
+      switch (i->opcode) {
+        case L1::load_op: {
+          L2::Load *load = static_cast<L2::Load *>(i);
+          output << "(" << load->lhs.name << " <- " << L2_source(load->rhs) << ")\n";
+          break;
+        }
+        case L1::store_op: {
+          L2::Store *store = static_cast<L2::Store *>(i);
+          output << "(" << L2_source(store->lhs) << " <- " << store->rhs.name << ")\n";
+          break;
+        }
+        case L1::assignment_op: {
+          L2::Assignment *assn = static_cast<L2::Assignment *>(i);
+          output << "(" << assn->lhs.name << " <- " << assn->rhs.name << ")\n";
+          break;
+        }
+        case L1::return_op: {
+          output << "(return)\n";
+          break;
+        }
+        case L1::arithmetic_op: {
+          L2::ArithmeticOperation *aop = static_cast<L2::ArithmeticOperation *>(i);
+          output << "(" << aop->lhs.name << " " << L2_source(aop->op) << " " << aop->rhs.name << ")\n";
+          break;
+        }
+        case L1::shift_op: {
+          L2::ShiftOperation *sop = static_cast<L2::ShiftOperation *>(i);
+          string sop_string = sop->op == L2::lshift ? "<<=" : ">>=";
+          string amount = sop->rhs.name == "%cl" ? "rcx" : sop->rhs.name;
+          output << "(" << sop->lhs.name << " " << sop_string << " " << amount << ")\n";
+          break;
+        }
+        case L1::comparison_op: {
+          L2::ComparisonOperation *comp = static_cast<L2::ComparisonOperation *>(i);
+          output << "(" << comp->lhs.name << " <- " << L2_source(comp->cexp) << ")\n";
+          break;
+        }
+        case L1::runtime_call_op: {
+          L2::RuntimeCall *rCall = static_cast<L2::RuntimeCall *>(i);
+          output << "(call " << rCall->function_name.name << " " << rCall->n_args << ")\n";
+          break;
+        }
+        case L1::function_call_op: {
+          L2::FunctionCall *fCall = static_cast<L2::FunctionCall *>(i);
+          output << "(call " << fCall->function_name.name << " " << fCall->n_args << ")\n";
+          break;
+        }
+        case L1::label_op: {
+          L2::Label *lbl = static_cast<L2::Label *>(i);
+          output << lbl->name << "\n";
+          break;
+        }
+        case L1::cjump_op: {
+          L2::CjumpOperation *cj = static_cast<L2::CjumpOperation *>(i);
+          output << "(cjump " << L2_source(cj->cexp) << " " << cj->then_label << " " << cj->else_label << ")\n";
+          break;
+        }
+        case L1::goto_op: {
+          L2::GotoOperation *gt = static_cast<L2::GotoOperation *>(i);
+          output << "(goto " << gt->lbl.name << ")\n";
+          break;
+        }
+        default:
+          break;
+      }
+    }
+    output << ")\n";
+  }
+  output << ")\n";
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <ostream>
+
+#include "L3.h"
+#include "../../L2/src/L2.h"
+
+L2::Program compile_L3(L3::Program p);
+
+void dump_program(const L2::Program &p, std::ostream &output);
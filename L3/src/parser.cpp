@@ -362,45 +362,48 @@ namespace L3 {
       entry_point_rule
     > {};
 
-  /////////////
-  //   DATA  //
-  /////////////
-  
-  std::vector<L3::Function *> parsed_functions;
-  std::vector<L3::Variable *> parsed_variables;
-  std::vector<L3::L3_s> parsed_s_vals;
-  std::vector<L3::L3_t> parsed_t_vals;
-  std::vector<L3::L3_u> parsed_u_vals;
-  std::vector<L3::L3_t> parsed_args;
-  L3::L3_callee parsed_callee;
-  std::vector<std::string> parsed_strings;
-  L3::Operation parsed_op;
-  L3::Comparator parsed_cop;
+  /*
+   * What a parse has read but not yet put into the program. Every
+   * parse gets its own, passed to the actions, so several parses
+   * can run at once.
+   */
+  struct ParseState {
+    std::vector<L3::Function *> parsed_functions;
+    std::vector<L3::Variable *> parsed_variables;
+    std::vector<L3::L3_s> parsed_s_vals;
+    std::vector<L3::L3_t> parsed_t_vals;
+    std::vector<L3::L3_u> parsed_u_vals;
+    std::vector<L3::L3_t> parsed_args;
+    L3::L3_callee parsed_callee;
+    std::vector<std::string> parsed_strings;
+    L3::Operation parsed_op;
+    L3::Comparator parsed_cop;
+
+    void clear_memory() {
+      parsed_variables.clear();
+      parsed_s_vals.clear();
+      parsed_t_vals.clear();
+      parsed_u_vals.clear();
+      parsed_strings.clear();
+      parsed_args.clear();
+    }
+  };
 
   /////////////
   // ACTIONS //
   /////////////
   
-  void clear_memory() {
-    parsed_variables.clear();
-    parsed_s_vals.clear();
-    parsed_t_vals.clear();
-    parsed_u_vals.clear();
-    parsed_strings.clear();
-    parsed_args.clear();
-  }
-  
   template< typename Rule >
     struct action : pegtl::nothing< Rule > {};
   
   template<> struct action < L3_label_rule >{
-    static void apply( const pegtl::input &in, L3::Program &p){
-      parsed_strings.push_back(in.string()); 
+    static void apply( const pegtl::input &in, L3::Program &p, ParseState &state){
+      state.parsed_strings.push_back(in.string()); 
     }
   };
 
   template<> struct action < L3_cop_rule >{
-    static void apply( const pegtl::input &in, L3::Program &p){
+    static void apply( const pegtl::input &in, L3::Program &p, ParseState &state){
       std::string cop = in.string();
       std::string lt ("<");
       std::string lte ("<=");
@@ -408,20 +411,20 @@ namespace L3 {
       std::string gte (">=");
       std::string gt (">");
       if (cop.compare(lt) == 0)
-        parsed_cop = L3::lt;
+        state.parsed_cop = L3::lt;
       else if (cop.compare(lte) == 0)
-        parsed_cop = L3::lte;
+        state.parsed_cop = L3::lte;
       else if (cop.compare(eq) == 0)
-        parsed_cop = L3::eq;
+        state.parsed_cop = L3::eq;
       else if (cop.compare(gte) == 0)
-        parsed_cop = L3::gte;
+        state.parsed_cop = L3::gte;
       else if (cop.compare(gt) == 0)
-        parsed_cop = L3::gt;
+        state.parsed_cop = L3::gt;
     }
   };
 
   template<> struct action < L3_op_rule >{
-    static void apply( const pegtl::input &in, L3::Program &p){
+    static void apply( const pegtl::input &in, L3::Program &p, ParseState &state){
       std::string op = in.string();
       std::string plus ("+");
       std::string minus ("-");
@@ -430,77 +433,77 @@ namespace L3 {
       std::string lshift ("<<");
       std::string rshift (">>");
       if (op.compare(plus) == 0)
-        parsed_op = L3::plus;
+        state.parsed_op = L3::plus;
       else if (op.compare(minus) == 0)
-        parsed_op = L3::minus;
+        state.parsed_op = L3::minus;
       else if (op.compare(times) == 0)
-        parsed_op = L3::times;
+        state.parsed_op = L3::times;
       else if (op.compare(l3and) == 0)
-        parsed_op = L3::l3and;
+        state.parsed_op = L3::l3and;
       else if (op.compare(lshift) == 0)
-        parsed_op = L3::lshift;
+        state.parsed_op = L3::lshift;
       else if (op.compare(rshift) == 0)
-        parsed_op = L3::rshift;
+        state.parsed_op = L3::rshift;
     }
   };
 
   template<> struct action < L3_s_rule >{
-    static void apply( const pegtl::input &in, L3::Program &p){
+    static void apply( const pegtl::input &in, L3::Program &p, ParseState &state){
       L3::L3_s s;
       s.name = in.string();
-      parsed_s_vals.push_back(s);
+      state.parsed_s_vals.push_back(s);
     }
   };
 
   template<> struct action < L3_t_rule >{
-    static void apply( const pegtl::input &in, L3::Program &p){
+    static void apply( const pegtl::input &in, L3::Program &p, ParseState &state){
       L3::L3_t t;
       t.name = in.string();
-      parsed_t_vals.push_back(t);
+      state.parsed_t_vals.push_back(t);
     }
   };
 
   template<> struct action < L3_u_rule >{
-    static void apply( const pegtl::input &in, L3::Program &p){
+    static void apply( const pegtl::input &in, L3::Program &p, ParseState &state){
       L3::L3_u u;
       u.name = in.string();
-      parsed_u_vals.push_back(u);
+      state.parsed_u_vals.push_back(u);
     }
   };
 
   template<> struct action < L3_var_rule >{
-    static void apply( const pegtl::input &in, L3::Program &p){
+    static void apply( const pegtl::input &in, L3::Program &p, ParseState &state){
       L3::Variable *var = new L3::Variable();
       var->name = in.string();
-      parsed_variables.push_back(var);
+      state.parsed_variables.push_back(var);
     }
   };
 
   template<> struct action < L3_args_rule >{
-    static void apply( const pegtl::input &in, L3::Program &p){
+    static void apply( const pegtl::input &in, L3::Program &p, ParseState &state){
       // args are a property of a function call.
-      parsed_args.insert(
-          parsed_args.end(),
-          parsed_t_vals.begin(),
-          parsed_t_vals.end()
+      state.parsed_args.insert(
+          state.parsed_args.end(),
+          state.parsed_t_vals.begin(),
+          state.parsed_t_vals.end()
       );
-      for (int i = 0; i < parsed_args.size(); i++) {
+      for (int i = 0; i < state.parsed_args.size(); i++) {
         L3::Assignment *arg_assn = new L3::Assignment;
         arg_assn->lhs.name = arg_registers[i]; 
-        arg_assn->rhs.name = parsed_args[i].name;
+        arg_assn->rhs.name = state.parsed_args[i].name;
         p.functions.back()->instructions.push_back(arg_assn);
       }
     }
   };
 
   template<> struct action < L3_vars_rule >{
-    static void apply( const pegtl::input &in, L3::Program &p){
+    static void apply( const pegtl::input &in, L3::Program &p, ParseState &state){
       // vars are a property of a function itself.
       L3::Function *currentFunction = p.functions.back();
       currentFunction->args.insert(
           currentFunction->args.end(),
-          parsed_t_vals.begin(),
-          parsed_t_vals.end()
+          state.parsed_t_vals.begin(),
+          state.parsed_t_vals.end()
       );
       for (int i = 0; i < currentFunction->args.size(); i++) {
         L3::Assignment *arg_assn = new L3::Assignment;
@@ -508,188 +511,201 @@ namespace L3 {
         arg_assn->rhs.name = arg_registers[i];
         currentFunction->instructions.push_back(arg_assn);
       }
-      clear_memory();
+      state.clear_memory();
     }
   };
 
   template<> struct action < L3_callee_rule >{
-    static void apply( const pegtl::input &in, L3::Program &p){
+    static void apply( const pegtl::input &in, L3::Program &p, ParseState &state){
       L3::L3_callee callee;
       callee.name = in.string();
-      parsed_callee = callee;
+      state.parsed_callee = callee;
     }
   };
 
   template<> struct action < L3_assignment_rule >{
-    static void apply( const pegtl::input &in, L3::Program &p){
-      L3::Variable lhs = *parsed_variables.at(0);
-      L3::L3_s rhs = parsed_s_vals.back();
+    static void apply( const pegtl::input &in, L3::Program &p, ParseState &state){
+      L3::Variable lhs = *state.parsed_variables.at(0);
+      L3::L3_s rhs = state.parsed_s_vals.back();
       L3::Assignment *assignment = new L3::Assignment();
       assignment->lhs = lhs;
       assignment->rhs = rhs;
       p.functions.back()->instructions.push_back(assignment);
-      clear_memory();
+      state.clear_memory();
     }
   };
 
   template<> struct action < L3_arithmetic_rule >{
-    static void apply( const pegtl::input &in, L3::Program &p){
+    static void apply( const pegtl::input &in, L3::Program &p, ParseState &state){
       L3::Arithmetic *arithmetic = new L3::Arithmetic();
-      L3::Variable lhs = *parsed_variables.at(0);
+      L3::Variable lhs = *state.parsed_variables.at(0);
       arithmetic->lhs = lhs;
-      arithmetic->arith_lhs = parsed_t_vals.end()[-2];
-      arithmetic->arith_rhs = parsed_t_vals.end()[-1];
-      arithmetic->arith_op = parsed_op;
+      arithmetic->arith_lhs = state.parsed_t_vals.end()[-2];
+      arithmetic->arith_rhs = state.parsed_t_vals.end()[-1];
+      arithmetic->arith_op = state.parsed_op;
       p.functions.back()->instructions.push_back(arithmetic);
-      clear_memory();
+      state.clear_memory();
     }
   };
 
   template<> struct action < L3_comparison_rule >{
-    static void apply( const pegtl::input &in, L3::Program &p){
-      L3::Variable lhs = *parsed_variables.at(0);
+    static void apply( const pegtl::input &in, L3::Program &p, ParseState &state){
+      L3::Variable lhs = *state.parsed_variables.at(0);
       L3::Comparison *comparison = new L3::Comparison();
       comparison->lhs = lhs;
-      comparison->comp_lhs = parsed_t_vals.end()[-2];
-      comparison->comp_rhs = parsed_t_vals.end()[-1];
-      comparison->comp_op = parsed_cop;
+      comparison->comp_lhs = state.parsed_t_vals.end()[-2];
+      comparison->comp_rhs = state.parsed_t_vals.end()[-1];
+      comparison->comp_op = state.parsed_cop;
       p.functions.back()->instructions.push_back(comparison);
-      clear_memory();
+      state.clear_memory();
     }
   };
 
   template<> struct action < L3_load_rule >{
-    static void apply( const pegtl::input &in, L3::Program &p){
-      L3::Variable lhs = *parsed_variables.at(0);
-      L3::Variable rhs = *parsed_variables.at(1);
+    static void apply( const pegtl::input &in, L3::Program &p, ParseState &state){
+      L3::Variable lhs = *state.parsed_variables.at(0);
+      L3::Variable rhs = *state.parsed_variables.at(1);
       L3::Load *load = new L3::Load();
       load->lhs = lhs;
       load->rhs = rhs;
       p.functions.back()->instructions.push_back(load);
-      clear_memory();
+      state.clear_memory();
     }
   };
 
   template<> struct action < L3_store_rule >{
-    static void apply( const pegtl::input &in, L3::Program &p){
+    static void apply( const pegtl::input &in, L3::Program &p, ParseState &state){
       // index 0 is "store"
-      L3::Variable lhs = *parsed_variables.at(1);
-      L3::L3_s rhs = parsed_s_vals.back();
+      L3::Variable lhs = *state.parsed_variables.at(1);
+      L3::L3_s rhs = state.parsed_s_vals.back();
       L3::Store *store = new L3::Store();
       store->lhs = lhs;
       store->rhs = rhs;
       p.functions.back()->instructions.push_back(store);
-      clear_memory();
+      state.clear_memory();
     }
   };
 
   template<> struct action < L3_branch_rule >{
-    static void apply( const pegtl::input &in, L3::Program &p){
+    static void apply( const pegtl::input &in, L3::Program &p, ParseState &state){
       L3::Branch *branch = new L3::Branch();
       L3::L3_item dest;
-      dest.name = parsed_strings.back();
+      dest.name = state.parsed_strings.back();
       branch->dest = dest;
       p.functions.back()->instructions.push_back(branch);
-      clear_memory();
+      state.clear_memory();
     }
   };
 
   template<> struct action < L3_i_label_rule >{
-      static void apply( const pegtl::input &in, L3::Program &p){
+      static void apply( const pegtl::input &in, L3::Program &p, ParseState &state){
         L3::Label *label = new L3::Label();
         L3::L3_item lbl;
-        lbl.name = parsed_variables.back()->name;
+        lbl.name = state.parsed_variables.back()->name;
         label->label = lbl;
         p.functions.back()->instructions.push_back(label);
-        clear_memory();
+        state.clear_memory();
       }
   };
 
   template<> struct action < L3_conditional_branch_rule >{
-    static void apply( const pegtl::input &in, L3::Program &p){
+    static void apply( const pegtl::input &in, L3::Program &p, ParseState &state){
       L3::CBranch *cbranch = new L3::CBranch();
       L3::L3_item then_dest;
-      then_dest.name = parsed_strings.end()[-2];
+      then_dest.name = state.parsed_strings.end()[-2];
       L3::L3_item else_dest;
-      else_dest.name = parsed_strings.end()[-1];
-      L3::Variable *condition = parsed_variables.at(0);
+      else_dest.name = state.parsed_strings.end()[-1];
+      L3::Variable *condition = state.parsed_variables.at(0);
       cbranch->condition = *condition;
       cbranch->then_dest = then_dest;
       cbranch->else_dest = else_dest;
       p.functions.back()->instructions.push_back(cbranch);
-      clear_memory();
+      state.clear_memory();
     }
   };
 
   template<> struct action < L3_return_rule >{
-    static void apply( const pegtl::input &in, L3::Program &p){
+    static void apply( const pegtl::input &in, L3::Program &p, ParseState &state){
       L3::Return *ret = new L3::Return();
       p.functions.back()->instructions.push_back(ret);
-      clear_memory();
+      state.clear_memory();
     }
   };
 
   template<> struct action < L3_returnvalue_rule >{
-    static void apply( const pegtl::input &in, L3::Program &p){
+    static void apply( const pegtl::input &in, L3::Program &p, ParseState &state){
       L3::ReturnValue *ret = new L3::ReturnValue();
-      L3::L3_t retvar = parsed_t_vals.back();
+      L3::L3_t retvar = state.parsed_t_vals.back();
       ret->value = retvar;
       p.functions.back()->instructions.push_back(ret);
-      clear_memory();
+      state.clear_memory();
     }
   };
 
   template<> struct action < L3_call_rule >{
-    static void apply( const pegtl::input &in, L3::Program &p){
+    static void apply( const pegtl::input &in, L3::Program &p, ParseState &state){
       L3::Call *call = new L3::Call();
-      call->callee = parsed_callee;
+      call->callee = state.parsed_callee;
       call->args.insert(
           call->args.end(),
-          parsed_args.begin(),
-          parsed_args.end()
+          state.parsed_args.begin(),
+          state.parsed_args.end()
       );
       p.functions.back()->instructions.push_back(call);
-      clear_memory();
+      state.clear_memory();
     }
   };
 
   template<> struct action < L3_call_assign_rule >{
-    static void apply( const pegtl::input &in, L3::Program &p){
+    static void apply( const pegtl::input &in, L3::Program &p, ParseState &state){
       L3::CallAssign *calla = new L3::CallAssign();
-      calla->callee = parsed_callee;
+      calla->callee = state.parsed_callee;
       calla->args.insert(
           calla->args.end(),
-          parsed_args.begin(),
-          parsed_args.end()
+          state.parsed_args.begin(),
+          state.parsed_args.end()
       );
-      calla->lhs = *parsed_variables.at(0);
+      calla->lhs = *state.parsed_variables.at(0);
       p.functions.back()->instructions.push_back(calla);
-      clear_memory();
+      state.clear_memory();
     }
   };
 
   template<> struct action < L3_function_name_rule >{
-      static void apply( const pegtl::input &in, L3::Program &p){
+      static void apply( const pegtl::input &in, L3::Program &p, ParseState &state){
         L3::Function *fn = new L3::Function();
-        fn->name = parsed_strings.back();
+        fn->name = state.parsed_strings.back();
         p.functions.push_back(fn);
-        clear_memory();
+        state.clear_memory();
       }
   };
 
 
+  /*
+   * Walks the grammar for rules that could loop without consuming
+   * input, which costs more than parsing a small program. Only
+   * builds made with CHECK_GRAMMAR=1 do it, once per process.
+   */
+  void check_grammar() {
+#ifdef CHECK_GRAMMAR
+    static size_t issues = pegtl::analyze< L3::grammar >();
+    (void)issues;
+#endif
+  }
+
   L3::Program L3_parse_file (char *fileName){
 
     /*
      * Check the grammar for some possible issues.
      */
-    pegtl::analyze< L3::grammar >();
+    check_grammar();
 
     /*
      * Parse.
      */
     L3::Program p;
-    pegtl::file_parser(fileName).parse< L3::grammar, L3::action >(p);
+    ParseState state;
+    pegtl::file_parser(fileName).parse< L3::grammar, L3::action >(p, state);
 
     return p;
   }
@@ -1,6 +1,7 @@
 #include "tile.h"
 #include <iostream>
 #include <vector>
+#include <cctype>
 
 using namespace std;
 
@@ -46,3 +47,123 @@ vector<vector<shared_ptr<tile::Tile>>> tile_forest(vector<shared_ptr<tree::Tree>
   }
   return tiling;
 }
+
+namespace tile {
+
+  /*
+   * Numbers and labels are the only operands the L2 parser doesn't
+   * mark as variables or registers.
+   */
+  template <typename T>
+  T L2_value(const string &name) {
+    T item;
+    item.name = name;
+    item.r = !(name[0] == ':' || name[0] == '-' || isdigit(name[0]));
+    return item;
+  }
+
+  L2::MemoryReference L2_memory(const string &address) {
+    L2::MemoryReference m;
+    m.value = L2_value<L2::L2_x>(address);
+    m.offset.name = "0";
+    return m;
+  }
+
+  L2::Instruction *L2_assignment(const string &lhs, const string &rhs) {
+    L2::Assignment *a = new L2::Assignment();
+    a->lhs = L2_value<L2::L2_w>(lhs);
+    a->rhs = L2_value<L2::L2_s>(rhs);
+    return a;
+  }
+
+  L2::Instruction *L2_arithmetic(const string &lhs, tree::Operator op, const string &rhs) {
+    if (op == tree::lshift || op == tree::rshift) {
+      L2::ShiftOperation *s = new L2::ShiftOperation();
+      s->lhs = L2_value<L2::L2_w>(lhs);
+      s->op = op == tree::lshift ? L2::lshift : L2::rshift;
+      s->rhs.name = rhs == "rcx" ? "%cl" : rhs;
+      return s;
+    }
+    L2::ArithmeticOperation *a = new L2::ArithmeticOperation();
+    a->lhs = L2_value<L2::L2_w>(lhs);
+    switch (op) {
+      case tree::add:
+        a->op = L2::plusequal;
+        break;
+      case tree::mul:
+        a->op = L2::timesequal;
+        break;
+      case tree::sub:
+        a->op = L2::minusequal;
+        break;
+      default:
+        a->op = L2::andequal;
+        break;
+    }
+    a->rhs = L2_value<L2::L2_t>(rhs);
+    return a;
+  }
+
+  L2::Instruction *L2_comparison(const string &lhs, tree::Operator op, const string &cmp_lhs, const string &cmp_rhs) {
+    L2::ComparisonOperation *c = new L2::ComparisonOperation();
+    c->lhs = L2_value<L2::L2_w>(lhs);
+    c->cexp.lhs = L2_value<L2::L2_t>(cmp_lhs);
+    c->cexp.op = op == tree::lt ? L2::lessthan : op == tree::lte ? L2::lessthanorequal : L2::equal;
+    c->cexp.rhs = L2_value<L2::L2_t>(cmp_rhs);
+    return c;
+  }
+
+  L2::Instruction *L2_load(const string &lhs, const string &address) {
+    L2::Load *l = new L2::Load();
+    l->lhs = L2_value<L2::L2_w>(lhs);
+    l->rhs = L2_memory(address);
+    return l;
+  }
+
+  L2::Instruction *L2_store(const string &address, const string &rhs) {
+    L2::Store *s = new L2::Store();
+    s->lhs = L2_memory(address);
+    s->rhs = L2_value<L2::L2_s>(rhs);
+    return s;
+  }
+
+  L2::Instruction *L2_goto(const string &label) {
+    L2::GotoOperation *g = new L2::GotoOperation();
+    g->lbl.name = label;
+    return g;
+  }
+
+  L2::Instruction *L2_cjump(const string &condition, const string &then_label, const string &else_label) {
+    L2::CjumpOperation *c = new L2::CjumpOperation();
+    c->cexp.lhs = L2_value<L2::L2_t>(condition);
+    c->cexp.op = L2::equal;
+    c->cexp.rhs = L2_value<L2::L2_t>("1");
+    c->then_label = then_label;
+    c->else_label = else_label;
+    return c;
+  }
+
+  L2::Instruction *L2_label(const string &label) {
+    L2::Label *l = new L2::Label();
+    l->name = label;
+    return l;
+  }
+
+  L2::Instruction *L2_call(const string &callee, int64_t n_args) {
+    if (callee == "print" || callee == "allocate" || callee == "array-error") {
+      L2::RuntimeCall *c = new L2::RuntimeCall();
+      c->function_name.name = callee;
+      c->n_args = n_args;
+      return c;
+    }
+    L2::FunctionCall *c = new L2::FunctionCall();
+    c->function_name.name = callee;
+    c->n_args = n_args;
+    return c;
+  }
+
+  L2::Instruction *L2_return() {
+    return new L2::ReturnCall();
+  }
+
+}
@@ -1,4 +1,5 @@
 #include "tree.h"
+#include "../../L2/src/L2.h"
 #include <vector>
 #include <iostream>
 #include <list>
@@ -10,6 +11,21 @@ using namespace std;
 
 namespace tile {
 
+    /*
+     * L2 instructions as the L2 parser would have built them from
+     * their source.
+     */
+    L2::Instruction *L2_assignment(const string &lhs, const string &rhs);
+    L2::Instruction *L2_arithmetic(const string &lhs, tree::Operator op, const string &rhs);
+    L2::Instruction *L2_comparison(const string &lhs, tree::Operator op, const string &cmp_lhs, const string &cmp_rhs);
+    L2::Instruction *L2_load(const string &lhs, const string &address);
+    L2::Instruction *L2_store(const string &address, const string &rhs);
+    L2::Instruction *L2_goto(const string &label);
+    L2::Instruction *L2_cjump(const string &condition, const string &then_label, const string &else_label);
+    L2::Instruction *L2_label(const string &label);
+    L2::Instruction *L2_call(const string &callee, int64_t n_args);
+    L2::Instruction *L2_return();
+
     struct Tile {
       int64_t cost;
       Tile() : cost(1) {};
@@ -17,8 +33,7 @@ namespace tile {
       shared_ptr<tree::Tree> tree;
       virtual int coverage(shared_ptr<tree::Tree>) { return 0; };
       virtual bool covers(shared_ptr<tree::Tree>) { return false; };
-      virtual vector<string> generate_instructions(shared_ptr<tree::Tree>) { return {"implement me"}; };
-      virtual vector<string> dump_instructions() { return {"implement me too!"}; };
+      virtual vector<L2::Instruction *> L2_instructions() { return {}; };
       virtual shared_ptr<Tile> fire(shared_ptr<tree::Tree>) { return nullptr; };
       virtual vector<shared_ptr<tree::Tree>> get_subtrees() { return {nullptr}; };
     };
@@ -43,8 +58,8 @@ namespace tile {
           return fired_tile;
         }
 
-        vector<string> dump_instructions() {
-          return {"(return)"};
+        vector<L2::Instruction *> L2_instructions() {
+          return {L2_return()};
         }
 
         vector<shared_ptr<tree::Tree>> get_subtrees() {
@@ -75,9 +90,9 @@ namespace tile {
           return fired_tile;
         }
 
-        vector<string> dump_instructions() {
-          return {"(rax <- " + tree->lhs->root->item.name + ")",
-                  "(return)"};
+        vector<L2::Instruction *> L2_instructions() {
+          return {L2_assignment("rax", tree->lhs->root->item.name),
+                  L2_return()};
         }
 
         vector<shared_ptr<tree::Tree>> get_subtrees() {
@@ -109,8 +124,8 @@ namespace tile {
           return fired_tile;
         }
 
-        vector<string> dump_instructions() {
-          return {"(" + tree->root->item.name + " <- " + tree->lhs->root->item.name + ")"};
+        vector<L2::Instruction *> L2_instructions() {
+          return {L2_assignment(tree->root->item.name, tree->lhs->root->item.name)};
         }
 
         vector<shared_ptr<tree::Tree>> get_subtrees() {
@@ -122,7 +137,6 @@ namespace tile {
         L3::L3_item lhs;
         L3::L3_item arith_lhs;
         L3::L3_item arith_rhs;
-        string op_string;
 
         int coverage(shared_ptr<tree::Tree> tree) {
           if (covers(tree)) {
@@ -146,37 +160,12 @@ namespace tile {
         shared_ptr<tile::Tile> fire(shared_ptr<tree::Tree> tree) {
           shared_ptr<Arithmetic> fired_tile = make_shared<Arithmetic>();
           fired_tile->tree = tree;
-          switch (tree->op) {
-            case tree::add:
-              op_string = "+=";
-              break;
-            case tree::mul:
-              op_string = "*=";
-              break;
-            case tree::sub:
-              op_string = "-=";
-              break;
-            case tree::l3and:
-              op_string = "&=";
-              break;
-            case tree::lshift:
-              op_string = "<<=";
-              break;
-            case tree::rshift:
-              op_string = ">>=";
-              break;
-            default:
-              op_string = "your code sucks";
-              break;
-          };
-          fired_tile->op_string = op_string;
           return fired_tile;
         }
 
-        vector<string> dump_instructions() {
-          return {"(" + tree->root->item.name + " <- " + tree->lhs->root->item.name + ")",
-                  "(" + tree->root->item.name + " " + op_string + " " + tree->rhs->root->item.name + ")"};
-          
+        vector<L2::Instruction *> L2_instructions() {
+          return {L2_assignment(tree->root->item.name, tree->lhs->root->item.name),
+                  L2_arithmetic(tree->root->item.name, tree->op, tree->rhs->root->item.name)};
         }
 
         vector<shared_ptr<tree::Tree>> get_subtrees() {
@@ -188,7 +177,6 @@ namespace tile {
         L3::L3_item lhs;
         L3::L3_item comp_lhs;
         L3::L3_item comp_rhs;
-        string op_string;
 
         int coverage(shared_ptr<tree::Tree> tree) {
           if (covers(tree)) {
@@ -209,29 +197,13 @@ namespace tile {
         shared_ptr<tile::Tile> fire(shared_ptr<tree::Tree> tree) {
           shared_ptr<Comparison> fired_tile = make_shared<Comparison>();
           fired_tile->tree = tree;
-          switch (tree->op) {
-            case tree::lt:
-              op_string = "<";
-              break;
-            case tree::lte:
-              op_string = "<=";
-              break;
-            case tree::eq:
-              op_string = "=";
-              break;
-            default:
-              op_string = "your code sucks";
-              break;
-          };
-          fired_tile->op_string = op_string;
           return fired_tile;
         }
 
-        vector<string> dump_instructions() {
-          return {"(" + tree->root->item.name + " <- " +
-                  tree->lhs->root->item.name + " " +
-                  op_string + " " +
-                  tree->rhs->root->item.name + ")"};
+        vector<L2::Instruction *> L2_instructions() {
+          return {L2_comparison(tree->root->item.name, tree->op,
+                                tree->lhs->root->item.name,
+                                tree->rhs->root->item.name)};
         }
 
         vector<shared_ptr<tree::Tree>> get_subtrees() {
@@ -260,8 +232,8 @@ namespace tile {
           return fired_tile;
         }
 
-        vector<string> dump_instructions() {
-          return {"(goto " + tree->root->item.name + ")"};
+        vector<L2::Instruction *> L2_instructions() {
+          return {L2_goto(tree->root->item.name)};
         }
 
         vector<shared_ptr<tree::Tree>> get_subtrees() {
@@ -290,8 +262,8 @@ namespace tile {
           return fired_tile;
         }
 
-        vector<string> dump_instructions() {
-          return {"(cjump " + tree->root->item.name + " = 1 " + tree->data.at(0).name + " " + tree->data.at(1).name + ")"};
+        vector<L2::Instruction *> L2_instructions() {
+          return {L2_cjump(tree->root->item.name, tree->data.at(0).name, tree->data.at(1).name)};
         }
 
         vector<shared_ptr<tree::Tree>> get_subtrees() {
@@ -322,8 +294,8 @@ namespace tile {
           return fired_tile;
         }
 
-        vector<string> dump_instructions() {
-          return {":" + tree->data.at(0).name};
+        vector<L2::Instruction *> L2_instructions() {
+          return {L2_label(":" + tree->data.at(0).name)};
         }
 
         vector<shared_ptr<tree::Tree>> get_subtrees() {
@@ -352,18 +324,18 @@ namespace tile {
           return fired_tile;
         }
 
-        vector<string> dump_instructions() {
-          string n_args;
+        vector<L2::Instruction *> L2_instructions() {
+          int64_t n_args;
           string callee = tree->data.at(0).name;
           bool runtime = true;
           if (callee == "print")
-            n_args = "1";
+            n_args = 1;
           else if (callee == "allocate")
-            n_args = "2";
+            n_args = stoll(tree->data.at(1).name);  // 3 with an allocation site
           else if (callee == "array-error")
-            n_args = "0";
+            n_args = 0;
           else {
-            n_args = tree->data.at(1).name;
+            n_args = stoll(tree->data.at(1).name);
             runtime = false;
           }
           if (!runtime) {
@@ -371,11 +343,14 @@ namespace tile {
             ret_label = tree->data.at(0).name;
             ret_label.erase(ret_label.begin());
             ret_label = ":l3ret" + to_string(rand() % 100) + ret_label;
-            return {"((mem rsp -8) <- " + ret_label + ")",
-                    "(call " + tree->data.at(0).name + " " + n_args + ")",
-                    ret_label};
+            L2::Store *store = static_cast<L2::Store *>(L2_store("rsp", ret_label));
+            store->lhs.offset.name = "-8";
+            store->lhs.offset_int = -8;
+            return {store,
+                    L2_call(tree->data.at(0).name, n_args),
+                    L2_label(ret_label)};
           } else {
-            return {"(call " + tree->data.at(0).name + " " + n_args + ")"};
+            return {L2_call(tree->data.at(0).name, n_args)};
           }
         }
 
@@ -407,18 +382,18 @@ namespace tile {
           return fired_tile;
         }
 
-        vector<string> dump_instructions() {
-          string n_args;
+        vector<L2::Instruction *> L2_instructions() {
+          int64_t n_args;
           string callee = tree->data.at(0).name;
           bool runtime = true;
           if (callee == "print")
-            n_args = "1";
+            n_args = 1;
           else if (callee == "allocate")
-            n_args = "2";
+            n_args = stoll(tree->data.at(1).name);  // 3 with an allocation site
           else if (callee == "array-error")
-            n_args = "0";
+            n_args = 0;
           else {
-            n_args = tree->data.at(1).name;
+            n_args = stoll(tree->data.at(1).name);
             runtime = false;
           }
           if (!runtime) {
@@ -426,13 +401,16 @@ namespace tile {
             ret_label = tree->data.at(0).name;
             ret_label.erase(ret_label.begin());
             ret_label = ":l3ret" + to_string(rand() % 100) + ret_label;
-            return {"((mem rsp -8) <- " + ret_label + ")",
-                    "(call " + tree->data.at(0).name + " " + n_args + ")",
-                    ret_label,
-                    "(" + tree->root->item.name + " <- rax)"};
+            L2::Store *store = static_cast<L2::Store *>(L2_store("rsp", ret_label));
+            store->lhs.offset.name = "-8";
+            store->lhs.offset_int = -8;
+            return {store,
+                    L2_call(tree->data.at(0).name, n_args),
+                    L2_label(ret_label),
+                    L2_assignment(tree->root->item.name, "rax")};
           } else {
-            return {"(call " + tree->data.at(0).name + " " + n_args + ")",
-                    "(" + tree->root->item.name + " <- rax)"};
+            return {L2_call(tree->data.at(0).name, n_args),
+                    L2_assignment(tree->root->item.name, "rax")};
           }
         }
 
@@ -462,9 +440,8 @@ namespace tile {
           return fired_tile;
         }
 
-        vector<string> dump_instructions() {
-          string n_args;
-          return {"(" + tree->root->item.name + " <- (mem " + tree->lhs->root->item.name + " 0))"};
+        vector<L2::Instruction *> L2_instructions() {
+          return {L2_load(tree->root->item.name, tree->lhs->root->item.name)};
         }
 
         vector<shared_ptr<tree::Tree>> get_subtrees() {
@@ -493,9 +470,8 @@ namespace tile {
           return fired_tile;
         }
 
-        vector<string> dump_instructions() {
-          string n_args;
-          return {"((mem " + tree->root->item.name + " 0) <- " + tree->lhs->root->item.name + ")"};
+        vector<L2::Instruction *> L2_instructions() {
+          return {L2_store(tree->root->item.name, tree->lhs->root->item.name)};
         }
 
         vector<shared_ptr<tree::Tree>> get_subtrees() {
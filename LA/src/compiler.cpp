@@ -2,6 +2,7 @@
 #include <iostream>
 #include <fstream>
 #include <algorithm>
+#include <cctype>
 
 #include "compiler.h"
 
@@ -13,11 +14,11 @@ string get_hash() {
   return "id_" + to_string(hash_id++);
 }
 
-int encode(int n) {
+static int encode(int n) {
   return (n << 1) + 1;
 };
 
-int decode(int n) {
+static int decode(int n) {
   return (n >> 1) - 1;
 };
 
@@ -48,15 +49,191 @@ vector<string> get_free_vars(string seed, int n_vars, shared_ptr<LA::Function> f
   return vars;
 };
 
-void add_declaration(shared_ptr<LA::Function> f, shared_ptr<LA::Declaration> dec, ofstream &output) {
+void add_declaration(shared_ptr<LA::Function> f, shared_ptr<LA::Declaration> dec) {
   f->data_structs.insert(pair<string, shared_ptr<LA::Declaration>>(dec->var.name, dec));
   return;
 };
 
-void allocate_to_zero(shared_ptr<LA::Function> f, shared_ptr<LA::Declaration> dec, ofstream &output) {
+/*
+ * A name as the IR parser reads it, without the % of a variable.
+ */
+string IR_name(string name) {
+  if (!name.empty() && name[0] == '%')
+    name.erase(0,1);
+  return name;
+};
+
+/*
+ * Appends i to fn the way the IR parser would have: a label after a
+ * terminator starts a new basic block, everything else goes on the
+ * end of the last one.
+ */
+void add_instruction(shared_ptr<IR::Function> fn, shared_ptr<IR::Instruction> i) {
+  fn->blocks.back()->instructions.push_back(i);
+  return;
+};
+
+void label(shared_ptr<IR::Function> fn, string name) {
+  if (fn->blocks.empty() ||
+      (!fn->blocks.back()->instructions.empty() &&
+       dynamic_pointer_cast<IR::IR_te>(fn->blocks.back()->instructions.back()))) {
+    shared_ptr<IR::BasicBlock> bb = make_shared<IR::BasicBlock>();
+    bb->entry_point.name = name;
+    fn->blocks.push_back(bb);
+    return;
+  }
+  shared_ptr<IR::Label> lbl = make_shared<IR::Label>();
+  lbl->label.name = name;
+  add_instruction(fn, lbl);
+  return;
+};
+
+void assign(shared_ptr<IR::Function> fn, string lhs, string rhs) {
+  shared_ptr<IR::Assignment> assn = make_shared<IR::Assignment>();
+  assn->lhs.name = IR_name(lhs);
+  assn->rhs.name = IR_name(rhs);
+  add_instruction(fn, assn);
+  return;
+};
+
+void operation(shared_ptr<IR::Function> fn, string lhs, string op_lhs, LA::Operator op, string op_rhs) {
+  shared_ptr<IR::Operation> operation = make_shared<IR::Operation>();
+  operation->lhs.name = IR_name(lhs);
+  operation->op_lhs.name = IR_name(op_lhs);
+  operation->op_rhs.name = IR_name(op_rhs);
+  switch(op) {
+    case LA::plus:
+      operation->op = IR::plus;
+      break;
+    case LA::minus:
+      operation->op = IR::minus;
+      break;
+    case LA::times:
+      operation->op = IR::times;
+      break;
+    case LA::l3and:
+      operation->op = IR::l3and;
+      break;
+    case LA::lshift:
+      operation->op = IR::lshift;
+      break;
+    case LA::rshift:
+      operation->op = IR::rshift;
+      break;
+    case LA::lt:
+      operation->op = IR::lt;
+      break;
+    case LA::lte:
+      operation->op = IR::lte;
+      break;
+    case LA::eq:
+      operation->op = IR::eq;
+      break;
+    case LA::gt:
+      operation->op = IR::gt;
+      break;
+    case LA::gte:
+      operation->op = IR::gte;
+      break;
+  }
+  add_instruction(fn, operation);
+  return;
+};
+
+void branch(shared_ptr<IR::Function> fn, string dest) {
+  shared_ptr<IR::Branch> branch = make_shared<IR::Branch>();
+  branch->dest.name = dest;
+  add_instruction(fn, branch);
+  return;
+};
+
+void branch(shared_ptr<IR::Function> fn, string condition, string then_dest, string else_dest) {
+  shared_ptr<IR::CBranch> cbranch = make_shared<IR::CBranch>();
+  cbranch->condition.name = IR_name(condition);
+  cbranch->then_dest.name = then_dest;
+  cbranch->else_dest.name = else_dest;
+  add_instruction(fn, cbranch);
+  return;
+};
+
+/*
+ * The IR parser keeps the callee as written, % and all.
+ */
+void call(shared_ptr<IR::Function> fn, string lhs, string callee, vector<string> args) {
+  vector<IR::IR_t> ir_args;
+  for (auto arg : args) {
+    IR::IR_t ir_arg;
+    ir_arg.name = IR_name(arg);
+    ir_args.push_back(ir_arg);
+  }
+  if (lhs.empty()) {
+    shared_ptr<IR::Call> call = make_shared<IR::Call>();
+    call->callee.name = callee;
+    call->args = ir_args;
+    add_instruction(fn, call);
+  } else {
+    shared_ptr<IR::CallAssign> call = make_shared<IR::CallAssign>();
+    call->lhs.name = IR_name(lhs);
+    call->callee.name = callee;
+    call->args = ir_args;
+    add_instruction(fn, call);
+  }
+  return;
+};
+
+void length(shared_ptr<IR::Function> fn, string lhs, string rhs, string index) {
+  shared_ptr<IR::LengthRead> lr = make_shared<IR::LengthRead>();
+  lr->lhs.name = IR_name(lhs);
+  lr->rhs.name = IR_name(rhs);
+  lr->index.name = IR_name(index);
+  add_instruction(fn, lr);
+  return;
+};
+
+vector<IR::IR_t> IR_indices(vector<LA::LA_t> indices) {
+  vector<IR::IR_t> ir_indices;
+  for (auto index : indices) {
+    IR::IR_t ir_index;
+    ir_index.name = IR_name(index.name);
+    ir_indices.push_back(ir_index);
+  }
+  return ir_indices;
+};
+
+IR::Type IR_type(LA::Type type) {
+  IR::Type ir_type;
+  switch (type.data_type) {
+    case LA::array:
+      ir_type.dec_type = IR::array;
+      ir_type.array_dim = type.array_dim;
+      break;
+    case LA::tuple:
+      ir_type.dec_type = IR::tuple;
+      break;
+    case LA::code:
+      ir_type.dec_type = IR::code;
+      break;
+    case LA::LAvoid:
+      ir_type.dec_type = IR::IRvoid;
+      break;
+    default:
+      ir_type.dec_type = IR::integer;
+      break;
+  }
+  return ir_type;
+};
+
+shared_ptr<IR::Declaration> IR_declaration(shared_ptr<LA::Declaration> dec) {
+  shared_ptr<IR::Declaration> ir_dec = make_shared<IR::Declaration>();
+  ir_dec->var.name = IR_name(dec->var.name);
+  ir_dec->type = IR_type(dec->type);
+  return ir_dec;
+};
+
+void allocate_to_zero(shared_ptr<IR::Function> fn, shared_ptr<LA::Declaration> dec) {
   // to check for allocation
   if (dec->type.data_type == LA::array || dec->type.data_type == LA::tuple)
-    output << dec->var.name << " <- 0\n";
+    assign(fn, dec->var.name, "0");
   return;
 };
 
@@ -64,7 +241,7 @@ int64_t get_dimensionality(shared_ptr<LA::Function> f, string variable_name) {
   return -1;
 };
 
-bool is_number(const std::string& s)
+static bool is_number(const std::string& s)
 {
   std::string::const_iterator it = s.begin();
   while (it != s.end() && std::isdigit(*it)) ++it;
@@ -78,7 +255,7 @@ string safe_encode_constant(string in) {
     return in;
 }
 
-vector<string> decode_vars(shared_ptr<LA::Function> f, vector<LA::LA_item> vars, ofstream &output) {
+vector<string> decode_vars(shared_ptr<LA::Function> f, vector<LA::LA_item> vars, shared_ptr<IR::Function> fn) {
   vector<string> replacements;
   for (auto v : vars) {
     string v_name = v.name;
@@ -86,170 +263,129 @@ vector<string> decode_vars(shared_ptr<LA::Function> f, vector<LA::LA_item> vars,
       v_name.erase(0,1);
     string v_prime = get_free_var("prime" + v_name, f);
     replacements.push_back(v_prime);
-    output << v_prime << " <- " << safe_encode_constant(v.name) << endl;
-    output << v_prime << " <- " << v_prime << " >> 1\n";
+    assign(fn, v_prime, safe_encode_constant(v.name));
+    operation(fn, v_prime, v_prime, LA::rshift, "1");
   }
   return replacements;
 };
 
-void encode_vars(vector<string> vars, ofstream &output) {
+void encode_vars(vector<string> vars, shared_ptr<IR::Function> fn) {
   for (auto v : vars) {
-    output << v << " <- " << v << " << 1\n";
-    output << v << " <- " << v << " + 1\n";
+    operation(fn, v, v, LA::lshift, "1");
+    operation(fn, v, v, LA::plus, "1");
   }
 };
 
-void Compiler::Compile(LA::Program p) {
-  ofstream output;
-  output.open("prog.IR");
+/*
+ * The IR callee of a call in f: functions are labels, code values
+ * keep their %.
+ */
+string IR_callee(shared_ptr<LA::Function> f, string callee) {
+  auto data_iter = f->data_structs.find(callee);
+  bool is_code = false;
+  if (data_iter != f->data_structs.end())
+    if (data_iter->second->type.data_type == LA::code)
+      is_code = true;
+  if (callee[0] == '%' && !is_code)
+    callee.erase(0,1);
+  if (callee != "array-error" && callee != "print" && !is_code)
+    callee = ':' + callee;
+  return callee;
+};
+
+vector<string> encoded_args(vector<LA::LA_t> args) {
+  vector<string> encoded;
+  for (auto arg : args)
+    encoded.push_back(safe_encode_constant(arg.name));
+  return encoded;
+};
+
+IR::Program Compiler::Compile(LA::Program p) {
 
+  IR::Program ir;
   for (auto f : p.functions) {
-    // write the function name and its args
-    output << "define " << f->return_type.to_string() << " :" << f->name << "(";
+    // the function name and its args
+    shared_ptr<IR::Function> fn = make_shared<IR::Function>();
+    fn->name = ":" + f->name;
+    fn->return_type = IR_type(f->return_type);
+    ir.functions.push_back(fn);
     for (int var_i = 0; var_i < f->vars.size(); var_i++) {
-      add_declaration(f, f->vars[var_i], output);
-      output << f->vars[var_i]->type.to_string() << " " << f->vars[var_i]->var.name;
-      if (var_i < f->vars.size() - 1)
-        output << ", ";
+      add_declaration(f, f->vars[var_i]);
+      fn->vars.push_back(IR_declaration(f->vars[var_i]));
     }
-    output << "){\n";
     for (auto i : f->instructions) {
-      // write the instructions one by one!
+      // translate the instructions one by one!
       if (shared_ptr<LA::Assignment> assn = dynamic_pointer_cast<LA::Assignment>(i))
       {
-        output << assn->lhs.name << " <- " << safe_encode_constant(assn->rhs.name) << endl;
+        assign(fn, assn->lhs.name, safe_encode_constant(assn->rhs.name));
       }
       else if (shared_ptr<LA::Operation> op = dynamic_pointer_cast<LA::Operation>(i))
       {
-        string op_string;
-        switch(op->op) {
-          case LA::plus:
-            op_string = "+";
-            break;
-          case LA::minus:
-            op_string = "-";
-            break;
-          case LA::times:
-            op_string = "*";
-            break;
-          case LA::l3and:
-            op_string = "&";
-            break;
-          case LA::lshift:
-            op_string = "<<";
-            break;
-          case LA::rshift:
-            op_string = ">>";
-            break;
-          case LA::lt:
-            op_string = "<";
-            break;
-          case LA::lte:
-            op_string = "<=";
-            break;
-          case LA::eq:
-            op_string = "=";
-            break;
-          case LA::gt:
-            op_string = ">";
-            break;
-          case LA::gte:
-            op_string = ">=";
-            break;
-          default:
-            break;
-        }
         vector<LA::LA_item> vars_to_decode = op->toDecode();
-        vector<string> replacements = decode_vars(f, vars_to_decode, output);
+        vector<string> replacements = decode_vars(f, vars_to_decode, fn);
         shared_ptr<LA::Operation> decoded_op = op->decode(replacements);
-        output << decoded_op->lhs.name << " <- ";
-        output << safe_encode_constant(decoded_op->op_lhs.name) << " " << op_string << " " << safe_encode_constant(decoded_op->op_rhs.name) << endl;
-        encode_vars({decoded_op->lhs.name}, output);
+        operation(fn, decoded_op->lhs.name, safe_encode_constant(decoded_op->op_lhs.name),
+                  op->op, safe_encode_constant(decoded_op->op_rhs.name));
+        encode_vars({decoded_op->lhs.name}, fn);
       }
       else if (shared_ptr<LA::Return> ret = dynamic_pointer_cast<LA::Return>(i))
       {
-        output << "return" << endl;
+        add_instruction(fn, make_shared<IR::Return>());
       }
       else if (shared_ptr<LA::Declaration> dec = dynamic_pointer_cast<LA::Declaration>(i))
       {
         // TODO add the type to the function
-        add_declaration(f, dec, output);
-        allocate_to_zero(f, dec, output);
-        output << dec->type.type_string << " " << dec->var.name << endl;
+        add_declaration(f, dec);
+        allocate_to_zero(fn, dec);
+        add_instruction(fn, IR_declaration(dec));
       }
       else if (shared_ptr<LA::ReturnValue> retv = dynamic_pointer_cast<LA::ReturnValue>(i))
       {
-        output << "return " << safe_encode_constant(retv->value.name) << endl;
+        shared_ptr<IR::ReturnValue> ret = make_shared<IR::ReturnValue>();
+        ret->value.name = IR_name(safe_encode_constant(retv->value.name));
+        add_instruction(fn, ret);
       }
       else if (shared_ptr<LA::Label> label = dynamic_pointer_cast<LA::Label>(i))
       {
-        output << label->label.name << endl;
+        ::label(fn, label->label.name);
       }
       else if (shared_ptr<LA::Branch> branch = dynamic_pointer_cast<LA::Branch>(i))
       {
-        output << "br " << branch->dest.name << endl;
+        ::branch(fn, branch->dest.name);
       }
       else if (shared_ptr<LA::CBranch> cbranch = dynamic_pointer_cast<LA::CBranch>(i))
       {
         vector<LA::LA_item> vars_to_decode = cbranch->toDecode();
-        vector<string> replacements = decode_vars(f, vars_to_decode, output);
+        vector<string> replacements = decode_vars(f, vars_to_decode, fn);
         shared_ptr<LA::CBranch> decoded_cbranch = cbranch->decode(replacements);
-        output << "br " << safe_encode_constant(decoded_cbranch->condition.name);
-        output << " " << decoded_cbranch->then_dest.name << " " << decoded_cbranch->else_dest.name << endl;
+        ::branch(fn, safe_encode_constant(decoded_cbranch->condition.name),
+                 decoded_cbranch->then_dest.name, decoded_cbranch->else_dest.name);
       }
       else if (shared_ptr<LA::Call> call = dynamic_pointer_cast<LA::Call>(i))
       {
-        auto data_iter = f->data_structs.find(call->callee.name);
-        bool is_code = false;
-        if (data_iter != f->data_structs.end())
-          if (data_iter->second->type.data_type == LA::code)
-            is_code = true;
-        if (call->callee.name[0] == '%' && !is_code)
-          call->callee.name.erase(0,1);
-        if (call->callee.name != "array-error" && call->callee.name != "print" && !is_code)
-          call->callee.name = ':' + call->callee.name;
-        output << "call " << call->callee.name << "(";
-        for (int arg_i = 0; arg_i < call->args.size(); arg_i++) {
-          output << safe_encode_constant(call->args[arg_i].name);
-          if (arg_i < call->args.size() - 1)
-            output << ", ";
-        }
-        output << ")\n";
+        ::call(fn, "", IR_callee(f, call->callee.name), encoded_args(call->args));
       }
       else if (shared_ptr<LA::CallAssign> call = dynamic_pointer_cast<LA::CallAssign>(i))
       {
-        auto data_iter = f->data_structs.find(call->callee.name);
-        bool is_code = false;
-        if (data_iter != f->data_structs.end())
-          if (data_iter->second->type.data_type == LA::code)
-            is_code = true;
-        output << call->lhs.name << " <- ";
-        if (call->callee.name[0] == '%' && !is_code)
-          call->callee.name.erase(0,1);
-        if (call->callee.name != "array-error" && call->callee.name != "print" && !is_code)
-          call->callee.name = ':' + call->callee.name;
-        output << "call " << call->callee.name << "(";
-        for (int arg_i = 0; arg_i < call->args.size(); arg_i++) {
-          output << safe_encode_constant(call->args[arg_i].name);
-          if (arg_i < call->args.size() - 1)
-            output << ", ";
-        }
-        output << ")\n";
+        ::call(fn, call->lhs.name, IR_callee(f, call->callee.name), encoded_args(call->args));
       }
       else if (shared_ptr<LA::TupleAllocate> alloc = dynamic_pointer_cast<LA::TupleAllocate>(i))
       {
-        output << alloc->lhs.name << " <- new Tuple(" << safe_encode_constant(alloc->dimension.name) << ")\n";
+        shared_ptr<IR::TupleAllocate> ir_alloc = make_shared<IR::TupleAllocate>();
+        ir_alloc->lhs.name = IR_name(alloc->lhs.name);
+        ir_alloc->dimension.name = IR_name(safe_encode_constant(alloc->dimension.name));
+        add_instruction(fn, ir_alloc);
       }
       else if (shared_ptr<LA::ArrayAllocate> alloc = dynamic_pointer_cast<LA::ArrayAllocate>(i))
       {
-        output << alloc->lhs.name << " <- " << "new Array(";
-        for (int i = 0; i < alloc->dimensions.size(); i++) {
-          output << safe_encode_constant(alloc->dimensions.at(i).name);
-          if (i < alloc->dimensions.size() - 1)
-            output << ", ";
+        shared_ptr<IR::ArrayAllocate> ir_alloc = make_shared<IR::ArrayAllocate>();
+        ir_alloc->lhs.name = IR_name(alloc->lhs.name);
+        for (auto dimension : encoded_args(alloc->dimensions)) {
+          IR::IR_t ir_dimension;
+          ir_dimension.name = IR_name(dimension);
+          ir_alloc->dimensions.push_back(ir_dimension);
         }
-        output << ")\n";
-
+        add_instruction(fn, ir_alloc);
       }
       else if (shared_ptr<LA::IndexWrite> write = dynamic_pointer_cast<LA::IndexWrite>(i))
       {
@@ -262,11 +398,13 @@ void Compiler::Compile(LA::Program p) {
         string op_hash = get_hash();
         string abort = ":abort" + op_hash;
         string success = ":success" + op_hash;
-        output << isAllocated << " <- " << write->lhs.name << " = 0\n";
-        output << "br " << isAllocated << " " << abort << " " << success << endl;
-        output << abort << endl << "call array-error(0, 0)" << endl << success << endl;
+        operation(fn, isAllocated, write->lhs.name, LA::eq, "0");
+        ::branch(fn, isAllocated, abort, success);
+        ::label(fn, abort);
+        ::call(fn, "", "array-error", {"0", "0"});
+        ::label(fn, success);
         vector<LA::LA_item> vars_to_decode = write->toDecode();
-        vector<string> replacements = decode_vars(f, vars_to_decode, output);
+        vector<string> replacements = decode_vars(f, vars_to_decode, fn);
         shared_ptr<LA::IndexWrite> decoded_write = write->decode(replacements);
         if (isArray) {
           // checking indexing
@@ -275,29 +413,28 @@ void Compiler::Compile(LA::Program p) {
           string len_var;
           string encoded_index;
           for (int index_i = 0; index_i < write->indices.size(); index_i++) {
-            output << "; checking index " << write->indices.at(index_i).name << endl;
             // make vars
             out_of_bounds = ":out_of_bounds_" + to_string(index_i) + op_hash;
             success = ":success_" + to_string(index_i) + op_hash;
             encoded_index = "%encoded_idx_cmplr" + op_hash;
             // fetch the length of the dimension (as encoded) into len_var
             len_var = "%len_var_cmplr" + op_hash;
-            output << len_var << " <- length " << write->lhs.name << " " << index_i << endl;
+            length(fn, len_var, write->lhs.name, to_string(index_i));
             // encode the value of the index we're using
-            output << encoded_index << " <- " << safe_encode_constant(write->indices.at(index_i).name) << endl;
+            assign(fn, encoded_index, safe_encode_constant(write->indices.at(index_i).name));
             // compare the length of the dimension to the index
-            output << len_var << " <- " << encoded_index << " < " << len_var << endl;
-            output << "br " << len_var << " " << success << " " << out_of_bounds << endl;
-            output << out_of_bounds << "\ncall array-error(" << write->lhs.name << ", " << encoded_index << ")\n";
-            output << success << endl;
+            operation(fn, len_var, encoded_index, LA::lt, len_var);
+            ::branch(fn, len_var, success, out_of_bounds);
+            ::label(fn, out_of_bounds);
+            ::call(fn, "", "array-error", {write->lhs.name, encoded_index});
+            ::label(fn, success);
           }
         }
-        output << decoded_write->lhs.name;
-        for (int index_i = 0; index_i < decoded_write->indices.size(); index_i++) {
-          output << "[" << decoded_write->indices.at(index_i).name << "]";
-        }
-        output << " <- " << safe_encode_constant(decoded_write->rhs.name);
-        output << endl;
+        shared_ptr<IR::IndexWrite> ir_write = make_shared<IR::IndexWrite>();
+        ir_write->lhs.name = IR_name(decoded_write->lhs.name);
+        ir_write->indices = IR_indices(decoded_write->indices);
+        ir_write->rhs.name = IR_name(safe_encode_constant(decoded_write->rhs.name));
+        add_instruction(fn, ir_write);
       }
       else if (shared_ptr<LA::IndexRead> read = dynamic_pointer_cast<LA::IndexRead>(i))
       {
@@ -310,9 +447,11 @@ void Compiler::Compile(LA::Program p) {
         string op_hash = get_hash();
         string abort = ":abort" + op_hash;
         string success = ":success" + op_hash;
-        output << isAllocated << " <- " << read->rhs.name << " = 0\n";
-        output << "br " << isAllocated << " " << abort << " " << success << endl;
-        output << abort << endl << "call array-error(0, 0)" << endl << success << endl;
+        operation(fn, isAllocated, read->rhs.name, LA::eq, "0");
+        ::branch(fn, isAllocated, abort, success);
+        ::label(fn, abort);
+        ::call(fn, "", "array-error", {"0", "0"});
+        ::label(fn, success);
         if (isArray) {
           // checking indexing
           string out_of_bounds;
@@ -325,24 +464,25 @@ void Compiler::Compile(LA::Program p) {
             encoded_index = "%encoded_idx_cmplr" + op_hash;
             // fetch the length of the dimension (as encoded) into len_var
             len_var = "%len_var_cmplr" + op_hash;
-            output << len_var << " <- length " << read->rhs.name << " " << index_i << endl;
+            length(fn, len_var, read->rhs.name, to_string(index_i));
             // encode the value of the index we're using
-            output << encoded_index << " <- " << safe_encode_constant(read->indices.at(index_i).name) << endl;
+            assign(fn, encoded_index, safe_encode_constant(read->indices.at(index_i).name));
             // compare the length of the dimension to the index
-            output << len_var << " <- " << encoded_index << " < " << len_var << endl;
-            output << "br " << len_var << " " << success << " " << out_of_bounds << endl;
-            output << out_of_bounds << "\ncall array-error(" << read->rhs.name << ", " << encoded_index << ")\n";
-            output << success << endl;
+            operation(fn, len_var, encoded_index, LA::lt, len_var);
+            ::branch(fn, len_var, success, out_of_bounds);
+            ::label(fn, out_of_bounds);
+            ::call(fn, "", "array-error", {read->rhs.name, encoded_index});
+            ::label(fn, success);
           }
         }
         vector<LA::LA_item> vars_to_decode = read->toDecode();
-        vector<string> replacements = decode_vars(f, vars_to_decode, output);
+        vector<string> replacements = decode_vars(f, vars_to_decode, fn);
         shared_ptr<LA::IndexRead> decoded_read = read->decode(replacements);
-        output << decoded_read->lhs.name << " <- " << decoded_read->rhs.name;
-        for (int index_i = 0; index_i < decoded_read->indices.size(); index_i++) {
-          output << "[" << decoded_read->indices.at(index_i).name << "]";
-        }
-        output << endl;
+        shared_ptr<IR::IndexRead> ir_read = make_shared<IR::IndexRead>();
+        ir_read->lhs.name = IR_name(decoded_read->lhs.name);
+        ir_read->rhs.name = IR_name(decoded_read->rhs.name);
+        ir_read->indices = IR_indices(decoded_read->indices);
+        add_instruction(fn, ir_read);
       }
       else if (shared_ptr<LA::LengthRead> lr = dynamic_pointer_cast<LA::LengthRead>(i))
       {
@@ -355,14 +495,13 @@ void Compiler::Compile(LA::Program p) {
         //output << "br " << isAllocated << " " << success << " " << abort << endl;
         //output << abort << endl << "call array-error(0, 0)" << endl << success << endl;
         vector<LA::LA_item> vars_to_decode = lr->toDecode();
-        vector<string> replacements = decode_vars(f, vars_to_decode, output);
+        vector<string> replacements = decode_vars(f, vars_to_decode, fn);
         shared_ptr<LA::LengthRead> decoded_lr = lr->decode(replacements);
-        output << decoded_lr->lhs.name << " <- length " << decoded_lr->rhs.name << " " << decoded_lr->index.name << endl;
+        length(fn, decoded_lr->lhs.name, decoded_lr->rhs.name, decoded_lr->index.name);
       }
     }
-    output << "}\n";
   }
-  return;
+  return ir;
 };
 
 LA::Program Compiler::Block(LA::Program p) {
@@ -401,3 +540,120 @@ LA::Program Compiler::Block(LA::Program p) {
   }
   return newP;
 };
+
+string IR_source(IR::Type type) {
+  switch (type.dec_type) {
+    case IR::array: {
+      string brackets;
+      for (int d = 0; d < type.array_dim; d++)
+        brackets += "[]";
+      return "int64" + brackets;
+    }
+    case IR::tuple:
+      return "tuple";
+    case IR::code:
+      return "code";
+    case IR::IRvoid:
+      return "void";
+    default:
+      return "int64";
+  }
+};
+
+/*
+ * An item as written in IR source, where variables start with %.
+ */
+string IR_source(const IR::IR_item &item) {
+  if (item.name[0] == ':' || item.name[0] == '-' || isdigit(item.name[0]))
+    return item.name;
+  return "%" + item.name;
+};
+
+string IR_source(const vector<IR::IR_t> &items, string separator) {
+  string source;
+  for (int item_i = 0; item_i < items.size(); item_i++) {
+    source += IR_source(items[item_i]);
+    if (item_i < items.size() - 1)
+      source += separator;
+  }
+  return source;
+};
+
+string IR_source(IR::Operator op) {
+  switch(op) {
+    case IR::plus:
+      return "+";
+    case IR::minus:
+      return "-";
+    case IR::times:
+      return "*";
+    case IR::l3and:
+      return "&";
+    case IR::lshift:
+      return "<<";
+    case IR::rshift:
+      return ">>";
+    case IR::lt:
+      return "<";
+    case IR::lte:
+      return "<=";
+    case IR::eq:
+      return "=";
+    case IR::gt:
+      return ">";
+    case IR::gte:
+      return ">=";
+  }
+  return "";
+};
+
+/*
+ * Writes p out as IR source.
+ */
+void dump_program(const IR::Program &p, ostream &output) {
+  for (auto fn : p.functions) {
+    output << "define " << IR_source(fn->return_type) << " " << fn->name << "(";
+    for (int var_i = 0; var_i < fn->vars.size(); var_i++) {
+      output << IR_source(fn->vars[var_i]->type) << " " << IR_source(fn->vars[var_i]->var);
+      if (var_i < fn->vars.size() - 1)
+        output << ", ";
+    }
+    output << "){\n";
+    for (auto bb : fn->blocks) {
+      output << bb->entry_point.name << "\n";
+      for (auto i : bb->instructions) {
+        if (shared_ptr<IR::Assignment> assn = dynamic_pointer_cast<IR::Assignment>(i))
+          output << IR_source(assn->lhs) << " <- " << IR_source(assn->rhs) << "\n";
+        else if (shared_ptr<IR::Operation> op = dynamic_pointer_cast<IR::Operation>(i))
+          output << IR_source(op->lhs) << " <- " << IR_source(op->op_lhs) << " " << IR_source(op->op) << " " << IR_source(op->op_rhs) << "\n";
+        else if (shared_ptr<IR::Declaration> dec = dynamic_pointer_cast<IR::Declaration>(i))
+          output << IR_source(dec->type) << " " << IR_source(dec->var) << "\n";
+        else if (shared_ptr<IR::Label> label = dynamic_pointer_cast<IR::Label>(i))
+          output << label->label.name << "\n";
+        else if (shared_ptr<IR::Branch> branch = dynamic_pointer_cast<IR::Branch>(i))
+          output << "br " << branch->dest.name << "\n";
+        else if (shared_ptr<IR::CBranch> cbranch = dynamic_pointer_cast<IR::CBranch>(i))
+          output << "br " << IR_source(cbranch->condition) << " " << cbranch->then_dest.name << " " << cbranch->else_dest.name << "\n";
+        else if (shared_ptr<IR::ReturnValue> retv = dynamic_pointer_cast<IR::ReturnValue>(i))
+          output << "return " << IR_source(retv->value) << "\n";
+        else if (shared_ptr<IR::Return> ret = dynamic_pointer_cast<IR::Return>(i))
+          output << "return\n";
+        else if (shared_ptr<IR::Call> call = dynamic_pointer_cast<IR::Call>(i))
+          output << "call " << call->callee.name << "(" << IR_source(call->args, ", ") << ")\n";
+        else if (shared_ptr<IR::CallAssign> call = dynamic_pointer_cast<IR::CallAssign>(i))
+          output << IR_source(call->lhs) << " <- call " << call->callee.name << "(" << IR_source(call->args, ", ") << ")\n";
+        else if (shared_ptr<IR::TupleAllocate> alloc = dynamic_pointer_cast<IR::TupleAllocate>(i))
+          output << IR_source(alloc->lhs) << " <- new Tuple(" << IR_source(alloc->dimension) << ")\n";
+        else if (shared_ptr<IR::ArrayAllocate> alloc = dynamic_pointer_cast<IR::ArrayAllocate>(i))
+          output << IR_source(alloc->lhs) << " <- new Array(" << IR_source(alloc->dimensions, ", ") << ")\n";
+        else if (shared_ptr<IR::IndexWrite> write = dynamic_pointer_cast<IR::IndexWrite>(i))
+          output << IR_source(write->lhs) << "[" << IR_source(write->indices, "][") << "] <- " << IR_source(write->rhs) << "\n";
+        else if (shared_ptr<IR::IndexRead> read = dynamic_pointer_cast<IR::IndexRead>(i))
+          output << IR_source(read->lhs) << " <- " << IR_source(read->rhs) << "[" << IR_source(read->indices, "][") << "]\n";
+        else if (shared_ptr<IR::LengthRead> lr = dynamic_pointer_cast<IR::LengthRead>(i))
+          output << IR_source(lr->lhs) << " <- length " << IR_source(lr->rhs) << " " << IR_source(lr->index) << "\n";
+      }
+    }
+    output << "}\n";
+  }
+};
@@ -1,6 +1,11 @@
+#include <ostream>
+
 #include "LA.h"
+#include "../../IR/src/IR.h"
 
 namespace Compiler {
-  void Compile(LA::Program p);
+  IR::Program Compile(LA::Program p);
   LA::Program Block(LA::Program p);
 };
+
+void dump_program(const IR::Program &p, std::ostream &output);
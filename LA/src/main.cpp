@@ -17,6 +17,7 @@
 // my stuff
 #include "parser.h"
 #include "compiler.h"
+#include "emitter.h"
 
 using namespace std;
 
@@ -47,7 +48,9 @@ int main( int argc, char **argv ){
   // block it
   p = Compiler::Block(p);
   // compile and dump it to the outfile
-  Compiler::Compile(p);
+  IR::Program compiled = Compiler::Compile(p);
+  Emitter output("prog.IR");
+  dump_program(compiled, output);
 
   return 0;
 }
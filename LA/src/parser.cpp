@@ -471,73 +471,76 @@ namespace LA {
       entry_point_rule
     > {};
 
-  /////////////
-  //   DATA  //
-  /////////////
-
-  vector<LA::Function *> parsed_functions;
-  vector<shared_ptr<LA::Variable>> parsed_variables;
-  vector<LA::LA_s> parsed_s_vals;
-  vector<LA::LA_t> parsed_t_vals;
-  vector<LA::LA_t> parsed_indices;
-  vector<LA::LA_u> parsed_u_vals;
-  vector<LA::LA_t> parsed_args;
-  vector<LA::Variable> parsed_vars;
-  vector<shared_ptr<LA::Declaration>> parsed_declarations;
-  LA_callee parsed_callee;
-  vector<std::string> parsed_strings;
-  vector<std::string> parsed_labels;
-  vector<std::string> parsed_names;
-  int64_t parsed_array_declaration_dimension = -1;
-  Operator parsed_op;
-  Type parsed_type;
-  LA_item parsed_T;
+  /*
+   * What a parse has read but not yet put into the program. Every
+   * parse gets its own, passed to the actions, so several parses
+   * can run at once.
+   */
+  struct ParseState {
+    vector<LA::Function *> parsed_functions;
+    vector<shared_ptr<LA::Variable>> parsed_variables;
+    vector<LA::LA_s> parsed_s_vals;
+    vector<LA::LA_t> parsed_t_vals;
+    vector<LA::LA_t> parsed_indices;
+    vector<LA::LA_u> parsed_u_vals;
+    vector<LA::LA_t> parsed_args;
+    vector<LA::Variable> parsed_vars;
+    vector<shared_ptr<LA::Declaration>> parsed_declarations;
+    LA_callee parsed_callee;
+    vector<std::string> parsed_strings;
+    vector<std::string> parsed_labels;
+    vector<std::string> parsed_names;
+    int64_t parsed_array_declaration_dimension = -1;
+    Operator parsed_op;
+    Type parsed_type;
+    LA_item parsed_T;
+
+    void add_instruction(LA::Program &p, shared_ptr<LA::Instruction> i) {
+      p.functions.back()->instructions.push_back(i);
+    };
+
+    void clear_memory() {
+      parsed_variables.clear();
+      parsed_s_vals.clear();
+      parsed_t_vals.clear();
+      parsed_u_vals.clear();
+      parsed_strings.clear();
+      parsed_args.clear();
+      parsed_indices.clear();
+      parsed_array_declaration_dimension = -1;
+      parsed_declarations.clear();
+    }
+  };
 
   /////////////
   // ACTIONS //
   /////////////
-
-  void add_instruction(LA::Program &p, shared_ptr<LA::Instruction> i) {
-    p.functions.back()->instructions.push_back(i);
-  };
-
-  void clear_memory() {
-    parsed_variables.clear();
-    parsed_s_vals.clear();
-    parsed_t_vals.clear();
-    parsed_u_vals.clear();
-    parsed_strings.clear();
-    parsed_args.clear();
-    parsed_indices.clear();
-    parsed_array_declaration_dimension = -1;
-    parsed_declarations.clear();
-  }
-
+  
   template< typename Rule >
     struct action : pegtl::nothing< Rule > {};
 
   template<> struct action < LA_name_rule >{
-    static void apply( const pegtl::input &in, LA::Program &p){
-      parsed_names.push_back(in.string());
+    static void apply( const pegtl::input &in, LA::Program &p, ParseState &state){
+      state.parsed_names.push_back(in.string());
     }
   };
 
   template<> struct action < LA_label_rule >{
-    static void apply( const pegtl::input &in, LA::Program &p){
-      parsed_labels.push_back(in.string());
+    static void apply( const pegtl::input &in, LA::Program &p, ParseState &state){
+      state.parsed_labels.push_back(in.string());
     }
   };
 
   template<> struct action < LA_var_rule >{
-    static void apply( const pegtl::input &in, LA::Program &p){
+    static void apply( const pegtl::input &in, LA::Program &p, ParseState &state){
       shared_ptr<LA::Variable> var = make_shared<LA::Variable>();
-      var->name = '%' + parsed_names.back();
-      parsed_variables.push_back(var);
+      var->name = '%' + state.parsed_names.back();
+      state.parsed_variables.push_back(var);
     }
   };
 
   template<> struct action < LA_op_rule >{
-    static void apply( const pegtl::input &in, LA::Program &p){
+    static void apply( const pegtl::input &in, LA::Program &p, ParseState &state){
       std::string op = in.string();
       std::string plus ("+");
       std::string minus ("-");
@@ -551,358 +554,371 @@ namespace LA {
       std::string gte (">=");
       std::string gt (">");
       if (op.compare(plus) == 0)
-        parsed_op = LA::plus;
+        state.parsed_op = LA::plus;
       else if (op.compare(minus) == 0)
-        parsed_op = LA::minus;
+        state.parsed_op = LA::minus;
       else if (op.compare(times) == 0)
-        parsed_op = LA::times;
+        state.parsed_op = LA::times;
       else if (op.compare(l3and) == 0)
-        parsed_op = LA::l3and;
+        state.parsed_op = LA::l3and;
       else if (op.compare(lshift) == 0)
-        parsed_op = LA::lshift;
+        state.parsed_op = LA::lshift;
       else if (op.compare(rshift) == 0)
-        parsed_op = LA::rshift;
+        state.parsed_op = LA::rshift;
       else if (op.compare(lt) == 0)
-        parsed_op = LA::lt;
+        state.parsed_op = LA::lt;
       else if (op.compare(lte) == 0)
-        parsed_op = LA::lte;
+        state.parsed_op = LA::lte;
       else if (op.compare(eq) == 0)
-        parsed_op = LA::eq;
+        state.parsed_op = LA::eq;
       else if (op.compare(gte) == 0)
-        parsed_op = LA::gte;
+        state.parsed_op = LA::gte;
       else if (op.compare(gt) == 0)
-        parsed_op = LA::gt;
+        state.parsed_op = LA::gt;
     }
   };
 
   template<> struct action < LA_u_rule >{
-    static void apply( const pegtl::input &in, LA::Program &p){
+    static void apply( const pegtl::input &in, LA::Program &p, ParseState &state){
       LA::LA_u u;
       u.name = in.string();
-      parsed_u_vals.push_back(u);
+      state.parsed_u_vals.push_back(u);
     }
   };
 
   template<> struct action < LA_t_rule >{
-    static void apply( const pegtl::input &in, LA::Program &p){
+    static void apply( const pegtl::input &in, LA::Program &p, ParseState &state){
       LA::LA_t t;
       t.name = in.string();
-      parsed_t_vals.push_back(t);
+      state.parsed_t_vals.push_back(t);
     }
   };
 
   template<> struct action < LA_s_rule >{
-    static void apply( const pegtl::input &in, LA::Program &p){
+    static void apply( const pegtl::input &in, LA::Program &p, ParseState &state){
       LA::LA_s s;
       s.name = in.string();
-      parsed_s_vals.push_back(s);
+      state.parsed_s_vals.push_back(s);
     }
   };
 
   template<> struct action < LA_args_rule >{
-    static void apply( const pegtl::input &in, LA::Program &p){
+    static void apply( const pegtl::input &in, LA::Program &p, ParseState &state){
       // args are a property of a function call.
-      parsed_args.insert(
-          parsed_args.end(),
-          parsed_t_vals.begin(),
-          parsed_t_vals.end()
+      state.parsed_args.insert(
+          state.parsed_args.end(),
+          state.parsed_t_vals.begin(),
+          state.parsed_t_vals.end()
       );
     }
   };
 
   template<> struct action < LA_vars_rule >{
-    static void apply( const pegtl::input &in, LA::Program &p){
+    static void apply( const pegtl::input &in, LA::Program &p, ParseState &state){
       // vars are a property of a function itself.
       // TODO
 
-      //clear_memory();
+      //state.clear_memory();
     }
   };
 
   template<> struct action < LA_callee_rule >{
-    static void apply( const pegtl::input &in, LA::Program &p){
+    static void apply( const pegtl::input &in, LA::Program &p, ParseState &state){
       LA::LA_callee callee;
       callee.name = in.string();
-      parsed_callee = callee;
+      state.parsed_callee = callee;
     }
   };
 
   template<> struct action < LA_T_rule >{
-    static void apply( const pegtl::input &in, LA::Program &p){
-      parsed_T.name = in.string();
+    static void apply( const pegtl::input &in, LA::Program &p, ParseState &state){
+      state.parsed_T.name = in.string();
     }
   };
 
   template<> struct action < LA_brackets_rule >{
-    static void apply( const pegtl::input &in, LA::Program &p){
-      parsed_array_declaration_dimension = in.string().size() / 2;
+    static void apply( const pegtl::input &in, LA::Program &p, ParseState &state){
+      state.parsed_array_declaration_dimension = in.string().size() / 2;
     }
   };
 
   template<> struct action < LA_type_rule >{
-    static void apply( const pegtl::input &in, LA::Program &p){
+    static void apply( const pegtl::input &in, LA::Program &p, ParseState &state){
       std::string type = in.string();
       std::string int_type = "int64";
       std::string tuple_type = "tuple";
       std::string code_type = "code";
-      parsed_type.type_string = type;
+      state.parsed_type.type_string = type;
       if (int_type.compare(type.substr(0, 5)) == 0) {
-        if (parsed_array_declaration_dimension > 0) {
-          parsed_type.data_type = LA::array;
-          parsed_type.array_dim = parsed_array_declaration_dimension;
+        if (state.parsed_array_declaration_dimension > 0) {
+          state.parsed_type.data_type = LA::array;
+          state.parsed_type.array_dim = state.parsed_array_declaration_dimension;
         } else {
-          parsed_type.data_type = LA::integer;
+          state.parsed_type.data_type = LA::integer;
         }
       } else if (tuple_type.compare(type) == 0) {
-        parsed_type.data_type = LA::tuple;
+        state.parsed_type.data_type = LA::tuple;
       } else if (code_type.compare(type) == 0) {
-        parsed_type.data_type = LA::code;
+        state.parsed_type.data_type = LA::code;
       }
     }
   };
 
   template<> struct action < LA_declaration_rule >{
-    static void apply( const pegtl::input &in, LA::Program &p){
+    static void apply( const pegtl::input &in, LA::Program &p, ParseState &state){
       shared_ptr<LA::Declaration> dec = make_shared<LA::Declaration>();
-      dec->type = parsed_type;
-      dec->var = *parsed_variables.back();
-      parsed_declarations.push_back(dec);
+      dec->type = state.parsed_type;
+      dec->var = *state.parsed_variables.back();
+      state.parsed_declarations.push_back(dec);
     }
   };
 
   template<> struct action < LA_declarations_rule >{
-    static void apply( const pegtl::input &in, LA::Program &p){
+    static void apply( const pegtl::input &in, LA::Program &p, ParseState &state){
       p.functions.back()->vars.insert(
         p.functions.back()->vars.end(),
-        parsed_declarations.begin(),
-        parsed_declarations.end()
+        state.parsed_declarations.begin(),
+        state.parsed_declarations.end()
       );
-      clear_memory();
+      state.clear_memory();
     }
   };
 
   template<> struct action < LA_declaration_instruction_rule >{
-    static void apply( const pegtl::input &in, LA::Program &p){
+    static void apply( const pegtl::input &in, LA::Program &p, ParseState &state){
       shared_ptr<LA::Declaration> dec = make_shared<LA::Declaration>();
-      dec->type = parsed_type;
-      dec->var = *parsed_variables.at(0);
-      add_instruction(p, dec);
-      clear_memory();
+      dec->type = state.parsed_type;
+      dec->var = *state.parsed_variables.at(0);
+      state.add_instruction(p, dec);
+      state.clear_memory();
     }
   };
 
   template<> struct action < LA_assignment_rule >{
-    static void apply( const pegtl::input &in, LA::Program &p){
-      LA::Variable lhs = *parsed_variables.at(0);
-      LA::LA_s rhs = parsed_s_vals.back();
+    static void apply( const pegtl::input &in, LA::Program &p, ParseState &state){
+      LA::Variable lhs = *state.parsed_variables.at(0);
+      LA::LA_s rhs = state.parsed_s_vals.back();
       shared_ptr<LA::Assignment> assignment = make_shared<LA::Assignment>();
       assignment->lhs = lhs;
       assignment->rhs = rhs;
-      add_instruction(p, assignment);
-      clear_memory();
+      state.add_instruction(p, assignment);
+      state.clear_memory();
     }
   };
 
   template<> struct action < LA_operation_rule >{
-    static void apply( const pegtl::input &in, LA::Program &p){
-      LA::Variable lhs = *parsed_variables.at(0);
+    static void apply( const pegtl::input &in, LA::Program &p, ParseState &state){
+      LA::Variable lhs = *state.parsed_variables.at(0);
       shared_ptr<LA::Operation> operation = make_shared<LA::Operation>();
       operation->lhs = lhs;
-      operation->op_lhs = parsed_t_vals.end()[-2];
-      operation->op_rhs = parsed_t_vals.end()[-1];
-      operation->op = parsed_op;
-      add_instruction(p, operation);
-      clear_memory();
+      operation->op_lhs = state.parsed_t_vals.end()[-2];
+      operation->op_rhs = state.parsed_t_vals.end()[-1];
+      operation->op = state.parsed_op;
+      state.add_instruction(p, operation);
+      state.clear_memory();
     }
   };
 
   template<> struct action < LA_branch_rule >{
-    static void apply( const pegtl::input &in, LA::Program &p){
+    static void apply( const pegtl::input &in, LA::Program &p, ParseState &state){
       shared_ptr<LA::Branch> branch = make_shared<LA::Branch>();
       LA::LA_item dest;
-      dest.name = parsed_labels.back();
+      dest.name = state.parsed_labels.back();
       branch->dest = dest;
-      add_instruction(p, branch);
-      clear_memory();
+      state.add_instruction(p, branch);
+      state.clear_memory();
     }
   };
 
   template<> struct action < LA_conditional_branch_rule >{
-    static void apply( const pegtl::input &in, LA::Program &p){
+    static void apply( const pegtl::input &in, LA::Program &p, ParseState &state){
       shared_ptr<LA::CBranch> cbranch = make_shared<LA::CBranch>();
       LA::LA_item then_dest;
-      then_dest.name = parsed_labels.end()[-2];
+      then_dest.name = state.parsed_labels.end()[-2];
       LA::LA_item else_dest;
-      else_dest.name = parsed_labels.end()[-1];
-      shared_ptr<LA::Variable> condition = parsed_variables.at(0);
+      else_dest.name = state.parsed_labels.end()[-1];
+      shared_ptr<LA::Variable> condition = state.parsed_variables.at(0);
       cbranch->condition = *condition;
       cbranch->then_dest = then_dest;
       cbranch->else_dest = else_dest;
-      add_instruction(p, cbranch);
-      clear_memory();
+      state.add_instruction(p, cbranch);
+      state.clear_memory();
     }
   };
 
   template<> struct action < LA_i_label_rule >{
-      static void apply( const pegtl::input &in, LA::Program &p){
+      static void apply( const pegtl::input &in, LA::Program &p, ParseState &state){
         shared_ptr<LA::Label> label = make_shared<LA::Label>();
         LA::LA_item lbl;
-        lbl.name = parsed_labels.back();
+        lbl.name = state.parsed_labels.back();
         label->label = lbl;
-        add_instruction(p, label);
-        clear_memory();
+        state.add_instruction(p, label);
+        state.clear_memory();
       }
   };
 
   template<> struct action < LA_call_rule >{
-    static void apply( const pegtl::input &in, LA::Program &p){
+    static void apply( const pegtl::input &in, LA::Program &p, ParseState &state){
       shared_ptr<LA::Call> call = make_shared<LA::Call>();
-      call->callee = parsed_callee;
+      call->callee = state.parsed_callee;
       call->args.insert(
           call->args.end(),
-          parsed_args.begin(),
-          parsed_args.end()
+          state.parsed_args.begin(),
+          state.parsed_args.end()
       );
-      add_instruction(p, call);
-      clear_memory();
+      state.add_instruction(p, call);
+      state.clear_memory();
     }
   };
 
   template<> struct action < LA_call_assign_rule >{
-    static void apply( const pegtl::input &in, LA::Program &p){
+    static void apply( const pegtl::input &in, LA::Program &p, ParseState &state){
       shared_ptr<LA::CallAssign> calla = make_shared<LA::CallAssign>();
-      calla->callee = parsed_callee;
+      calla->callee = state.parsed_callee;
       calla->args.insert(
           calla->args.end(),
-          parsed_args.begin(),
-          parsed_args.end()
+          state.parsed_args.begin(),
+          state.parsed_args.end()
       );
-      calla->lhs = *parsed_variables.at(0);
-      add_instruction(p, calla);
-      clear_memory();
+      calla->lhs = *state.parsed_variables.at(0);
+      state.add_instruction(p, calla);
+      state.clear_memory();
     }
   };
 
   template<> struct action < LA_array_allocate_rule >{
-    static void apply( const pegtl::input &in, LA::Program &p){
+    static void apply( const pegtl::input &in, LA::Program &p, ParseState &state){
       shared_ptr<LA::ArrayAllocate> alloc = make_shared<LA::ArrayAllocate>();
-      alloc->lhs = *parsed_variables.at(0);
+      alloc->lhs = *state.parsed_variables.at(0);
       alloc->dimensions.insert(
           alloc->dimensions.end(),
-          parsed_args.begin(),
-          parsed_args.end()
+          state.parsed_args.begin(),
+          state.parsed_args.end()
       );
-      add_instruction(p, alloc);
-      clear_memory();
+      state.add_instruction(p, alloc);
+      state.clear_memory();
     }
   };
 
   template<> struct action < LA_tuple_allocate_rule >{
-    static void apply( const pegtl::input &in, LA::Program &p){
+    static void apply( const pegtl::input &in, LA::Program &p, ParseState &state){
       shared_ptr<LA::TupleAllocate> alloc = make_shared<LA::TupleAllocate>();
-      alloc->lhs = *parsed_variables.at(0);
-      alloc->dimension = parsed_t_vals.back();
-      add_instruction(p, alloc);
-      clear_memory();
+      alloc->lhs = *state.parsed_variables.at(0);
+      alloc->dimension = state.parsed_t_vals.back();
+      state.add_instruction(p, alloc);
+      state.clear_memory();
     }
   };
 
   template<> struct action < LA_length_read_rule >{
-    static void apply( const pegtl::input &in, LA::Program &p){
+    static void apply( const pegtl::input &in, LA::Program &p, ParseState &state){
       shared_ptr<LA::LengthRead> lr = make_shared<LA::LengthRead>();
-      lr->lhs = *parsed_variables.at(0);
-      lr->rhs = *parsed_variables.back();
-      lr->index = parsed_t_vals.back();
-      add_instruction(p, lr);
-      clear_memory();
+      lr->lhs = *state.parsed_variables.at(0);
+      lr->rhs = *state.parsed_variables.back();
+      lr->index = state.parsed_t_vals.back();
+      state.add_instruction(p, lr);
+      state.clear_memory();
     }
   };
 
   template<> struct action < LA_indices_rule >{
-    static void apply( const pegtl::input &in, LA::Program &p){
-      parsed_indices.insert(
-        parsed_indices.end(),
-        parsed_t_vals.begin(),
-        parsed_t_vals.end()
+    static void apply( const pegtl::input &in, LA::Program &p, ParseState &state){
+      state.parsed_indices.insert(
+        state.parsed_indices.end(),
+        state.parsed_t_vals.begin(),
+        state.parsed_t_vals.end()
       );
     }
   };
 
   template<> struct action < LA_array_read_rule >{
-    static void apply( const pegtl::input &in, LA::Program &p){
+    static void apply( const pegtl::input &in, LA::Program &p, ParseState &state){
       shared_ptr<LA::IndexRead> read = make_shared<LA::IndexRead>();
-      read->lhs = *parsed_variables.at(0);
-      read->rhs = *parsed_variables.at(1);
+      read->lhs = *state.parsed_variables.at(0);
+      read->rhs = *state.parsed_variables.at(1);
       read->indices.insert(
         read->indices.end(),
-        parsed_indices.begin(),
-        parsed_indices.end()
+        state.parsed_indices.begin(),
+        state.parsed_indices.end()
       );
-      add_instruction(p, read);
-      clear_memory();
+      state.add_instruction(p, read);
+      state.clear_memory();
     }
   };
 
   template<> struct action < LA_array_write_rule >{
-    static void apply( const pegtl::input &in, LA::Program &p){
+    static void apply( const pegtl::input &in, LA::Program &p, ParseState &state){
       shared_ptr<LA::IndexWrite> write = make_shared<LA::IndexWrite>();
-      write->lhs = *parsed_variables.at(0);
-      write->rhs = parsed_s_vals.back();
+      write->lhs = *state.parsed_variables.at(0);
+      write->rhs = state.parsed_s_vals.back();
       write->indices.insert(
         write->indices.end(),
-        parsed_indices.begin(),
-        parsed_indices.end()
+        state.parsed_indices.begin(),
+        state.parsed_indices.end()
       );
-      add_instruction(p, write);
-      clear_memory();
+      state.add_instruction(p, write);
+      state.clear_memory();
     }
   };
 
   template<> struct action < LA_return_rule >{
-    static void apply( const pegtl::input &in, LA::Program &p){
+    static void apply( const pegtl::input &in, LA::Program &p, ParseState &state){
       shared_ptr<LA::Return> ret = make_shared<LA::Return>();
-      add_instruction(p, ret);
-      clear_memory();
+      state.add_instruction(p, ret);
+      state.clear_memory();
     }
   };
 
   template<> struct action < LA_returnvalue_rule >{
-    static void apply( const pegtl::input &in, LA::Program &p){
+    static void apply( const pegtl::input &in, LA::Program &p, ParseState &state){
       shared_ptr<LA::ReturnValue> ret = make_shared<LA::ReturnValue>();
-      LA::LA_t retvar = parsed_t_vals.back();
+      LA::LA_t retvar = state.parsed_t_vals.back();
       ret->value = retvar;
-      add_instruction(p, ret);
-      clear_memory();
+      state.add_instruction(p, ret);
+      state.clear_memory();
     }
   };
 
   template<> struct action < LA_function_name_rule >{
-      static void apply( const pegtl::input &in, LA::Program &p){
+      static void apply( const pegtl::input &in, LA::Program &p, ParseState &state){
         shared_ptr<LA::Function> fn = make_shared<LA::Function>();
-        fn->name = parsed_names.back();
-        if (parsed_T.name == "void") {
+        fn->name = state.parsed_names.back();
+        if (state.parsed_T.name == "void") {
           fn->return_type.data_type = LA::LAvoid;
         } else {
-          fn->return_type = parsed_type;
+          fn->return_type = state.parsed_type;
         }
         p.functions.push_back(fn);
-        clear_memory();
+        state.clear_memory();
       }
   };
 
 
+  /*
+   * Walks the grammar for rules that could loop without consuming
+   * input, which costs more than parsing a small program. Only
+   * builds made with CHECK_GRAMMAR=1 do it, once per process.
+   */
+  void check_grammar() {
+#ifdef CHECK_GRAMMAR
+    static size_t issues = pegtl::analyze< LA::grammar >();
+    (void)issues;
+#endif
+  }
+
   LA::Program LA_parse_file (char *fileName){
 
     /*
      * Check the grammar for some possible issues.
      */
-    pegtl::analyze< LA::grammar >();
+    check_grammar();
 
     /*
      * Parse.
      */
     LA::Program p;
-    pegtl::file_parser(fileName).parse< LA::grammar, LA::action >(p);
+    ParseState state;
+    pegtl::file_parser(fileName).parse< LA::grammar, LA::action >(p, state);
 
     return p;
   }
@@ -0,0 +1,40 @@
+#!/bin/bash
+
+# Times compiling each LA test to a.out, once through the LAc chain
+# of compilers and once through the driver. Tests that take longer
+# than $1 seconds (60 by default) either way are left out of the
+# totals.
+
+limit=${1:-60} ;
+
+# ms to compile $3 with the compiler $2 from the directory $1
+compile_time() {
+  pushd $1 > /dev/null ;
+  start=`date +%s%N` ;
+  timeout $limit ./$2 $3 > /dev/null 2>&1 ;
+  status=$? ;
+  end=`date +%s%N` ;
+  popd > /dev/null ;
+  if test $status -eq 124 ; then
+    echo "-" ;
+  else
+    echo $(( (end - start) / 1000000 )) ;
+  fi
+}
+
+chain_total=0 ;
+driver_total=0 ;
+for i in ../LA/tests/*.a ; do
+  chain=`compile_time ../LA LAc ../driver/$i` ;
+  driver=`compile_time . driverc $i` ;
+  echo "`basename $i`: LAc $chain ms, driver $driver ms" ;
+  if test "$chain" = "-" -o "$driver" = "-" ; then
+    continue ;
+  fi
+  let chain_total=$chain_total+$chain ;
+  let driver_total=$driver_total+$driver ;
+done
+
+echo "########## TOTAL" ;
+echo "LAc: $chain_total ms" ;
+echo "driver: $driver_total ms" ;
@@ -0,0 +1,8 @@
+#!/bin/bash
+
+# Parses every test of every language in one process, with 1, 2, 4
+# and 8 threads.
+
+for threads in 1 2 4 8 ; do
+  ./bin/driver -p $threads ../L1/tests/*.L1 ../L2/tests/*.L2 ../L3/tests/*.L3 ../IR/tests/*.IR ../LA/tests/*.a ;
+done
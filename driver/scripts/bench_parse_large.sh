@@ -0,0 +1,33 @@
+#!/bin/bash
+
+# Writes an L1 and an L2 program of $1 copies (40000 by default,
+# about 10 MB) of a block using most kinds of instruction, and
+# reports how fast the driver parses each.
+
+copies=${1:-40000} ;
+
+awk -v n=$copies 'BEGIN {
+  print "(:go\n(:go\n  0 1" ;
+  for (k = 0; k < n; k++) {
+    print "  (rdi <- 5)\n  (rax <- rdi)\n  (rax += 3)\n  (rsi <- (mem rsp 0))" ;
+    print "  ((mem rsp 0) <- rax)\n  (rdx <- rax < rdi)\n  (rax *= rdx)\n  (rax <<= rcx)" ;
+    print "  (r10 @ rax rdi 4)\n  (cjump rax <= 3 :then_" k " :else_" k ")" ;
+    print "  :then_" k "\n  (rcx <- :else_" k ")\n  :else_" k ;
+  }
+  print "  (return)\n)\n)" ;
+}' > large.L1 ;
+
+awk -v n=$copies 'BEGIN {
+  print "(:go\n(:go\n  0 0" ;
+  for (k = 0; k < n; k++) {
+    print "  (v" k " <- 5)\n  (w" k " <- v" k ")\n  (w" k " += 3)\n  (x" k " <- (mem rsp 0))" ;
+    print "  ((mem rsp 0) <- w" k ")\n  (y" k " <- w" k " < v" k ")\n  (w" k " *= y" k ")\n  (w" k " <<= rcx)" ;
+    print "  (cjump w" k " <= 3 :then_" k " :else_" k ")" ;
+    print "  :then_" k "\n  (rcx <- :else_" k ")\n  :else_" k ;
+  }
+  print "  (return)\n)\n)" ;
+}' > large.L2 ;
+
+./bin/driver -p 1 large.L1 ;
+./bin/driver -p 1 large.L2 ;
+rm -f large.L1 large.L2 ;
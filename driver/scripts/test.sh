@@ -0,0 +1,35 @@
+#!/bin/bash
+
+# Runs the LA tests through the driver instead of LAc.
+
+passed=0 ;
+failed=0 ;
+for i in ../LA/tests/*.a ; do
+
+  # Skip the tests without an expected output
+  if ! test -f ${i}.out ; then
+    continue ;
+  fi
+  echo $i ;
+
+  # With -r the driver runs the program itself
+  if test "$1" = "-r" ; then
+    ./bin/driver -r ${i} &> ${i}.out.tmp ;
+  else
+    rm -f a.out ;
+    ./driverc ${i} ;
+    ./a.out &> ${i}.out.tmp ;
+  fi
+  cmp ${i}.out.tmp ${i}.out ;
+  if ! test $? -eq 0 ; then
+    echo "  Failed" ;
+    let failed=$failed+1 ;
+  else
+    echo "  Passed" ;
+    let passed=$passed+1 ;
+  fi
+done
+let total=$passed+$failed ;
+
+echo "########## SUMMARY" ;
+echo "Test passed: $passed out of $total"
@@ -0,0 +1,257 @@
+#include <string>
+#include <map>
+#include <iostream>
+#include <sstream>
+#include <cstring>
+#include <cstdlib>
+#include <stdint.h>
+#include <unistd.h>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <fstream>
+
+// the stages
+#include "../../LA/src/parser.h"
+#include "../../LA/src/compiler.h"
+#include "../../IR/src/parser.h"
+#include "../../IR/src/compiler.h"
+#include "../../L3/src/parser.h"
+#include "../../L3/src/compiler.h"
+#include "../../L2/src/parser.h"
+#include "../../L2/src/compiler.h"
+#include "../../L1/src/parser.h"
+#include "../../L1/src/compiler.h"
+#include "../../L1/src/peephole.h"
+#include "../../L1/src/assembler.h"
+#include "../../L1/src/jit.h"
+#include "emitter.h"
+
+using namespace std;
+
+/*
+ * Compiles a program of any of the languages down to prog.S in one
+ * process. Every stage hands the Program it built straight to the
+ * next stage instead of through a prog.* file and another binary;
+ * -d writes those programs to prog.* anyway, for debugging, and -r
+ * runs the program in this process instead of writing prog.S.
+ *
+ * With -p THREADS it only parses every SOURCE given, that many at
+ * a time, and reports how long that took.
+ */
+
+enum Stage { LA_stage, IR_stage, L3_stage, L2_stage, L1_stage };
+
+const map<string, Stage> stages = {
+  {"a", LA_stage}, {"IR", IR_stage}, {"L3", L3_stage}, {"L2", L2_stage}, {"L1", L1_stage}
+};
+
+bool verbose = false;
+bool dump = false;
+bool run = false;
+int64_t parse_threads = 0;
+
+/*
+ * Called after each stage with the program it produced, which -d
+ * writes out as source.
+ */
+template <typename Program>
+void stage_done(string stage, string fileName, const Program &program, chrono::steady_clock::time_point start) {
+  if (verbose) {
+    auto ms = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start).count();
+    cerr << stage << ": " << ms << " ms\n";
+  }
+  if (dump) {
+    Emitter output(fileName);
+    dump_program(program, output);
+  }
+}
+
+/*
+ * Parses fileName as the language its extension says.
+ */
+void parse(Stage stage, char *fileName) {
+  switch (stage) {
+    case LA_stage:
+      LA::LA_parse_file(fileName);
+      break;
+    case IR_stage:
+      IR::IR_parse_file(fileName);
+      break;
+    case L3_stage:
+      L3::L3_parse_file(fileName);
+      break;
+    case L2_stage:
+      L2::L2_parse_file(fileName);
+      break;
+    case L1_stage:
+      L1::L1_parse_file(fileName);
+      break;
+  }
+}
+
+/*
+ * Parses the files, threads of them at once, and prints how long
+ * that took.
+ */
+int parse_batch(const vector<char *> &files, int64_t threads) {
+  vector<Stage> file_stages;
+  int64_t bytes = 0;
+  for (auto fileName : files) {
+    char *extension = strrchr(fileName, '.');
+    if (extension == NULL || !stages.count(extension + 1)) {
+      std::cerr << fileName << ": not an LA, IR, L3, L2 or L1 program" << std::endl;
+      return 1;
+    }
+    file_stages.push_back(stages.at(extension + 1));
+    ifstream file(fileName, ios::binary | ios::ate);
+    bytes += file.tellg();
+  }
+
+  auto start = chrono::steady_clock::now();
+  atomic<int64_t> next(0);
+  atomic<int64_t> failed(0);
+  vector<thread> pool;
+  for (int64_t t = 0; t < threads; t++) {
+    pool.push_back(thread([&]() {
+      for (int64_t k = next++; k < (int64_t)files.size(); k = next++) {
+        try {
+          parse(file_stages[k], files[k]);
+        } catch (const exception &e) {
+          cerr << e.what() << "\n";
+          failed++;
+        }
+      }
+    }));
+  }
+  for (auto &t : pool) {
+    t.join();
+  }
+  auto us = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count();
+
+  cout << files.size() << " files, " << bytes << " bytes, " << threads << " threads: "
+       << us / 1000 << " ms, " << (double)bytes / us << " MB/s\n";
+  return failed > 0;
+}
+
+int main( int argc, char **argv ){
+
+  /* Check the input.
+   */
+  if( argc < 2 ) {
+    std::cerr << "Usage: " << argv[ 0 ] << " SOURCE [-v] [-d] [-r] [-p THREADS]" << std::endl;
+    return 1;
+  }
+  int32_t opt;
+  while ((opt = getopt(argc, argv, "vdrp:")) != -1) {
+    switch (opt){
+      case 'v':
+        verbose = true;
+        break ;
+
+      case 'd':
+        dump = true;
+        break ;
+
+      case 'r':
+        run = true;
+        break ;
+
+      case 'p':
+        parse_threads = atoll(optarg);
+        break ;
+
+      default:
+        std::cerr << "Usage: " << argv[ 0 ] << "[-v] [-d] [-r] [-p THREADS] SOURCE..." << std::endl;
+        return 1;
+    }
+  }
+  if (optind >= argc) {
+    std::cerr << "Usage: " << argv[ 0 ] << "[-v] [-d] [-r] [-p THREADS] SOURCE..." << std::endl;
+    return 1;
+  }
+
+  if (parse_threads > 0) {
+    return parse_batch(vector<char *>(argv + optind, argv + argc), parse_threads);
+  }
+
+  // the language is the source's extension
+  char *fileName = argv[optind];
+  char *extension = strrchr(fileName, '.');
+  if (extension == NULL || !stages.count(extension + 1)) {
+    std::cerr << fileName << ": not an LA, IR, L3, L2 or L1 program" << std::endl;
+    return 1;
+  }
+  Stage first = stages.at(extension + 1);
+
+  // setting $ALLOCATION_PROFILE (to anything but 0) builds the
+  // program to report what every allocation site allocates
+  char *profile = getenv("ALLOCATION_PROFILE");
+  bool profile_allocations = (profile != NULL && strcmp(profile, "0") != 0);
+
+  // what each stage produced
+  IR::Program ir;
+  L3::Program l3;
+  L2::Program l2;
+  L1::Program l1;
+
+  if (first <= LA_stage) {
+    auto start = chrono::steady_clock::now();
+    LA::Program p = LA::LA_parse_file(fileName);
+    p = Compiler::Block(p);
+    ir = Compiler::Compile(p);
+    stage_done("LA", "prog.IR", ir, start);
+  }
+
+  if (first <= IR_stage) {
+    auto start = chrono::steady_clock::now();
+    IR::Program p = first == IR_stage ? IR::IR_parse_file(fileName) : ir;
+    l3 = Compiler::Compile(p, profile_allocations);
+    stage_done("IR", "prog.L3", l3, start);
+  }
+
+  if (first <= L3_stage) {
+    auto start = chrono::steady_clock::now();
+    L3::Program p = first == L3_stage ? L3::L3_parse_file(fileName) : l3;
+    l2 = compile_L3(p);
+    stage_done("L3", "prog.L2", l2, start);
+  }
+
+  if (first <= L2_stage) {
+    auto start = chrono::steady_clock::now();
+    L2::Program p = first == L2_stage ? L2::L2_parse_file(fileName) : l2;
+    l1 = compile_L2(p, false);
+    stage_done("L2", "prog.L1", l1, start);
+  }
+
+  auto start = chrono::steady_clock::now();
+  L1::Program p = first == L1_stage ? L1::L1_parse_file(fileName) : l1;
+  L1::ObjectCode code;
+  if (run) {
+    ostringstream output;
+    compile_L1(p, output);
+    code = L1::assemble(output.str());
+  } else {
+    Emitter outputFile("prog.S");
+    compile_L1(p, outputFile);
+    outputFile.close();
+  }
+  if (verbose) {
+    auto ms = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start).count();
+    cerr << "L1: " << ms << " ms\n";
+    cerr << "branches: " << emitted_branches << "\n";
+    for (auto hits : L1::peephole_hits) {
+      cerr << "peephole " << hits.first << ": " << hits.second << "\n";
+    }
+    for (auto hits : selection_hits) {
+      cerr << "selection " << hits.first << ": " << hits.second << "\n";
+    }
+  }
+
+  if (run) {
+    return L1::run(code);
+  }
+
+  return 0;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <fstream>
+#include <string>
+
+/*
+ * The file a compiler stage writes its program to. Everything
+ * written to it is collected in a 64K buffer and written out a
+ * buffer at a time, so write "\n" to it rather than std::endl,
+ * which flushes on every line.
+ */
+class Emitter : public std::ofstream {
+  public:
+    Emitter() {
+      rdbuf()->pubsetbuf(buffer, sizeof(buffer));
+    };
+
+    Emitter(const std::string &file_name) : Emitter() {
+      open(file_name);
+    };
+
+    ~Emitter() {
+      close();
+    };
+
+  private:
+    char buffer[1 << 16];
+};
@@ -7,13 +7,44 @@
  * For proper GC behavior, L1 programs 
  * should adhere to the following constraints:
  * 1. immediately before each call to allocate(),
- *    the callee-save registers ebx/edi/esi
- *    should contain either a pointer value, or
- *    a numeric value x ENCODED as 2*x+1 (no
- *    unencoded numeric values!)
+ *    the callee-save registers that are live
+ *    after it should contain either a pointer
+ *    value, or a numeric value x ENCODED as 2*x+1
+ *    (no unencoded numeric values!)
  * 2. similarly, immediately before a call to
- *    allocate(), the stack should not contain
- *    unencoded numeric values
+ *    allocate(), the stack slots that are live
+ *    should not contain unencoded numeric values
+ *
+ * The L1 compiler tells the collector which those
+ * are with a stack map for every return address
+ * (see stack_maps below).
+ *
+ * The heap starts out with $HEAP_SIZE words per semispace
+ * (DEFAULT_HEAP_SIZE if unset) and grows whenever too much
+ * of it survives a collection, up to $HEAP_MAX_SIZE words
+ * if that is set.
+ *
+ * Setting $GC_STATS (to anything but 0) prints a summary of
+ * the collections and allocations to stderr at exit.
+ *
+ * Setting $GC_THREADS to more than 1 collects with that many
+ * threads.
+ *
+ * New objects go in a nursery of $NURSERY_SIZE words
+ * (DEFAULT_NURSERY_SIZE if unset), and what survives a minor
+ * collection of it is promoted to the semispaces. The L1 compiler
+ * marks a card for every store into the heap (see the card table
+ * below), so minor collections only have to look at the stack and
+ * the dirty cards.
+ *
+ * The heaps are mmapped and only take up memory as they are used;
+ * the one copied out of is handed back after each collection.
+ * Setting $HEAP_HUGE_PAGES (to anything but 0) asks for transparent
+ * huge pages for semispaces of 2MB and up.
+ *
+ * Programs the IR compiler built with $ALLOCATION_PROFILE set print
+ * what each of their allocation sites allocated to stderr at exit
+ * (see alloc_sites below).
  *
  */
 #include <string.h>
@@ -21,56 +52,235 @@
 #include <stdio.h>
 #include <stdint.h>
 #include <inttypes.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#if defined(__SSE2__) || defined(__AVX__)
+#include <immintrin.h>
+#endif
 
-#define HEAP_SIZE 1048576    // one megabyte
-//#define HEAP_SIZE 200      // small heap size for testing
+#define DEFAULT_HEAP_SIZE 1048576  // in words, overridden by $HEAP_SIZE
+#define DEFAULT_NURSERY_SIZE 65536 // in words, overridden by $NURSERY_SIZE
+//#define DEFAULT_HEAP_SIZE 200    // small heap size for testing
+#define HEAP_GROWTH_FACTOR 2       // grow the heaps by this much at a time
+#define HEAP_MAX_SURVIVAL 50       // grow once more than this % survives a gc
 //#define GC_DEBUG           // uncomment this to enable GC debugging
 //#define GC_DUMP            // prints the entire heap before/after each gc
+#define GC_STATS_BUCKETS 64       // object size histogram, powers of two
+#define OUTPUT_BUFFER_SIZE 65536  // bytes of print() output kept before a write
+#define GC_MAX_THREADS 64         // upper bound for $GC_THREADS
+#define GC_LAB_WORDS 4096         // new heap handed to a gc thread at a time
+#define GC_LAB_MIN_WORDS 16       // LAB left over that is not worth keeping
+#define GC_BUSY -2                // size word of an object being copied
+#define LARGE_OBJECT_WORDS 32768  // arrays this big go in the large-object space
+#define HUGE_PAGE_SIZE 2097152    // bytes, semispaces this big may use huge pages
+#define CARD_SHIFT 9              // 512 byte cards, the L1 compiler's write
+                                  // barrier has this built in
 
 typedef struct {
    int64_t *allocptr;           // current allocation position
    int64_t words_allocated;
+   int64_t size;                // capacity in words
    void **data;
-   char *valid;
+   uint64_t *starts;            // one bit per word, set on the first
+                                // word of every object
+   void *mapping;               // what was mmapped for data
+   size_t mapping_bytes;
+   size_t starts_bytes;
+   uint32_t *sites;             // allocation site of the object starting
+                                // at each word, only when profiling
+   size_t sites_bytes;
 } heap_t;
 
+#define HEAP_ALIGNMENT 512          // bytes covered by one word of starts
+
 heap_t heap;      // the current heap
 heap_t heap2;     // the heap for copying
+heap_t nursery;   // where new objects go
+
+int64_t heap_max_size;  // upper bound for heap growth in words, 0 if none
+int heap_huge_pages;    // $HEAP_HUGE_PAGES, back big semispaces with
+                        // transparent huge pages
+int gc_threads = 1;     // threads collecting, $GC_THREADS
+
+/*
+ * Allocation state shared with the code generated by the L1
+ * compiler, which bumps alloc_ptr inline and only calls allocate()
+ * once an object would reach alloc_limit. alloc_starts_base is
+ * nursery.starts biased so that the start bit of the word at
+ * address p is bit (p / 8) % 64 of alloc_starts_base[p / 512]
+ * (which is why heaps are HEAP_ALIGNMENT aligned). While L1 code
+ * is running these are the real allocation position;
+ * nursery.allocptr and nursery.words_allocated are only brought up
+ * to date when we get called.
+ */
+int64_t *alloc_ptr;
+int64_t *alloc_limit;
+uint64_t *alloc_starts_base;
 
 int64_t *stack; // pointer to the bottom of the stack (i.e. value
                 // upon program startup)
 
+/*
+ * Stack maps emitted by the L1 compiler, one for every return
+ * address an L1 frame can be suspended at (return labels and the
+ * allocate() call sites), sorted by address. frame_words is the size
+ * of the frame the address returns into, live_slots the frame words
+ * that are live there (all of them if live_count is -1), and
+ * registers has a bit for each live callee-save register, in the
+ * order allocate() spills them.
+ */
+typedef struct {
+   uint64_t return_address;
+   int64_t frame_words;
+   int64_t registers;
+   int64_t live_count;
+   int64_t *live_slots;
+} stack_map_t;
+
+#ifdef JIT
+/*
+ * Built into bin/L1 for its -r mode, the runtime isn't linked
+ * against the program, so L1 points these at the program it has
+ * loaded before it calls runtime_main().
+ */
+int64_t stack_map_count;
+stack_map_t *stack_maps;
+void *go;
+#define main runtime_main
+#define CALL_GO "call *go(%%rip);"
+#else
+extern int64_t stack_map_count;
+extern stack_map_t stack_maps[];
+#define CALL_GO "call go;"
+#endif
+
+#define ALLOCATE_SPILL_WORDS 6 // callee-save registers allocate() spills
+
+/*
+ * GC and allocation statistics, only gathered when $GC_STATS is set.
+ * Bucket 0 of the histogram counts empty objects, bucket k > 0
+ * objects of 2^(k-1) to 2^k - 1 data words.
+ */
+typedef struct {
+   int enabled;
+   int64_t collections;
+   int64_t minor_collections;
+   int64_t objects_allocated;
+   int64_t words_allocated;
+   int64_t words_copied;
+   int64_t total_pause_ns;
+   int64_t max_pause_ns;
+   int64_t size_histogram[GC_STATS_BUCKETS];
+} gc_stats_t;
+
+gc_stats_t gc_stats;
+
+/*
+ * Allocation-site profile. Programs the IR compiler built with
+ * $ALLOCATION_PROFILE set allocate through allocate_site(), passing
+ * the number of the new Array or new Tuple doing it (the compiler
+ * lists them in prog.sites). The site of every object is kept next
+ * to it, in the sites table of its heap or in its large-object
+ * header, so the gc can charge what it copies to the site. The
+ * totals go to stderr at exit; site 0 is every other allocation.
+ */
+typedef struct {
+   int64_t objects;
+   int64_t words_allocated;
+   int64_t words_survived;      // copied by a gc, or kept by one for
+                                // large objects
+} alloc_site_t;
+
+alloc_site_t *alloc_sites;      // NULL unless profiling
+int64_t alloc_site_count;
+
+/*
+ * Output of print() and array_error() is collected here and written
+ * to stdout in large chunks instead of going through printf. Anything
+ * else that writes to stdout has to call output_flush() first.
+ */
+char output_buffer[OUTPUT_BUFFER_SIZE];
+int64_t output_length;
+
+void output_flush() {
+   int64_t written = 0;
+   ssize_t n;
+
+   while(written < output_length) {
+      n = write(STDOUT_FILENO, output_buffer + written, output_length - written);
+      if(n <= 0) {
+         break;
+      }
+      written += n;
+   }
+   output_length = 0;
+}
+
+void output_string(const char *str, int64_t length) {
+   if(output_length + length > OUTPUT_BUFFER_SIZE) {
+      output_flush();
+   }
+   memcpy(output_buffer + output_length, str, length);
+   output_length += length;
+}
+
+#define output_literal(str) output_string(str, sizeof(str) - 1)
+
+void output_int(int64_t x) {
+   char digits[20];
+   int i = sizeof(digits);
+   uint64_t u = (x < 0) ? -(uint64_t)x : (uint64_t)x;
+
+   if(output_length + 21 > OUTPUT_BUFFER_SIZE) {
+      output_flush();
+   }
+   do {
+      digits[--i] = '0' + u % 10;
+      u /= 10;
+   } while(u != 0);
+   if(x < 0) {
+      output_buffer[output_length++] = '-';
+   }
+   memcpy(output_buffer + output_length, digits + i, sizeof(digits) - i);
+   output_length += sizeof(digits) - i;
+}
+
 /*
  * Helper for the print() function
  */
 void print_content(int64_t *in, int depth) {
    if(depth >= 4) {
-     printf("...");
+     output_literal("...");
      return;
    }
    // NOTE: this function crashes quite messily if "in" is 0
    // so we've added this check
    if(in == NULL) {
-     printf("nil");
+     output_literal("nil");
      return;
    }
    int64_t x = (int64_t)in;
    if(x & 1) {
-     printf("%" PRId64, x >> 1);
+     output_int(x >> 1);
    } else {
      int64_t size = *((int64_t*)in);
      int64_t *data = in + 1;
      int i;
-     printf("{s:%" PRId64, size);
+     output_literal("{s:");
+     output_int(size);
      for(i = 0; i < size; i++) {
-       printf(", ");
+       output_literal(", ");
        print_content((int64_t *)(*data), depth + 1);
        data++;
      }
-     printf("}");
+     output_literal("}");
      // check for bad pointers
      if (size==-1) {
-       printf("\nfound -1 in an array; internal GC failure\n");
+       output_literal("\nfound -1 in an array; internal GC failure\n");
        exit(-1);
      }
    }
@@ -81,130 +291,1079 @@ void print_content(int64_t *in, int depth) {
  */
 int64_t print(void *l) {
    print_content(l, 0);
-   printf("\n");
+   output_literal("\n");
 
    return 1;
 }
 
+/*
+ * Object-start bitmap helpers, "index" is a word offset into the heap
+ */
+static inline void set_start(heap_t *h, int64_t index) {
+   h->starts[index / 64] |= (uint64_t)1 << (index % 64);
+}
+
+static inline int is_start(heap_t *h, int64_t index) {
+   return (h->starts[index / 64] >> (index % 64)) & 1;
+}
+
+static inline int64_t starts_words(int64_t size) {
+   return (size + 63) / 64;
+}
+
+/*
+ * Empties a heap. Clearing the part of the start bitmap that
+ * was in use is all it takes to have every bit zero again.
+ */
 void reset_heap(heap_t *h) {
+   memset(h->starts, 0, starts_words(h->words_allocated) * sizeof(uint64_t));
+   h->allocptr = (int64_t*)h->data;
+   h->words_allocated = 0;
+}
+
+/*
+ * Words each semispace gets on top of its size so the LABs the
+ * threads leave partly used can't make a full heap overflow
+ */
+int64_t gc_lab_slack(int64_t size) {
+   if(gc_threads <= 1) {
+      return 0;
+   }
+   return size / (GC_LAB_WORDS / GC_LAB_MIN_WORDS) + gc_threads * GC_LAB_WORDS;
+}
+
+/*
+ * Words a semispace of the given size is mapped with. A major gc
+ * copies the nursery along with a full semispace, so there is room
+ * for that on top of the LAB slack.
+ */
+int64_t semispace_capacity(int64_t size) {
+   return size + nursery.size + gc_lab_slack(size);
+}
+
+/*
+ * Reserves zeroed memory that only takes up space once it's touched
+ */
+void *map_memory(size_t bytes) {
+   void *p = mmap(NULL, bytes, PROT_READ | PROT_WRITE,
+                  MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+   return (p == MAP_FAILED) ? NULL : p;
+}
+
+/*
+ * Gives h a sites table covering the words its start bitmap does
+ */
+int map_sites(heap_t *h) {
+   h->sites_bytes = h->starts_bytes * 64 / sizeof(uint64_t) * sizeof(uint32_t);
+   h->sites = (uint32_t*)map_memory(h->sites_bytes);
+   return (h->sites != NULL);
+}
+
+/*
+ * Carries the allocation site of an object the gc copied from
+ * "from" into the current heap over to the copy, and charges the
+ * words to it. Can run in several gc threads at once.
+ */
+void alloc_site_copied(heap_t *from, int64_t *old, int64_t *copy, int64_t words) {
+   uint32_t site = from->sites[(void**)old - from->data];
+
+   heap.sites[(void**)copy - heap.data] = site;
+   __atomic_fetch_add(&alloc_sites[site].words_survived, words, __ATOMIC_RELAXED);
+}
+
+int alloc_heap(heap_t *h, int64_t size, int64_t capacity) {
+   size_t bytes = capacity * sizeof(void*);
+   int huge = heap_huge_pages && bytes >= HUGE_PAGE_SIZE;
+
+   h->size = size;
+   // huge pages need the data aligned to one, so map one extra
+   // to have room to slide it
+   h->mapping_bytes = bytes + (huge ? HUGE_PAGE_SIZE : 0);
+   h->mapping = map_memory(h->mapping_bytes);
+   h->data = NULL;
+   if(h->mapping != NULL) {
+      h->data = h->mapping;
+      if(huge) {
+         h->data = (void**)(((uintptr_t)h->mapping + HUGE_PAGE_SIZE - 1) & ~(uintptr_t)(HUGE_PAGE_SIZE - 1));
+         madvise(h->data, bytes, MADV_HUGEPAGE);
+      }
+   }
+   h->starts_bytes = starts_words(capacity) * sizeof(uint64_t);
+   h->starts = (uint64_t*)map_memory(h->starts_bytes);
+   h->sites = NULL;
+   if(alloc_sites != NULL && !map_sites(h)) {
+      return 0;
+   }
    h->allocptr = (int64_t*)h->data;
    h->words_allocated = 0;
+   return (h->data != NULL && h->starts != NULL);
 }
 
-int alloc_heap(heap_t *h) {
-   h->data = (void*)malloc(HEAP_SIZE * sizeof(void*));
-   h->valid = (void*)malloc(HEAP_SIZE * sizeof(char));
-   reset_heap(h);
-   return (h->data != NULL && h->valid != NULL);
+/*
+ * Empties a heap that is not going to be used for a while and
+ * gives its memory back to the system. The pages come back zeroed
+ * on first touch, so the start bitmap needs no clearing.
+ */
+void release_heap(heap_t *h) {
+   madvise(h->data, h->words_allocated * sizeof(int64_t), MADV_DONTNEED);
+   madvise(h->starts, starts_words(h->words_allocated) * sizeof(uint64_t), MADV_DONTNEED);
+   h->allocptr = (int64_t*)h->data;
+   h->words_allocated = 0;
 }
 
-void switch_heaps() {
-   int64_t *temp_allocptr = heap.allocptr;
-   int temp_words_allocated = heap.words_allocated;
-   void **temp_data = heap.data;
-   char *temp_valid = heap.valid;
+/*
+ * Picks up the allocations the L1 code made inline
+ */
+void load_alloc_ptr() {
+   nursery.allocptr = alloc_ptr;
+   nursery.words_allocated = alloc_ptr - (int64_t*)nursery.data;
+}
+
+/*
+ * Hands the nursery back to the L1 code
+ */
+void store_alloc_ptr() {
+   alloc_ptr = nursery.allocptr;
+   alloc_limit = (int64_t*)nursery.data + nursery.size;
+   if(gc_stats.enabled || alloc_sites != NULL) {
+      // send every allocation through allocate_helper to count it
+      alloc_limit = alloc_ptr;
+   }
+   alloc_starts_base = nursery.starts - (uintptr_t)nursery.data / HEAP_ALIGNMENT;
+}
 
-   heap.allocptr = heap2.allocptr;
-   heap.words_allocated = heap2.words_allocated;
-   heap.data = heap2.data;
-   heap.valid = heap2.valid;
+/*
+ * Throws away the contents of h and gives it room for size words.
+ * Only used on the heap we are not allocating from.
+ */
+int resize_heap(heap_t *h, int64_t size) {
+   if(h->mapping != NULL) {
+      munmap(h->mapping, h->mapping_bytes);
+   }
+   if(h->starts != NULL) {
+      munmap(h->starts, h->starts_bytes);
+   }
+   if(h->sites != NULL) {
+      munmap(h->sites, h->sites_bytes);
+   }
+   return alloc_heap(h, size, semispace_capacity(size));
+}
+
+void switch_heaps() {
+   heap_t temp = heap;
 
-   heap2.allocptr = temp_allocptr;
-   heap2.words_allocated = temp_words_allocated;
-   heap2.data = temp_data;
-   heap2.valid = temp_valid;
+   heap = heap2;
+   heap2 = temp;
 
    reset_heap(&heap);
 }
 
+/*
+ * Large-object space: arrays of LARGE_OBJECT_WORDS words or more
+ * get a mapping of their own instead of a place in the semispaces,
+ * and are never copied. A gc marks the ones it reaches and scans
+ * them like the objects it copies; the rest are unmapped afterwards.
+ * Each mapping starts with a large_header_t, the object follows.
+ */
+typedef struct {
+   int64_t mapped_words;        // the whole mapping, header included
+   int64_t marked;
+   int64_t site;                // allocation site, when profiling
+} large_header_t;
+
+#define LARGE_HEADER_WORDS (int64_t)(sizeof(large_header_t) / sizeof(int64_t))
+
+int64_t **large_objects;        // sorted by address
+int64_t large_object_count;
+int64_t large_object_capacity;
+int64_t large_words;            // words mapped for large objects
+int64_t large_words_limit;      // collect before mapping more than this
+int64_t **large_gray;           // marked but not scanned yet
+int64_t large_gray_count;
+int64_t large_gray_capacity;
+
+static inline large_header_t *large_header(int64_t *object) {
+   return (large_header_t*)(object - LARGE_HEADER_WORDS);
+}
+
+/*
+ * Is p a large object (the address of its size word)?
+ */
+int is_large_object(int64_t *p) {
+   int64_t low = 0, high = large_object_count - 1, middle;
+
+   if(large_object_count == 0 ||
+      p < large_objects[0] || p > large_objects[large_object_count - 1]) {
+      return 0;
+   }
+   while(low <= high) {
+      middle = low + (high - low) / 2;
+      if(large_objects[middle] == p) {
+         return 1;
+      }
+      if(large_objects[middle] < p) {
+         low = middle + 1;
+      } else {
+         high = middle - 1;
+      }
+   }
+   return 0;
+}
+
+/*
+ * Maps a large object of array_size words, NULL if there is no room
+ */
+int64_t *large_alloc(int64_t array_size) {
+   int64_t mapped_words = array_size + LARGE_HEADER_WORDS;
+   int64_t *mapping, *object;
+   int64_t i;
+
+   if(large_object_count == large_object_capacity) {
+      int64_t capacity = (large_object_capacity == 0) ? 64 : large_object_capacity * 2;
+      int64_t **objects = (int64_t**)realloc(large_objects, capacity * sizeof(int64_t*));
+      if(objects == NULL) {
+         return NULL;
+      }
+      large_objects = objects;
+      large_object_capacity = capacity;
+   }
+   mapping = mmap(NULL, mapped_words * sizeof(int64_t), PROT_READ | PROT_WRITE,
+                  MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+   if(mapping == MAP_FAILED) {
+      return NULL;
+   }
+   object = mapping + LARGE_HEADER_WORDS;
+   large_header(object)->mapped_words = mapped_words;
+   large_header(object)->marked = 0;
+   large_words += mapped_words;
+
+   for(i = large_object_count; i > 0 && large_objects[i - 1] > object; i--) {
+      large_objects[i] = large_objects[i - 1];
+   }
+   large_objects[i] = object;
+   large_object_count++;
+   return object;
+}
+
+/*
+ * Marks a large object the gc reached, queueing it to be scanned
+ * the first time
+ */
+void large_mark(int64_t *object) {
+   if(large_header(object)->marked) {
+      return;
+   }
+   large_header(object)->marked = 1;
+   if(large_gray_count == large_gray_capacity) {
+      large_gray_capacity = (large_gray_capacity == 0) ? 64 : large_gray_capacity * 2;
+      large_gray = (int64_t**)realloc(large_gray, large_gray_capacity * sizeof(int64_t*));
+      if(large_gray == NULL) {
+         output_flush();
+         printf("out of memory\n");
+         exit(-1);
+      }
+   }
+   large_gray[large_gray_count++] = object;
+}
+
+/*
+ * Unmaps the large objects the last gc did not reach and clears
+ * the marks on the others. The space may then grow until it is
+ * twice as big as what survived, or by a semispace's worth.
+ */
+void large_sweep() {
+   int64_t i, kept = 0;
+   int64_t *object;
+
+   for(i = 0; i < large_object_count; i++) {
+      object = large_objects[i];
+      if(large_header(object)->marked) {
+         large_header(object)->marked = 0;
+         large_objects[kept++] = object;
+         if(alloc_sites != NULL) {
+            alloc_sites[large_header(object)->site].words_survived += object[0] + 1;
+         }
+      } else {
+         large_words -= large_header(object)->mapped_words;
+         munmap(large_header(object), large_header(object)->mapped_words * sizeof(int64_t));
+      }
+   }
+   large_object_count = kept;
+   large_words_limit = large_words + ((large_words > heap.size) ? large_words : heap.size);
+}
+
+/*
+ * Card table: one byte for every 1 << CARD_SHIFT bytes from
+ * gc_cards_low on, for gc_cards_span bytes. The write barrier the
+ * L1 compiler emits after a store sets the byte for the word stored
+ * to if it is in that range, which always takes in the current
+ * semispace and the large objects. A minor gc scans the old objects
+ * on the cards that are set for pointers into the nursery, and
+ * clears them.
+ */
+uint8_t *gc_cards;
+uintptr_t gc_cards_low;
+uintptr_t gc_cards_span;
+int64_t gc_barrier_scratch;     // where the write barrier keeps rax
+
+/*
+ * Makes the card table cover [low, high) as well, keeping the
+ * cards that are already set
+ */
+void cards_cover(void *low, void *high) {
+   uintptr_t new_low = (uintptr_t)low, new_high = (uintptr_t)high;
+   uint8_t *cards;
+
+   if(gc_cards != NULL) {
+      if(new_low >= gc_cards_low && new_high <= gc_cards_low + gc_cards_span) {
+         return;
+      }
+      if(new_low > gc_cards_low) {
+         new_low = gc_cards_low;
+      }
+      if(new_high < gc_cards_low + gc_cards_span) {
+         new_high = gc_cards_low + gc_cards_span;
+      }
+   }
+   new_low &= ~(((uintptr_t)1 << CARD_SHIFT) - 1);
+   new_high = (new_high + ((uintptr_t)1 << CARD_SHIFT) - 1) & ~(((uintptr_t)1 << CARD_SHIFT) - 1);
+
+   cards = (uint8_t*)map_memory((new_high - new_low) >> CARD_SHIFT);
+   if(cards == NULL) {
+      output_flush();
+      printf("out of memory\n");
+      exit(-1);
+   }
+   if(gc_cards != NULL) {
+      memcpy(cards + ((gc_cards_low - new_low) >> CARD_SHIFT), gc_cards, gc_cards_span >> CARD_SHIFT);
+      munmap(gc_cards, gc_cards_span >> CARD_SHIFT);
+   }
+   gc_cards = cards;
+   gc_cards_low = new_low;
+   gc_cards_span = new_high - new_low;
+}
+
+/*
+ * Starts over with every card clear and a table just big enough for
+ * the current semispace and the large objects, after a major gc
+ * left nothing in the nursery for old objects to point at
+ */
+void cards_reset() {
+   int64_t i;
+   int64_t *object;
+
+   if(gc_cards != NULL) {
+      munmap(gc_cards, gc_cards_span >> CARD_SHIFT);
+      gc_cards = NULL;
+   }
+   cards_cover(heap.data, heap.data + semispace_capacity(heap.size));
+   for(i = 0; i < large_object_count; i++) {
+      object = large_objects[i];
+      cards_cover(large_header(object), object + large_header(object)->mapped_words);
+   }
+}
+
+/*
+ * Sets the cards of [start, end), for objects the runtime fills
+ * with a pointer into the nursery
+ */
+void cards_mark(int64_t *start, int64_t *end) {
+   uintptr_t first = ((uintptr_t)start - gc_cards_low) >> CARD_SHIFT;
+   uintptr_t last = ((uintptr_t)end - 1 - gc_cards_low) >> CARD_SHIFT;
+
+   if(start < end) {
+      memset(gc_cards + first, 1, last - first + 1);
+   }
+}
+
+static inline int is_young(int64_t *p) {
+   return (void**)p >= nursery.data && (void**)p < nursery.data + nursery.words_allocated;
+}
+
+/*
+ * The heap a gc copies the object at p out of, if it is in one: the
+ * semispace a major gc is emptying, or the nursery, which both
+ * kinds of gc empty. NULL for everything else.
+ */
+static inline heap_t *gc_source(int64_t *p) {
+   if((void**)p >= heap2.data && (void**)p < heap2.data + heap2.words_allocated) {
+      return &heap2;
+   }
+   if(is_young(p)) {
+      return &nursery;
+   }
+   return NULL;
+}
+
+int gc_minor_running;           // only a major gc marks large objects
+
 /*
  * Helper for the gc() function.
- * Copies (compacts) an object from the old heap into
- * the empty heap
+ * Moves a single object from the old heap into the empty heap
+ * without looking at its contents, leaving a forwarding pointer
+ * behind. The contents are fixed up later by gc_scan().
  */
-int64_t *gc_copy(int64_t *old)  {
-   int i, size, array_size;
-   int64_t *old_array, *new_array, *first_array_location;
-   int valid_index;
-   char is_valid;
-   char *valid;
+int64_t *gc_forward(int64_t *old)  {
+   int64_t size, array_size;
+   int64_t *old_array, *new_array;
+   int64_t start_index;
+   heap_t *from;
 
    // If not a pointer or not a pointer to a heap location, return input value
-   if((int64_t)old % 8 != 0 ||
-      (void**)old < heap2.data ||
-      (void**)old >= heap2.data + heap2.words_allocated) {
+   if((int64_t)old % 8 != 0) {
+      return old;
+   }
+   from = gc_source(old);
+   if(from == NULL) {
+      // large objects stay where they are, and so does the old
+      // space during a minor gc
+      if(!gc_minor_running && is_large_object(old)) {
+         large_mark(old);
+      }
       return old;
    }
-   
+
    // if not pointing at a valid heap object, return input value
-   valid_index = (int64_t)((void**)old - heap2.data);
-   is_valid = heap2.valid[valid_index];
-   if(!is_valid) {
+   start_index = (int64_t)((void**)old - from->data);
+   if(!is_start(from, start_index)) {
       return old;
    }
 
    old_array = (int64_t*)old;
    size = old_array[0];
-   array_size = size + 1;
 
    // If the size is negative, the array has already been copied to the
    // new heap, so the first location of array will contain the new address
    if(size == -1) {
        return (int64_t*)old_array[1];
    }
+
    // If the size is zero, we still have one word of data to copy to the
    // new heap
-   else if(size == 0) {
-       array_size = 2;
-   }
+   array_size = (size == 0) ? 2 : size + 1;
 
 #ifdef GC_DEBUG
-   // printf("gc_copy(): valid=%d old=%p new=%p: size=%d asize=%d total=%d\n", is_valid, old, heap.allocptr, size, array_size, heap.words_allocated);
+   // printf("gc_forward(): old=%p new=%p: size=%d asize=%d total=%d\n", old, heap.allocptr, size, array_size, heap.words_allocated);
 #endif
 
-   valid = heap.valid + heap.words_allocated;
-
-   // Mark the old array as invalid, create the new array
-   old_array[0] = -1;
    new_array = heap.allocptr;
+   if(array_size <= 3) {
+      // tuples of a word or two, which is most of what gets
+      // promoted, aren't worth a memcpy() call
+      new_array[0] = old_array[0];
+      new_array[1] = old_array[1];
+      if(array_size == 3) {
+         new_array[2] = old_array[2];
+      }
+   } else {
+      memcpy(new_array, old_array, array_size * sizeof(int64_t));
+   }
+   set_start(&heap, heap.words_allocated);
    heap.allocptr += array_size;
    heap.words_allocated += array_size;
+   gc_stats.words_copied += array_size;
+   if(alloc_sites != NULL) {
+      alloc_site_copied(from, old_array, new_array, array_size);
+   }
 
-   // The value of old_array[1] needs to be handled specially
-   // since it holds a pointer to the new heap object
-   first_array_location = (int64_t*)old_array[1];
+   // Mark the old array as invalid and leave the new address
+   // in its first data word
+   old_array[0] = -1;
    old_array[1] = (int64_t)new_array;
 
-   // Set the values of new_array handling the first two locations separately
-   new_array[0] = size;
-   new_array[1] = (int64_t)gc_copy(first_array_location);
+   return new_array;
+}
 
-   valid[0] = 1;
-   valid[1] = 0;
+/*
+ * Helper for the gc() function.
+ * Cheney scan: walks the objects already moved into the new heap,
+ * starting at "scan", forwarding everything they point to. Objects
+ * forwarded along the way are appended at allocptr, so the loop
+ * ends once scan catches up with it and no marked large object is
+ * left to scan. Lays objects out breadth-first.
+ */
+void gc_scan(int64_t *scan) {
+   int64_t i, size, array_size;
+   int64_t *object;
 
-   // Call gc_copy on the remaining values of the array
-   for (i = 2; i < array_size; i++) {
-      new_array[i] = (int64_t)gc_copy((int64_t*)old_array[i]);
-      valid[i] = 0;
+   while(1) {
+      while(scan < heap.allocptr) {
+         size = scan[0];
+         array_size = (size == 0) ? 2 : size + 1;
+         for(i = 1; i < array_size; i++) {
+            scan[i] = (int64_t)gc_forward((int64_t*)scan[i]);
+         }
+         scan += array_size;
+      }
+      if(large_gray_count == 0) {
+         return;
+      }
+      object = large_gray[--large_gray_count];
+      for(i = 1; i <= object[0]; i++) {
+         // mostly numbers in big arrays, so skip them without a call
+         if((object[i] & 7) == 0) {
+            object[i] = (int64_t)gc_forward((int64_t*)object[i]);
+         }
+      }
    }
+}
+
+/*
+ * Copies (compacts) everything reachable from a single
+ * root into the new heap once gc() is done with the stack.
+ */
+int64_t *gc_copy(int64_t *old)  {
+   int64_t *scan = heap.allocptr;
+   int64_t *new_array = gc_forward(old);
 
+   gc_scan(scan);
    return new_array;
 }
 
+/*
+ * Finds the stack map for a return address, NULL if there is none
+ */
+stack_map_t *stack_map_find(uint64_t return_address) {
+   int64_t low = 0, high = stack_map_count - 1, middle;
+
+   while(low <= high) {
+      middle = low + (high - low) / 2;
+      if(stack_maps[middle].return_address == return_address) {
+         return &stack_maps[middle];
+      }
+      if(stack_maps[middle].return_address < return_address) {
+         low = middle + 1;
+      } else {
+         high = middle - 1;
+      }
+   }
+   return NULL;
+}
+
+/*
+ * Helper for the gc() function.
+ * Forwards a root in place
+ */
+void gc_forward_root(int64_t *root) {
+   *root = (int64_t)gc_forward((int64_t*)*root);
+}
+
+/*
+ * Helper for the gc() function.
+ * Hands every root on the stack to visit(): the registers allocate()
+ * spilled at rsp, then every L1 frame from the innermost out, each
+ * found from the return address above the one before it. Anything
+ * without a map is treated as roots up to the bottom of the stack.
+ */
+void gc_stack(int64_t *rsp, void (*visit)(int64_t *root)) {
+   int64_t i;
+   int64_t *frame = rsp + ALLOCATE_SPILL_WORDS + 1;
+   stack_map_t *map = stack_map_find(rsp[ALLOCATE_SPILL_WORDS]);
+
+   for(i = 0; i < ALLOCATE_SPILL_WORDS; i++) {
+      if(map == NULL || (map->registers & ((int64_t)1 << i))) {
+         visit(&rsp[i]);
+      }
+   }
+
+   while(frame < stack) {
+      if(map == NULL) {
+         for(; frame <= stack; frame++) {
+            visit(frame);
+         }
+         return;
+      }
+      if(map->live_count < 0) {
+         for(i = 0; i < map->frame_words; i++) {
+            visit(&frame[i]);
+         }
+      } else {
+         for(i = 0; i < map->live_count; i++) {
+            visit(&frame[map->live_slots[i]]);
+         }
+      }
+      frame += map->frame_words;
+      map = stack_map_find(*frame);
+      frame++;
+   }
+}
+
+/*
+ * Monotonic clock in nanoseconds, for the GC pause statistics
+ */
+int64_t gc_stats_now() {
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+void gc_stats_record_pause(int64_t pause_ns) {
+   gc_stats.collections++;
+   gc_stats.total_pause_ns += pause_ns;
+   if(pause_ns > gc_stats.max_pause_ns) {
+      gc_stats.max_pause_ns = pause_ns;
+   }
+}
+
+void gc_stats_record_allocation(int64_t data_size, int64_t array_size) {
+   int bucket = (data_size == 0) ? 0 : 64 - __builtin_clzll(data_size);
+
+   gc_stats.objects_allocated++;
+   gc_stats.words_allocated += array_size;
+   gc_stats.size_histogram[bucket]++;
+}
+
+/*
+ * Prints the statistics at exit
+ */
+void gc_stats_report() {
+   int i;
+   struct rusage usage;
+
+   fprintf(stderr, "gc: %" PRId64 " collections (%" PRId64 " minor), pause total %" PRId64
+           ".%03" PRId64 " ms, max %" PRId64 ".%03" PRId64 " ms\n",
+           gc_stats.collections, gc_stats.minor_collections,
+           gc_stats.total_pause_ns / 1000000, gc_stats.total_pause_ns / 1000 % 1000,
+           gc_stats.max_pause_ns / 1000000, gc_stats.max_pause_ns / 1000 % 1000);
+   fprintf(stderr, "gc: allocated %" PRId64 " words in %" PRId64 " objects, copied %" PRId64
+           " words, heap %" PRId64 " words, nursery %" PRId64 " words, large objects %"
+           PRId64 " words\n",
+           gc_stats.words_allocated, gc_stats.objects_allocated,
+           gc_stats.words_copied, heap.size, nursery.size, large_words);
+   fprintf(stderr, "gc: object sizes");
+   for(i = 0; i < GC_STATS_BUCKETS; i++) {
+      if(gc_stats.size_histogram[i] == 0) {
+         continue;
+      }
+      if(i <= 1) {
+         fprintf(stderr, " %d:%" PRId64, i, gc_stats.size_histogram[i]);
+      } else {
+         fprintf(stderr, " %" PRIu64 "-%" PRIu64 ":%" PRId64,
+                 (uint64_t)1 << (i - 1), ((uint64_t)1 << i) - 1,
+                 gc_stats.size_histogram[i]);
+      }
+   }
+   fprintf(stderr, "\n");
+   getrusage(RUSAGE_SELF, &usage);
+   fprintf(stderr, "gc: peak resident %ld KB\n", usage.ru_maxrss);
+}
+
+/*
+ * Prints the allocation-site profile at exit
+ */
+void alloc_sites_report() {
+   int64_t site;
+
+   for(site = 0; site < alloc_site_count; site++) {
+      if(alloc_sites[site].objects == 0) {
+         continue;
+      }
+      fprintf(stderr, "alloc: site %" PRId64 ": %" PRId64 " objects, %" PRId64
+              " words, %" PRId64 " words survived gc\n",
+              site, alloc_sites[site].objects, alloc_sites[site].words_allocated,
+              alloc_sites[site].words_survived);
+   }
+}
+
+/*
+ * Starts profiling allocation sites, on the first allocation that
+ * comes with one. Whatever was allocated before belongs to site 0.
+ */
+void alloc_sites_enable() {
+   alloc_site_count = 64;
+   alloc_sites = (alloc_site_t*)calloc(alloc_site_count, sizeof(alloc_site_t));
+   if(alloc_sites == NULL ||
+      !map_sites(&nursery) || !map_sites(&heap) || !map_sites(&heap2)) {
+      output_flush();
+      printf("out of memory\n");
+      exit(-1);
+   }
+   atexit(alloc_sites_report);
+}
+
+/*
+ * Counts an allocation at a site, growing the table for new sites
+ */
+void alloc_site_record(int64_t site, int64_t array_size) {
+   int64_t count = alloc_site_count;
+
+   if(site >= alloc_site_count) {
+      while(site >= count) {
+         count *= 2;
+      }
+      alloc_sites = (alloc_site_t*)realloc(alloc_sites, count * sizeof(alloc_site_t));
+      if(alloc_sites == NULL) {
+         output_flush();
+         printf("out of memory\n");
+         exit(-1);
+      }
+      memset(alloc_sites + alloc_site_count, 0, (count - alloc_site_count) * sizeof(alloc_site_t));
+      alloc_site_count = count;
+   }
+   alloc_sites[site].objects++;
+   alloc_sites[site].words_allocated += array_size;
+}
+
+/*
+ * Parallel collection, used when $GC_THREADS asks for more than one
+ * thread. The roots are split between the threads, and each copies
+ * the objects it reaches into its own slice of the new heap (a LAB,
+ * local allocation buffer) and keeps the copies it still has to
+ * scan on a private gray stack. While some thread is out of work,
+ * the others move half their stacks to a shared queue it can steal
+ * from.
+ * Threads race to copy an object by swapping its size word for
+ * GC_BUSY; the winner copies it and then publishes the forwarding
+ * pointer, the others wait for that.
+ */
+typedef struct {
+   pthread_mutex_t lock;
+   int64_t **items;             // gray objects, items[head..tail)
+   int64_t head;
+   int64_t tail;
+   int64_t capacity;
+} gc_queue_t;
+
+typedef struct {
+   int id;
+   pthread_t thread;
+   int64_t *lab;                // unused part of this thread's LAB
+   int64_t *lab_end;
+   int64_t words_copied;
+   int64_t **gray;              // private gray stack
+   int64_t gray_count;
+   int64_t gray_capacity;
+   gc_queue_t shared;           // gray objects up for stealing
+} gc_worker_t;
+
+gc_worker_t gc_workers[GC_MAX_THREADS];
+pthread_barrier_t gc_start_barrier;
+pthread_barrier_t gc_end_barrier;
+pthread_mutex_t gc_init_lock = PTHREAD_MUTEX_INITIALIZER;
+int64_t **gc_roots;
+int64_t gc_root_count;
+int64_t gc_root_capacity;
+int64_t *gc_to_space_top;       // next free word in the new heap
+int64_t *gc_to_space_end;
+int gc_idle;                    // threads that found no work
+
+void gc_grow(int64_t ***items, int64_t *capacity) {
+   *capacity = (*capacity == 0) ? 1024 : *capacity * 2;
+   *items = (int64_t**)realloc(*items, *capacity * sizeof(int64_t*));
+   if(*items == NULL) {
+      output_flush();
+      printf("out of memory\n");
+      exit(-1);
+   }
+}
+
+void gc_queue_push(gc_queue_t *q, int64_t **objects, int64_t n) {
+   pthread_mutex_lock(&q->lock);
+   if(q->head > 0) {
+      memmove(q->items, q->items + q->head, (q->tail - q->head) * sizeof(int64_t*));
+      q->tail -= q->head;
+      q->head = 0;
+   }
+   while(q->tail + n > q->capacity) {
+      gc_grow(&q->items, &q->capacity);
+   }
+   memcpy(q->items + q->tail, objects, n * sizeof(int64_t*));
+   __atomic_store_n(&q->tail, q->tail + n, __ATOMIC_RELAXED);
+   pthread_mutex_unlock(&q->lock);
+}
+
+int64_t *gc_queue_steal(gc_queue_t *q) {
+   int64_t *object = NULL;
+
+   pthread_mutex_lock(&q->lock);
+   if(q->tail > q->head) {
+      object = q->items[q->head++];
+      if(q->head == q->tail) {
+         q->head = 0;
+         __atomic_store_n(&q->tail, 0, __ATOMIC_RELAXED);
+      }
+   }
+   pthread_mutex_unlock(&q->lock);
+   return object;
+}
+
+/*
+ * Takes words from the new heap for one object: from the thread's
+ * LAB if it fits, otherwise straight from the shared top (keeping
+ * the LAB for smaller objects) unless the LAB is nearly used up, in
+ * which case the thread takes a new one.
+ */
+int64_t *gc_parallel_alloc(gc_worker_t *w, int64_t words) {
+   int64_t *object;
+
+   if(w->lab + words > w->lab_end) {
+      int64_t lab_words = GC_LAB_WORDS;
+      int refill = (w->lab_end - w->lab < GC_LAB_MIN_WORDS && words < GC_LAB_WORDS);
+
+      object = __atomic_fetch_add(&gc_to_space_top, (refill ? lab_words : words) * sizeof(int64_t),
+                                  __ATOMIC_RELAXED);
+      if(object + (refill ? lab_words : words) > gc_to_space_end) {
+         output_flush();
+         printf("out of memory\n");
+         exit(-1);
+      }
+      if(!refill) {
+         return object;
+      }
+      w->lab = object;
+      w->lab_end = object + lab_words;
+   }
+   object = w->lab;
+   w->lab += words;
+   return object;
+}
+
+void gc_parallel_gray(gc_worker_t *w, int64_t *object) {
+   if(w->gray_count == w->gray_capacity) {
+      gc_grow(&w->gray, &w->gray_capacity);
+   }
+   w->gray[w->gray_count++] = object;
+}
+
+/*
+ * gc_forward() for the parallel collector: the thread that manages
+ * to mark the object busy copies it and queues the copy for
+ * scanning, everybody else gets the forwarding pointer. Large
+ * objects are queued by whoever marks them.
+ */
+int64_t *gc_parallel_forward(gc_worker_t *w, int64_t *old) {
+   int64_t size, array_size, index;
+   int64_t *new_array;
+   heap_t *from;
+
+   if((int64_t)old % 8 != 0) {
+      return old;
+   }
+   from = gc_source(old);
+   if(from == NULL) {
+      if(is_large_object(old) &&
+         __atomic_exchange_n(&large_header(old)->marked, 1, __ATOMIC_RELAXED) == 0) {
+         gc_parallel_gray(w, old);
+      }
+      return old;
+   }
+   if(!is_start(from, (void**)old - from->data)) {
+      return old;
+   }
+
+   size = __atomic_load_n(&old[0], __ATOMIC_ACQUIRE);
+   while(1) {
+      if(size == -1) {
+         return (int64_t*)old[1];
+      }
+      if(size == GC_BUSY) {
+         size = __atomic_load_n(&old[0], __ATOMIC_ACQUIRE);
+         continue;
+      }
+      if(__atomic_compare_exchange_n(&old[0], &size, GC_BUSY, 0,
+                                     __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE)) {
+         break;
+      }
+   }
+
+   array_size = (size == 0) ? 2 : size + 1;
+   new_array = gc_parallel_alloc(w, array_size);
+   new_array[0] = size;
+   memcpy(new_array + 1, old + 1, (array_size - 1) * sizeof(int64_t));
+   index = (void**)new_array - heap.data;
+   __atomic_fetch_or(&heap.starts[index / 64], (uint64_t)1 << (index % 64), __ATOMIC_RELAXED);
+   w->words_copied += array_size;
+   if(alloc_sites != NULL) {
+      alloc_site_copied(from, old, new_array, array_size);
+   }
+
+   old[1] = (int64_t)new_array;
+   __atomic_store_n(&old[0], -1, __ATOMIC_RELEASE);
+
+   gc_parallel_gray(w, new_array);
+   return new_array;
+}
+
+/*
+ * Finds a gray object for w: the newest on its own stack (depth
+ * first, likely still in the cache), or the oldest in somebody's
+ * shared queue. Returns NULL once every thread is out of work.
+ */
+int64_t *gc_parallel_next(gc_worker_t *w) {
+   int64_t *object = NULL;
+   int64_t half;
+   int i, idle;
+
+   while(1) {
+      if(w->gray_count > 0) {
+         half = w->gray_count / 2;
+         if(half > 0 && __atomic_load_n(&gc_idle, __ATOMIC_RELAXED) > 0 &&
+            __atomic_load_n(&w->shared.tail, __ATOMIC_RELAXED) == 0) {
+            // somebody is waiting for work, give them the oldest half
+            gc_queue_push(&w->shared, w->gray, half);
+            memmove(w->gray, w->gray + half, (w->gray_count - half) * sizeof(int64_t*));
+            w->gray_count -= half;
+         }
+         return w->gray[--w->gray_count];
+      }
+      for(i = 0; object == NULL && i < gc_threads; i++) {
+         object = gc_queue_steal(&gc_workers[(w->id + i) % gc_threads].shared);
+      }
+      if(object != NULL) {
+         return object;
+      }
+
+      // nothing anywhere: wait until either some thread shares more
+      // or all of them are waiting, which means the gc is done
+      __atomic_add_fetch(&gc_idle, 1, __ATOMIC_ACQ_REL);
+      while(1) {
+         if(__atomic_load_n(&gc_idle, __ATOMIC_ACQUIRE) == gc_threads) {
+            return NULL;
+         }
+         idle = 1;
+         for(i = 0; i < gc_threads && idle; i++) {
+            if(__atomic_load_n(&gc_workers[i].shared.tail, __ATOMIC_RELAXED) > 0) {
+               idle = 0;
+            }
+         }
+         if(!idle) {
+            break;
+         }
+         sched_yield();
+      }
+      __atomic_sub_fetch(&gc_idle, 1, __ATOMIC_ACQ_REL);
+   }
+}
+
+/*
+ * One thread's share of a parallel gc
+ */
+void gc_parallel_work(gc_worker_t *w) {
+   int64_t i, array_size;
+   int64_t *object;
+
+   for(i = w->id; i < gc_root_count; i += gc_threads) {
+      *gc_roots[i] = (int64_t)gc_parallel_forward(w, (int64_t*)*gc_roots[i]);
+   }
+   while((object = gc_parallel_next(w)) != NULL) {
+      array_size = (object[0] == 0) ? 2 : object[0] + 1;
+      for(i = 1; i < array_size; i++) {
+         object[i] = (int64_t)gc_parallel_forward(w, (int64_t*)object[i]);
+      }
+   }
+}
+
+void *gc_parallel_thread(void *arg) {
+   gc_worker_t *w = (gc_worker_t*)arg;
+
+   // the barriers are only set up once gc_parallel_init() knows how
+   // many threads it got
+   pthread_mutex_lock(&gc_init_lock);
+   pthread_mutex_unlock(&gc_init_lock);
+   while(1) {
+      pthread_barrier_wait(&gc_start_barrier);
+      gc_parallel_work(w);
+      pthread_barrier_wait(&gc_end_barrier);
+   }
+   return NULL;
+}
+
+/*
+ * Helper for gc_stack(), collects the roots for the threads
+ */
+void gc_parallel_add_root(int64_t *root) {
+   if(gc_root_count == gc_root_capacity) {
+      gc_root_capacity = (gc_root_capacity == 0) ? 1024 : gc_root_capacity * 2;
+      gc_roots = (int64_t**)realloc(gc_roots, gc_root_capacity * sizeof(int64_t*));
+      if(gc_roots == NULL) {
+         output_flush();
+         printf("out of memory\n");
+         exit(-1);
+      }
+   }
+   gc_roots[gc_root_count++] = root;
+}
+
+/*
+ * Starts the other gc threads, which then wait for a collection
+ * at gc_start_barrier. If only some of them could be created the
+ * gc runs with those; returns 0 if none could.
+ */
+int gc_parallel_init() {
+   int i;
+
+   pthread_mutex_lock(&gc_init_lock);
+   gc_workers[0].id = 0;
+   pthread_mutex_init(&gc_workers[0].shared.lock, NULL);
+   for(i = 1; i < gc_threads; i++) {
+      gc_workers[i].id = i;
+      pthread_mutex_init(&gc_workers[i].shared.lock, NULL);
+      if(pthread_create(&gc_workers[i].thread, NULL, gc_parallel_thread, &gc_workers[i]) != 0) {
+         pthread_mutex_destroy(&gc_workers[i].shared.lock);
+         break;
+      }
+   }
+   gc_threads = i;
+   if(gc_threads == 1) {
+      pthread_mutex_destroy(&gc_workers[0].shared.lock);
+      pthread_mutex_unlock(&gc_init_lock);
+      return 0;
+   }
+   pthread_barrier_init(&gc_start_barrier, NULL, gc_threads);
+   pthread_barrier_init(&gc_end_barrier, NULL, gc_threads);
+   pthread_mutex_unlock(&gc_init_lock);
+   return 1;
+}
+
+/*
+ * Copies everything reachable from the stack into the (already
+ * switched to) new heap with all gc threads
+ */
+void gc_parallel(int64_t *rsp) {
+   int i;
+
+   gc_root_count = 0;
+   gc_stack(rsp, gc_parallel_add_root);
+
+   gc_to_space_top = heap.allocptr;
+   gc_to_space_end = (int64_t*)heap.data + semispace_capacity(heap.size);
+   gc_idle = 0;
+   for(i = 0; i < gc_threads; i++) {
+      gc_workers[i].lab = gc_workers[i].lab_end = NULL;
+      gc_workers[i].words_copied = 0;
+   }
+
+   pthread_barrier_wait(&gc_start_barrier);
+   gc_parallel_work(&gc_workers[0]);
+   pthread_barrier_wait(&gc_end_barrier);
+
+   // the unused ends of the LABs stay behind as holes until the
+   // next gc
+   heap.allocptr = gc_to_space_top;
+   heap.words_allocated = heap.allocptr - (int64_t*)heap.data;
+   for(i = 0; i < gc_threads; i++) {
+      gc_stats.words_copied += gc_workers[i].words_copied;
+   }
+}
+
 /*
  * Initiates garbage collection
  */
 void gc(int64_t *rsp) {
+   int64_t gc_start = 0;
+   if(gc_stats.enabled) {
+      gc_start = gc_stats_now();
+   }
+#ifdef GC_DEBUG
    int i;
    int stack_size = stack - rsp + 1;       // calculate the stack size
-#ifdef GC_DEBUG
    int prev_words_alloc = heap.words_allocated;
 
    printf("GC: stack=(%p,%p) (size %d): ", rsp, stack, stack_size);
 
 #ifdef GC_DUMP
    printf("\n(");
-   for (i=0;i<HEAP_SIZE;i++) {
+   for (i=0;i<heap.size;i++) {
      if (i != 0) printf (" ");
      printf("(%p %p)\n",&(heap.data[i]),heap.data[i]);
    }
@@ -216,22 +1375,26 @@ void gc(int64_t *rsp) {
    // compacted objects
    switch_heaps();
 
-   // NOTE: the edi/esi register contents could also be
-   // roots, but these have been placed in the stack
-   // by the allocate() assembly function.  Thus,
-   // we only need to look at the stack at this point
+   // Then, we need to copy anything the live stack slots and
+   // registers point at into our empty heap, and then
+   // everything reachable from those objects, out of the
+   // nursery as well as the old heap
+   if(gc_threads > 1) {
+      gc_parallel(rsp);
+   } else {
+      gc_stack(rsp, gc_forward_root);
+      gc_scan((int64_t*)heap.data);
+   }
 
-   // Then, we need to copy anything pointed at
-   // by the stack into our empty heap
-   for(i = 0; i < stack_size; i++) {
-      rsp[i] = (int64_t)gc_copy((int64_t*)rsp[i]);
+   if(gc_stats.enabled) {
+      gc_stats_record_pause(gc_stats_now() - gc_start);
    }
 
 #ifdef GC_DEBUG
    printf("reclaimed %d words\n", (prev_words_alloc - heap.words_allocated));
 #ifdef GC_DUMP
    printf("(");
-   for (i=0;i<HEAP_SIZE;i++) {
+   for (i=0;i<heap.size;i++) {
      if (i != 0) printf (" ");
      printf("(%p %p)\n",&(heap.data[i]),heap.data[i]);
    }
@@ -240,16 +1403,185 @@ void gc(int64_t *rsp) {
 #endif
 }
 
+/*
+ * Helper for gc_minor().
+ * Forwards the words in [start, end) that are on set cards and
+ * clears those cards. Words that start an object in h hold its
+ * size and are left alone.
+ */
+void gc_scan_cards(int64_t *start, int64_t *end, heap_t *h) {
+   uintptr_t card, first, last;
+   int64_t *word, *card_end;
+
+   if(start >= end) {
+      return;
+   }
+   first = ((uintptr_t)start - gc_cards_low) >> CARD_SHIFT;
+   last = ((uintptr_t)end - 1 - gc_cards_low) >> CARD_SHIFT;
+   for(card = first; card <= last; card++) {
+      // mostly clear, so skip them eight at a time where we can
+      if(card % 8 == 0 && card + 8 <= last && *(uint64_t*)(gc_cards + card) == 0) {
+         card += 7;
+         continue;
+      }
+      if(gc_cards[card] == 0) {
+         continue;
+      }
+      gc_cards[card] = 0;
+      word = (int64_t*)(gc_cards_low + (card << CARD_SHIFT));
+      card_end = (int64_t*)(gc_cards_low + ((card + 1) << CARD_SHIFT));
+      if(word < start) {
+         word = start;
+      }
+      if(card_end > end) {
+         card_end = end;
+      }
+      for(; word < card_end; word++) {
+         if(h != NULL && is_start(h, (void**)word - h->data)) {
+            continue;
+         }
+         *word = (int64_t)gc_forward((int64_t*)*word);
+      }
+   }
+}
+
+/*
+ * Minor collection: promotes what is still reachable in the nursery
+ * to the end of the old space and empties the nursery. The roots are
+ * the stack and whatever old objects got a pointer stored in them
+ * since the last gc, which are on set cards; nothing else in the
+ * old space is looked at. The caller makes sure the old space has
+ * room for the whole nursery.
+ */
+int64_t *gc_minor(int64_t *rsp, int64_t *fw_fill) {
+   int64_t i;
+   int64_t *object;
+   int64_t *scan = heap.allocptr;
+   int64_t gc_start = 0;
+
+   if(gc_stats.enabled) {
+      gc_start = gc_stats_now();
+   }
+   gc_minor_running = 1;
+
+   gc_stack(rsp, gc_forward_root);
+   fw_fill = gc_forward(fw_fill);
+   gc_scan_cards((int64_t*)heap.data, scan, &heap);
+   for(i = 0; i < large_object_count; i++) {
+      object = large_objects[i];
+      gc_scan_cards(object + 1, object + 1 + object[0], NULL);
+   }
+   gc_scan(scan);
+
+   gc_minor_running = 0;
+   reset_heap(&nursery);
+
+   if(gc_stats.enabled) {
+      gc_stats.minor_collections++;
+      gc_stats_record_pause(gc_stats_now() - gc_start);
+   }
+   return fw_fill;
+}
+
+/*
+ * Picks the new semispace size after a gc that left "live" words
+ * in the heap and still has to make room for "needed" more.
+ * Returns 0 if the heaps should stay as they are.
+ */
+int64_t heap_growth_size(int64_t live, int64_t needed) {
+   int64_t size = heap.size;
+
+   if((live + needed) * 100 < size * HEAP_MAX_SURVIVAL) {
+      return 0;
+   }
+   while((live + needed) * 100 >= size * HEAP_MAX_SURVIVAL) {
+      size *= HEAP_GROWTH_FACTOR;
+   }
+   if(heap_max_size > 0 && size > heap_max_size) {
+      size = heap_max_size;
+   }
+   return (size > heap.size) ? size : 0;
+}
+
+/*
+ * Major collection of the nursery, the semispaces and the large
+ * objects. If the survivors fill too much of the heap, grows both
+ * semispaces. Growing takes a second collection:
+ * the empty semispace is resized and the survivors are copied
+ * into it, then the semispace they came from is resized too.
+ */
+int64_t *collect(int64_t *rsp, int64_t *fw_fill, int64_t needed) {
+   int64_t new_size;
+
+   gc(rsp);
+   // get correct value of fw_fill
+   fw_fill = gc_copy(fw_fill);
+   large_sweep();
+   reset_heap(&nursery);
+
+   new_size = heap_growth_size(heap.words_allocated, needed);
+   if(new_size == 0) {
+      // nothing in the old heap is needed until the next gc
+      release_heap(&heap2);
+   } else if(!resize_heap(&heap2, new_size)) {
+      // can't grow, carry on with the size we have
+      if(!resize_heap(&heap2, heap.size)) {
+         output_flush();
+         printf("out of memory\n");
+         exit(-1);
+      }
+   } else {
+      gc(rsp);
+      fw_fill = gc_copy(fw_fill);
+      large_sweep();
+
+      if(!resize_heap(&heap2, new_size)) {
+         output_flush();
+         printf("out of memory\n");
+         exit(-1);
+      }
+   }
+
+   cards_reset();
+   return fw_fill;
+}
+
+/*
+ * Empties the nursery: a minor gc if the old space can take all of
+ * it, a major one otherwise
+ */
+int64_t *collect_nursery(int64_t *rsp, int64_t *fw_fill) {
+   if(heap.words_allocated + nursery.words_allocated <= heap.size) {
+      return gc_minor(rsp, fw_fill);
+   }
+   fw_fill = collect(rsp, fw_fill, nursery.size);
+   if(heap.words_allocated > heap.size) {
+      // it took the room kept for the nursery to hold what survived
+      output_flush();
+      printf("out of memory\n");
+      exit(-1);
+   }
+   return fw_fill;
+}
+
 /*
  * The "allocate" runtime function
- * (assembly stub that calls the 3-argument
- * allocate_helper function)
+ * (assembly stub that calls the 4-argument
+ * allocate_helper function). allocate_site
+ * is the same with an allocation site in rdx.
  */
 extern void* allocate(int64_t fw_size, int64_t *fw_fill);
+extern void* allocate_site(int64_t fw_size, int64_t *fw_fill, int64_t site);
 asm(
    ".globl allocate\n"
+   ".globl allocate_site\n"
    //   ".type allocate, @function\n"
+   "allocate_site:\n"
+   "movq   %rdx, %rcx\n"    // the site is allocate_helper's fourth argument
+   "jmp    .Lallocate\n"
    "allocate:\n"
+   "xorl   %ecx, %ecx\n"    // no site
+   ".Lallocate:\n"
    "# grab the arguments (into rax,rdx)\n"
    "subq   $48, %rsp\n"
    "movq   %rsp, %rdx\n"    // set up third argument to allocate_helper
@@ -259,7 +1591,10 @@ asm(
    "movq   %r13,24(%rsp)\n"
    "movq   %r14,32(%rsp)\n"
    "movq   %r15,40(%rsp)\n"
+   "movq   %rsp, %rbx\n"    // L1 frames keep no particular alignment,
+   "andq   $-16, %rsp\n"    // so align the stack for the C code
    "call allocate_helper\n" // make the call
+   "movq   %rbx, %rsp\n"
    "movq   (%rsp),%rbx\n"
    "movq   8(%rsp),%rbp\n"
    "movq   16(%rsp),%r12\n"
@@ -315,17 +1650,44 @@ asm(
    */
 );
 
+/*
+ * Fills n words at dst with value using the widest vector stores the
+ * runtime was compiled for, and a scalar loop for the leftovers.
+ */
+void fill_words(int64_t *dst, int64_t value, int64_t n) {
+   int64_t i = 0;
+
+#ifdef __AVX__
+   __m256i v4 = _mm256_set1_epi64x(value);
+   for(; i + 4 <= n; i += 4) {
+      _mm256_storeu_si256((__m256i*)(dst + i), v4);
+   }
+#endif
+#ifdef __SSE2__
+   __m128i v2 = _mm_set1_epi64x(value);
+   for(; i + 2 <= n; i += 2) {
+      _mm_storeu_si128((__m128i*)(dst + i), v2);
+   }
+#endif
+   for(; i < n; i++) {
+      dst[i] = value;
+   }
+}
+
 /*
  * The real "allocate" runtime function
  * (called by the above assembly stub function)
  */
-void* allocate_helper(int64_t fw_size, int64_t *fw_fill, int64_t *rsp)
+void* allocate_helper(int64_t fw_size, int64_t *fw_fill, int64_t *rsp, int64_t site)
 {
-   int i, data_size, array_size;
-   char *valid;
+   int64_t data_size, array_size;
    int64_t *ret;
+   heap_t *h;
+
+   load_alloc_ptr();
 
    if(!(fw_size & 1)) {
+      output_flush();
       printf("allocate called with size input that was not an encoded integer, %" 
 	     PRId64
 	     "\n",
@@ -336,7 +1698,8 @@ void* allocate_helper(int64_t fw_size, int64_t *fw_fill, int64_t *rsp)
    data_size = fw_size >> 1;
 
    if(data_size < 0) {
-      printf("allocate called with size of %i\n", data_size);
+      output_flush();
+      printf("allocate called with size of %" PRId64 "\n", data_size);
       exit(-1);
    }
 
@@ -351,53 +1714,91 @@ void* allocate_helper(int64_t fw_size, int64_t *fw_fill, int64_t *rsp)
    // the array has already been garbage collected
    array_size = (data_size == 0) ? 2 : data_size + 1;
 
+   if(site != 0 && alloc_sites == NULL) {
+      alloc_sites_enable();
+   }
+   if(alloc_sites != NULL) {
+      alloc_site_record(site, array_size);
+   }
+
+   if(array_size >= LARGE_OBJECT_WORDS) {
+      if(large_words + array_size > large_words_limit) {
+         fw_fill = collect(rsp, fw_fill, 0);
+      }
+      ret = large_alloc(array_size);
+      if(ret == NULL) {
+         output_flush();
+         printf("out of memory\n");
+         exit(-1);
+      }
+      if(gc_stats.enabled) {
+         gc_stats_record_allocation(data_size, array_size);
+      }
+      large_header(ret)->site = site;
+      ret[0] = data_size;
+      fill_words(ret + 1, (int64_t)fw_fill, data_size);
+      cards_cover(large_header(ret), ret + array_size);
+      if(is_young(fw_fill)) {
+         cards_mark(ret + 1, ret + array_size);
+      }
+      store_alloc_ptr();
+      return ret;
+   }
 
+   // Arrays that would not fit in the nursery even when it's empty
+   // go straight to the old space
+   h = (array_size >= nursery.size) ? &heap : &nursery;
 
    // Check if the heap has space for the allocation
-   if(heap.words_allocated + array_size >= HEAP_SIZE)
+   if(h->words_allocated + array_size >= h->size)
    {
-      // Garbage collect
-      gc(rsp);
-      // get correct value of fw_fill
-      fw_fill=gc_copy(fw_fill);
+      // Garbage collect, growing the heap if needed
+      if(h == &nursery) {
+         fw_fill = collect_nursery(rsp, fw_fill);
+      } else {
+         fw_fill = collect(rsp, fw_fill, array_size);
+      }
 
       // Check if the garbage collection free enough space for the allocation
-      if(heap.words_allocated + array_size >= HEAP_SIZE) {
+      if(h->words_allocated + array_size >= h->size) {
+         output_flush();
          printf("out of memory\n");
          exit(-1);
       }
    }
 
    // Do the allocation
-   ret = heap.allocptr;
-   valid = heap.valid + heap.words_allocated;
-   heap.allocptr += array_size;
-   heap.words_allocated += array_size;
+   ret = h->allocptr;
+   h->allocptr += array_size;
+   h->words_allocated += array_size;
+   if(gc_stats.enabled) {
+      gc_stats_record_allocation(data_size, array_size);
+   }
 
    // Set the size of the array to be the desired size
    ret[0] = data_size;
 
    // record this as a heap object
-   valid[0] = 1;
+   set_start(h, ret - (int64_t*)h->data);
+   if(alloc_sites != NULL) {
+      h->sites[ret - (int64_t*)h->data] = site;
+   }
 
    // If there is no data, set the value of the array to be a number
    // so it can be properly garbage collected
    if(data_size == 0) {
       ret[1] = 1;
-      valid[1] = 0;
       //printf(" set %p to 1\n", &ret[1]);
       //fflush(stdout);
    } else {
       // Fill the array with the fill value
-      for(i = 1; i < array_size; i++) {
-         ret[i] = (int64_t)fw_fill;
-         valid[i] = 0;
-         //printf(" set %p to %d (%p)", &ret[i], fw_fill, fw_fill);
+      fill_words(ret + 1, (int64_t)fw_fill, data_size);
+      if(h == &heap && is_young(fw_fill)) {
+         cards_mark(ret + 1, ret + array_size);
       }
-      //printf("\n");
-      //fflush(stdout);
    }
 
+   store_alloc_ptr();
    return ret;
 }
 
@@ -406,31 +1807,117 @@ void* allocate_helper(int64_t fw_size, int64_t *fw_fill, int64_t *rsp)
  */
 int array_error (int64_t *array, int64_t fw_x) {
   if (array == NULL){
-    printf("attempted to access an array or tuple, which has not been allocated\n");
+    output_literal("attempted to access an array or tuple, which has not been allocated\n");
+    output_flush();
     exit(0);
   }
   int64_t decodedV = fw_x >> 1;
-  printf("attempted to use position %" PRId64, decodedV);
+  output_literal("attempted to use position ");
+  output_int(decodedV);
   if (decodedV >= *array){
-    printf(" in an array that only has %" PRId64 " position", *array);
-    if (*array != 1) printf("s");
+    output_literal(" in an array that only has ");
+    output_int(*array);
+    output_literal(" position");
+    if (*array != 1) output_literal("s");
   } else {
-    printf(" (linearized array length: %" PRId64 ")", *array);
+    output_literal(" (linearized array length: ");
+    output_int(*array);
+    output_literal(")");
   }
-  printf("\n");
+  output_literal("\n");
+  output_flush();
   exit(0);
 }
 
+/*
+ * Reads a size in words from the environment, or returns
+ * default_size if the variable is unset or not a positive number
+ */
+int64_t heap_size_from_env(const char *name, int64_t default_size) {
+   char *value = getenv(name);
+   char *end;
+   int64_t size;
+
+   if(value == NULL) {
+      return default_size;
+   }
+   size = strtoll(value, &end, 10);
+   if(end == value || *end != '\0' || size <= 0) {
+      return default_size;
+   }
+   return size;
+}
+
+#ifdef JIT
+/*
+ * Everything a program compiled by L1 refers to in the runtime,
+ * for bin/L1 -r to link the program against.
+ */
+typedef struct {
+   const char *name;
+   void *address;
+} runtime_symbol_t;
+
+runtime_symbol_t runtime_symbols[] = {
+   {"allocate", allocate},
+   {"allocate_site", allocate_site},
+   {"print", print},
+   {"array_error", array_error},
+   {"alloc_ptr", &alloc_ptr},
+   {"alloc_limit", &alloc_limit},
+   {"alloc_starts_base", &alloc_starts_base},
+   {"gc_cards", &gc_cards},
+   {"gc_cards_low", &gc_cards_low},
+   {"gc_cards_span", &gc_cards_span},
+   {"gc_barrier_scratch", &gc_barrier_scratch},
+   {NULL, NULL}
+};
+#endif
+
 /*
  * Program entry-point
  */
 int main() {
-   int b1 = alloc_heap(&heap);
-   int b2 = alloc_heap(&heap2);
-   if(!b1 || !b2) {
+   int64_t heap_size = heap_size_from_env("HEAP_SIZE", DEFAULT_HEAP_SIZE);
+   int64_t nursery_size = heap_size_from_env("NURSERY_SIZE", DEFAULT_NURSERY_SIZE);
+   if(nursery_size > heap_size) {
+      nursery_size = heap_size;
+   }
+   heap_max_size = heap_size_from_env("HEAP_MAX_SIZE", 0);
+   if(heap_max_size > 0 && heap_max_size < heap_size) {
+      heap_max_size = heap_size;
+   }
+
+   atexit(output_flush);
+
+   char *stats = getenv("GC_STATS");
+   if(stats != NULL && strcmp(stats, "0") != 0) {
+      gc_stats.enabled = 1;
+      atexit(gc_stats_report);
+   }
+
+   char *huge_pages = getenv("HEAP_HUGE_PAGES");
+   heap_huge_pages = (huge_pages != NULL && strcmp(huge_pages, "0") != 0);
+
+   gc_threads = heap_size_from_env("GC_THREADS", 1);
+   if(gc_threads > GC_MAX_THREADS) {
+      gc_threads = GC_MAX_THREADS;
+   }
+   if(gc_threads > 1 && !gc_parallel_init()) {
+      gc_threads = 1;
+   }
+
+   int b0 = alloc_heap(&nursery, nursery_size, nursery_size);
+   int b1 = alloc_heap(&heap, heap_size, semispace_capacity(heap_size));
+   int b2 = alloc_heap(&heap2, heap_size, semispace_capacity(heap_size));
+   if(!b0 || !b1 || !b2) {
+      output_flush();
       printf("malloc failed\n");
       exit(-1);
    }
+   store_alloc_ptr();
+   cards_reset();
+   large_words_limit = heap_size;
 
    // Move esp into the bottom-of-stack pointer.
    // The "go" function's boilerplate, in conjunction
@@ -443,7 +1930,7 @@ int main() {
         "movq $1, %%rbx;"
         "movq $3, %%rdi;"
         "movq $5, %%rsi;"
-        "call go;"
+        CALL_GO
       : "=m"(stack) // outputs
       :             // inputs (none)
       : "%rax", "%rbx", "%rdi", "%rsi" // clobbered registers (eax)
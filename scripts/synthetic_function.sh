@@ -0,0 +1,45 @@
+#!/bin/bash
+
+# Prints a program whose main function is N instructions long, for
+# timing the compilers. It only uses registers and (mem rsp 0), so it
+# is valid L1 and L2 alike: blocks of about 50 instructions covering
+# every instruction kind, each one ending in a cjump or goto to the
+# next. That includes calls to a one-instruction :f (with the return
+# label stored first) and to print and allocate with their arguments
+# set up.
+
+if test $# -lt 1 ; then
+  echo "USAGE: `basename $0` N" ;
+  exit 1;
+fi
+
+awk -v n=$1 'BEGIN {
+  split("(rdi <- 5)|(rsi <- rdi)|(rdi += rsi)|(rdi -= 3)|(rdi *= rsi)|(rdi &= 7)|(rdx <- (mem rsp 0))|((mem rsp 0) <- rdi)|((mem rsp 0) += rsi)|(rsi -= (mem rsp 0))|(rcx <- 1)|(rdi <<= rcx)|(rdi >>= 1)|(rax <- rdi < rsi)|(rax <- rdi <= 9)|(rax <- rsi = rdi)|(r8 @ rdi rsi 4)|(r9 <- r8)|((mem rsp -8) <- :RET)~(call :f 0)~:RET|(rdi <- rax)~(call print 1)|(rdi <- 5)~(rsi <- 1)~(call allocate 2)", body, "|");
+  kinds = length(body);
+  print "(:go\n  (:go\n    0 1";
+  block = 0;
+  for (i = 0; i < n - 2; ) {
+    print "    :block_" block;
+    i++;
+    # calls take several instructions, each with its own return label
+    j = 0;
+    for (k = 0; k < 48 && i < n - 3; j++) {
+      m = split(body[(block + j) % kinds + 1], kind, "~");
+      for (l = 1; l <= m; l++) {
+        gsub(/RET/, "ret_" block "_" j, kind[l]);
+        print "    " kind[l];
+      }
+      k += m;
+      i += m;
+    }
+    if (block % 2)
+      print "    (cjump rdi < rsi :block_" block + 1 " :block_" block + 1 ")";
+    else
+      print "    (goto :block_" block + 1 ")";
+    i++;
+    block++;
+  }
+  print "    :block_" block;
+  print "    (return))";
+  print "  (:f\n    0 0\n    (return)))";
+}'